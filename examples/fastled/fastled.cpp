@@ -12,40 +12,31 @@
 using namespace esphomelib;
 
 /// Custom FastLED effect - Note: this will only work with FastLED lights
-class CustomLightEffect : public light::LightEffect {
+class CustomLightEffect : public light::BaseFastLEDLightEffect {
  public:
-  static std::unique_ptr<light::LightEffect> create() { return make_unique<CustomLightEffect>(); }
+  static std::unique_ptr<light::LightEffect> create() {
+    auto effect = make_unique<CustomLightEffect>();
+    // Render a new frame every 20ms (50 FPS).
+    effect->set_update_interval(20);
+    return std::move(effect);
+  }
 
   std::string get_name() const override { return "Custom Rainbow Effect"; }
 
-  void apply_effect(light::LightState *state) override {
-    auto *output = (light::FastLEDLightOutputComponent *) state->get_output();
-    uint8_t hue = millis() / 20;
+ protected:
+  // Render a single frame into the LED buffer. The base class makes sure this is only called
+  // once per update interval, prevents normal light set calls (like setting color manually) from
+  // affecting the LED array and makes the output show the frame.
+  void render_(light::BaseFastLEDLightOutput *output, light::LightState *state, uint32_t now) override {
+    uint8_t hue = now / 20;
     fill_rainbow(output->get_leds(), output->get_num_leds(), hue, 7);
-
-    // make the output show the effect
-    output->schedule_show();
-  }
-
-  // Prevent any normal light set calls (like setting color manually) affecting our LED array
-  // while this effect is active. Otherwise, when choosing a color from the front-end while
-  // this effect is active, all LEDS would briefly go to the new color but then right back due
-  // to this effect
-  void initialize(light::LightState *state) override {
-    auto *output = (light::FastLEDLightOutputComponent *) state->get_output();
-    output->prevent_writing_leds();
-  }
-  // Tell the light output to respond to normal requests again.
-  void stop(light::LightState *state) override {
-    auto *output = (light::FastLEDLightOutputComponent *) state->get_output();
-    output->unprevent_writing_leds();
   }
 };
 
 // Make an effect entry so that esphomelib can know about it.
 // Note that you need to register it too (see setup())
 light::LightEffect::Entry custom_light_entry = {
-    .name = "Rainbow Effect",
+    .name = "Custom Rainbow Effect",
     // This effect requires the Brightness and RGB traits and must be used with FastLED
     .requirements = light::LightTraits(true, true, false, true),
     .constructor = CustomLightEffect::create
@@ -62,6 +53,11 @@ void setup() {
   auto fast_led = App.make_fast_led_light("Fast LED Light");
   // 60 NEOPIXEL LEDS on pin GPIO23
   fast_led.fast_led->add_leds<NEOPIXEL, 23>(60);
+  // Another 30 NEOPIXEL LEDS on pin GPIO22, both strips are updated together in one show.
+  fast_led.fast_led->add_leds<NEOPIXEL, 22>(30);
+  // Expose the second strip (LEDs 60 to 89) as a separate light. The segment owns these LEDs,
+  // so "Fast LED Light" now only sets the color of the first strip (LEDs 0 to 59).
+  App.make_fast_led_light_segment("Fast LED Light Strip 2", fast_led.fast_led, 60, 30);
 
   // Register our custom effect
   light::light_effect_entries.push_back(custom_light_entry);
@@ -43,6 +43,8 @@ static const char *TAG = "application";
 void Application::setup() {
   ESP_LOGI(TAG, "Application::setup()");
   assert(this->application_state_ == Component::CONSTRUCTION && "setup() called twice.");
+  // The preferences are opened by set_name(), usually before the logger exists.
+  global_preferences.dump_config();
   ESP_LOGV(TAG, "Sorting components by setup priority...");
   std::stable_sort(this->components_.begin(), this->components_.end(), [](const Component *a, const Component *b) {
     return a->get_setup_priority() > b->get_setup_priority();
@@ -73,6 +75,8 @@ void Application::loop() {
     if (!component->is_failed())
       component->loop_();
   }
+  global_preferences.loop();
+  global_automation_scheduler.loop();
   yield();
 
   if (first_loop)
@@ -649,6 +653,12 @@ ESP32BLETracker *Application::make_esp32_ble_tracker() {
 }
 #endif
 
+#ifdef USE_IR_RECEIVER
+IRReceiverComponent *Application::make_ir_receiver(const GPIOInputPin &pin) {
+  return this->register_component(new IRReceiverComponent(pin.copy()));
+}
+#endif
+
 #ifdef USE_FAST_LED_LIGHT
 Application::MakeFastLEDLight Application::make_fast_led_light(const std::string &name) {
   auto *fast_led = this->register_component(new FastLEDLightOutputComponent());
@@ -660,6 +670,19 @@ Application::MakeFastLEDLight Application::make_fast_led_light(const std::string
       .mqtt = make.mqtt,
   };
 }
+
+Application::MakeFastLEDLightSegment Application::make_fast_led_light_segment(const std::string &name,
+                                                                              FastLEDLightOutputComponent *parent,
+                                                                              int offset, int num_leds) {
+  auto *segment = new FastLEDLightSegment(parent, offset, num_leds);
+  auto make = this->make_light_for_light_output(name, segment);
+
+  return MakeFastLEDLightSegment{
+      .segment = segment,
+      .state = make.state,
+      .mqtt = make.mqtt,
+  };
+}
 #endif
 
 #ifdef USE_DHT12_SENSOR
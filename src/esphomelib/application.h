@@ -13,6 +13,7 @@
 #include "esphomelib/esp32_ble_tracker.h"
 #include "esphomelib/debug_component.h"
 #include "esphomelib/deep_sleep_component.h"
+#include "esphomelib/ir_receiver_component.h"
 #include "esphomelib/log.h"
 #include "esphomelib/log_component.h"
 #include "esphomelib/power_supply_component.h"
@@ -31,6 +32,7 @@
 #include "esphomelib/fan/mqtt_fan_component.h"
 #include "esphomelib/i2c_component.h"
 #include "esphomelib/io/pcf8574_component.h"
+#include "esphomelib/light/fast_led_light_effect.h"
 #include "esphomelib/light/fast_led_light_output.h"
 #include "esphomelib/light/light_output_component.h"
 #include "esphomelib/light/mqtt_json_light_component.h"
@@ -174,6 +176,17 @@ class Application {
   ESP32BLETracker *make_esp32_ble_tracker();
 #endif
 
+#ifdef USE_IR_RECEIVER
+  /** Create an IR receiver that decodes NEC, LG, Sony and Panasonic codes.
+   *
+   * Use make_trigger() on the return value to run automations when a code is received.
+   *
+   * @param pin The pin the output of the IR receiver module is connected to.
+   * @return The IRReceiverComponent, use this for advanced settings.
+   */
+  IRReceiverComponent *make_ir_receiver(const GPIOInputPin &pin);
+#endif
+
 
 
 
@@ -805,6 +818,27 @@ class Application {
 
   /// Create an FastLED light.
   MakeFastLEDLight make_fast_led_light(const std::string &name);
+
+  struct MakeFastLEDLightSegment {
+    light::FastLEDLightSegment *segment;
+    light::LightState *state;
+    light::MQTTJSONLightComponent *mqtt;
+  };
+
+  /** Create a light for a segment of the LEDs of a FastLED light.
+   *
+   * All segments share the frame buffer of the parent FastLED light, which flushes all its strips
+   * together in one synchronized show.
+   *
+   * @param name The name the light should be advertised as. Leave empty for no automatic discovery.
+   * @param parent The FastLED light output whose LEDs this segment should control.
+   * @param offset The index of the first LED of this segment in the parent's frame buffer.
+   * @param num_leds The number of LEDs in this segment.
+   * @return The components for this segment light. Use this for advanced settings.
+   */
+  MakeFastLEDLightSegment make_fast_led_light_segment(const std::string &name,
+                                                      light::FastLEDLightOutputComponent *parent,
+                                                      int offset, int num_leds);
 #endif
 
 
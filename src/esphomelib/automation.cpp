@@ -8,11 +8,13 @@
 
 #include "esphomelib/automation.h"
 
+#include <algorithm>
+
 ESPHOMELIB_NAMESPACE_BEGIN
 
 static const char *TAG = "automation";
 
-void Trigger<NoArg>::add_on_trigger_callback(std::function<void(NoArg)> &&f) {
+void Trigger<NoArg>::add_on_trigger_callback(InlineFunction<void(NoArg)> &&f) {
   this->on_trigger_.add(std::move(f));
 }
 void Trigger<NoArg>::trigger() {
@@ -63,5 +65,46 @@ void RangeCondition::set_max(float max) {
   this->max_ = max;
 }
 
+void ScheduledAction::log_dropped_trigger_(const char *reason) {
+  ESP_LOGW(TAG, "%s, dropping trigger!", reason);
+}
+void ScheduledAction::log_scheduler_full_() {
+  ESP_LOGE(TAG, "Automation scheduler is full!");
+}
+
+void AutomationScheduler::reserve(size_t count) {
+  this->capacity_ += count;
+  this->waits_.reserve(this->capacity_);
+}
+bool AutomationScheduler::schedule(ScheduledAction *action, uint8_t slot, uint32_t delay) {
+  if (this->waits_.size() >= this->capacity_)
+    return false;
+  this->waits_.push_back(Wait{action, millis(), delay, slot});
+  return true;
+}
+void AutomationScheduler::cancel(ScheduledAction *action) {
+  this->waits_.erase(std::remove_if(this->waits_.begin(), this->waits_.end(), [action](const Wait &wait) {
+    return wait.action == action;
+  }), this->waits_.end());
+}
+void AutomationScheduler::loop() {
+  // Resumed actions can park new waits (even with a delay of 0) or cancel others, so look for due waits
+  // again after every resume, but at most as many times as there were waits to begin with.
+  for (size_t remaining = this->waits_.size(); remaining > 0; remaining--) {
+    const uint32_t now = millis();
+    auto it = std::find_if(this->waits_.begin(), this->waits_.end(), [now](const Wait &wait) {
+      return now - wait.start >= wait.delay;
+    });
+    if (it == this->waits_.end())
+      return;
+    const Wait wait = *it;
+    *it = this->waits_.back();
+    this->waits_.pop_back();
+    wait.action->resume_(wait.slot);
+  }
+}
+
+AutomationScheduler global_automation_scheduler;
+
 ESPHOMELIB_NAMESPACE_END
 
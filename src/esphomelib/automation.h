@@ -12,6 +12,8 @@
 #include <vector>
 #include "esphomelib/component.h"
 #include "esphomelib/helpers.h"
+#include "esphomelib/inline_function.h"
+#include "esphomelib/log.h"
 #include "esphomelib/defines.h"
 
 ESPHOMELIB_NAMESPACE_BEGIN
@@ -45,10 +47,10 @@ class OrCondition : public Condition<T> {
 template<typename T>
 class LambdaCondition : public Condition<T> {
  public:
-  explicit LambdaCondition(std::function<bool(T)> &&f);
+  explicit LambdaCondition(InlineFunction<bool(T)> &&f);
   bool check(T x) override;
  protected:
-  std::function<bool(T)> f_;
+  InlineFunction<bool(T)> f_;
 };
 
 class RangeCondition : public Condition<float> {
@@ -69,7 +71,7 @@ class RangeCondition : public Condition<float> {
 template<typename T>
 class Trigger {
  public:
-  void add_on_trigger_callback(std::function<void(T)> &&f);
+  void add_on_trigger_callback(InlineFunction<void(T)> &&f);
   void trigger(T x);
  protected:
   CallbackManager<void(T)> on_trigger_;
@@ -78,7 +80,7 @@ class Trigger {
 template<>
 class Trigger<NoArg> {
  public:
-  void add_on_trigger_callback(std::function<void(NoArg)> &&f);
+  void add_on_trigger_callback(InlineFunction<void(NoArg)> &&f);
   void trigger();
  protected:
   CallbackManager<void(NoArg)> on_trigger_;
@@ -105,46 +107,149 @@ class ActionList;
 template<typename T>
 class Action {
  public:
-  virtual void play(T x) = 0;
-  void play_next(T x);
+  /** Run this action.
+   *
+   * @param x The value of the trigger.
+   * @return Whether the next action of the list should be run right away. Actions that continue the
+   *         list later on (like DelayAction) return false.
+   */
+  virtual bool play(T x) = 0;
+
  protected:
   friend ActionList<T>;
 
-  Action<T> *next_ = nullptr;
+  /// The list this action is part of, set by ActionList::add_action().
+  ActionList<T> *parent_{nullptr};
+  /// The index of this action in the parent list.
+  uint16_t index_{0};
+};
+
+/// Interface for actions that park a wait in the AutomationScheduler.
+class ScheduledAction {
+ protected:
+  friend class AutomationScheduler;
+
+  /// Called by the scheduler once the wait for the given slot is over.
+  virtual void resume_(uint8_t slot) = 0;
+
+  /// Log that a trigger was dropped because of reason, under the TAG of automation.cpp.
+  static void log_dropped_trigger_(const char *reason);
+  /// Log that a wait couldn't be parked because all reserved scheduler entries are in use.
+  static void log_scheduler_full_();
+};
+
+/** Shared wait queue for the delays of all automations.
+ *
+ * Pending delays are parked here as small fixed-size entries instead of each DelayAction queueing its own
+ * Component timeouts. The capacity is reserved while the automations are created, so triggering a delay
+ * never allocates. Like global_preferences, the scheduler is run from Application::loop().
+ */
+class AutomationScheduler {
+ public:
+  /// Reserve room for count more simultaneous waits. Only call this while setting up automations.
+  void reserve(size_t count);
+  /// Park a wait of delay ms for slot of action, returns false if all reserved entries are in use.
+  bool schedule(ScheduledAction *action, uint8_t slot, uint32_t delay);
+  /// Remove all waits of the action.
+  void cancel(ScheduledAction *action);
+  /// Resume all actions whose wait is over.
+  void loop();
+
+ protected:
+  struct Wait {
+    ScheduledAction *action;
+    uint32_t start;
+    uint32_t delay;
+    uint8_t slot;
+  };
+
+  std::vector<Wait> waits_;
+  size_t capacity_{0};
 };
 
+extern AutomationScheduler global_automation_scheduler;
+
+/// What a DelayAction does when it's triggered again while it's still waiting.
+enum DelayMode {
+  /// Start another wait alongside the running ones, up to max_pending at a time. Further triggers are dropped.
+  DELAY_MODE_PARALLEL = 0,
+  /// Cancel the running wait and start over with the new value.
+  DELAY_MODE_RESTART,
+  /// Wait again once the running wait is over, up to max_pending waits including the running one.
+  /// Further triggers are dropped.
+  DELAY_MODE_QUEUE,
+};
+
+/// The maximum number of pending waits of a single DelayAction.
+const uint8_t DELAY_ACTION_MAX_PENDING = 16;
+
+/** Action that continues the list after a delay.
+ *
+ * The waits are run by global_automation_scheduler, the Component base doesn't do anything in setup() or
+ * loop(). It's kept so that the action can still be registered with App.register_component() like before.
+ */
 template<typename T>
-class DelayAction : public Action<T>, public Component {
+class DelayAction : public Action<T>, public ScheduledAction, public Component {
  public:
   explicit DelayAction();
 
   void set_delay(std::function<uint32_t(T)> &&delay);
   void set_delay(uint32_t delay);
 
-  void play(T x) override;
+  /** Set what happens when this delay is triggered again while it's still waiting.
+   *
+   * Defaults to DELAY_MODE_PARALLEL with up to 4 waits. The storage for the pending values is allocated
+   * here, so call this while setting up the automation.
+   *
+   * @param mode The re-trigger policy.
+   * @param max_pending The maximum number of pending waits (at most 16), ignored for DELAY_MODE_RESTART.
+   */
+  void set_mode(DelayMode mode, uint8_t max_pending = 4);
+
+  bool play(T x) override;
+
  protected:
+  void resume_(uint8_t slot) override;
+  void schedule_(uint8_t slot);
+
   TemplatableValue<uint32_t, T> delay_{0};
+  DelayMode mode_{DELAY_MODE_PARALLEL};
+  /// The trigger values of the pending waits, one per slot.
+  std::vector<T> values_;
+  /// Which slots are in use (parallel and restart mode).
+  uint16_t used_{0};
+  /// The slots form a ring buffer in queue mode, the first one is the running wait.
+  uint8_t queue_head_{0};
+  uint8_t queue_size_{0};
+  /// The number of scheduler entries reserved by this action.
+  uint8_t reserved_{0};
 };
 
 template<typename T>
 class LambdaAction : public Action<T> {
  public:
-  explicit LambdaAction(std::function<void(T)> &&f);
-  void play(T x) override;
+  explicit LambdaAction(InlineFunction<void(T)> &&f);
+  bool play(T x) override;
  protected:
-  std::function<void(T)> f_;
+  InlineFunction<void(T)> f_;
 };
 
+/** A list of actions that's run by a small interpreter.
+ *
+ * The actions are stored in a flat array and run one after another until an action returns false.
+ * Actions that suspend the list (like DelayAction) continue it later with play_from().
+ */
 template<typename T>
 class ActionList {
  public:
   Action<T> *add_action(Action<T> *action);
   void add_actions(const std::vector<Action<T> *> &actions);
   void play(T x);
+  /// Run the actions starting at index until one of them suspends the list.
+  void play_from(uint16_t index, T x);
 
  protected:
-  Action<T> *actions_begin_{nullptr};
-  Action<T> *actions_end_{nullptr};
+  std::vector<Action<T> *> actions_;
 };
 
 template<typename T>
@@ -202,7 +307,7 @@ OrCondition<T>::OrCondition(const std::vector<Condition<T> *> &conditions)
 }
 
 template<typename T>
-void Trigger<T>::add_on_trigger_callback(std::function<void(T)> &&f) {
+void Trigger<T>::add_on_trigger_callback(InlineFunction<void(T)> &&f) {
   this->on_trigger_.add(std::move(f));
 }
 
@@ -212,19 +317,69 @@ void Trigger<T>::trigger(T x) {
 }
 
 template<typename T>
-void Action<T>::play_next(T x) {
-  if (this->next_ != nullptr)
-    this->next_->play(x);
+DelayAction<T>::DelayAction() {
+  this->set_mode(DELAY_MODE_PARALLEL);
 }
 
 template<typename T>
-DelayAction<T>::DelayAction() = default;
+bool DelayAction<T>::play(T x) {
+  switch (this->mode_) {
+    case DELAY_MODE_PARALLEL: {
+      uint8_t slot = 0;
+      while (slot < this->values_.size() && (this->used_ & (1u << slot)))
+        slot++;
+      if (slot == this->values_.size()) {
+        this->log_dropped_trigger_("Too many pending delays");
+        break;
+      }
+      this->values_[slot] = x;
+      this->used_ |= 1u << slot;
+      this->schedule_(slot);
+      break;
+    }
+    case DELAY_MODE_RESTART:
+      global_automation_scheduler.cancel(this);
+      this->values_[0] = x;
+      this->used_ = 1;
+      this->schedule_(0);
+      break;
+    case DELAY_MODE_QUEUE: {
+      if (this->queue_size_ == this->values_.size()) {
+        this->log_dropped_trigger_("Delay queue is full");
+        break;
+      }
+      const uint8_t slot = (this->queue_head_ + this->queue_size_) % this->values_.size();
+      this->values_[slot] = x;
+      this->queue_size_++;
+      if (this->queue_size_ == 1)
+        this->schedule_(slot);
+      break;
+    }
+  }
+  // The rest of the list is played once the wait is over.
+  return false;
+}
+template<typename T>
+void DelayAction<T>::resume_(uint8_t slot) {
+  T x = this->values_[slot];
+  if (this->mode_ == DELAY_MODE_QUEUE) {
+    this->queue_head_ = (this->queue_head_ + 1) % this->values_.size();
+    this->queue_size_--;
+    if (this->queue_size_ > 0)
+      this->schedule_(this->queue_head_);
+  } else {
+    this->used_ &= ~(1u << slot);
+  }
 
+  if (this->parent_ != nullptr)
+    this->parent_->play_from(this->index_ + 1, x);
+}
 template<typename T>
-void DelayAction<T>::play(T x) {
-  this->set_timeout(this->delay_.value(x), [this, x](){
-    this->play_next(x);
-  });
+void DelayAction<T>::schedule_(uint8_t slot) {
+  if (!global_automation_scheduler.schedule(this, slot, this->delay_.value(this->values_[slot]))) {
+    this->log_scheduler_full_();
+    this->used_ &= ~(1u << slot);
+  }
 }
 template<typename T>
 void DelayAction<T>::set_delay(std::function<uint32_t(T)> &&delay) {
@@ -234,6 +389,24 @@ template<typename T>
 void DelayAction<T>::set_delay(uint32_t delay) {
   this->delay_ = delay;
 }
+template<typename T>
+void DelayAction<T>::set_mode(DelayMode mode, uint8_t max_pending) {
+  this->mode_ = mode;
+  if (mode == DELAY_MODE_RESTART)
+    max_pending = 1;
+  max_pending = clamp<uint8_t>(1, DELAY_ACTION_MAX_PENDING, max_pending);
+  this->values_.resize(max_pending);
+  this->used_ = 0;
+  this->queue_head_ = 0;
+  this->queue_size_ = 0;
+
+  // In queue mode, only the first value is waited for at a time.
+  const uint8_t entries = mode == DELAY_MODE_QUEUE ? 1 : max_pending;
+  if (entries > this->reserved_) {
+    global_automation_scheduler.reserve(entries - this->reserved_);
+    this->reserved_ = entries;
+  }
+}
 
 template<typename T>
 Condition<T> *Automation<T>::add_condition(Condition<T> *condition) {
@@ -254,7 +427,7 @@ Automation<T>::Automation(Trigger<T> *trigger) : trigger_(trigger) {
 }
 template<typename T>
 Action<T> *Automation<T>::add_action(Action<T> *action) {
-  this->actions_.add_action(action);
+  return this->actions_.add_action(action);
 }
 template<typename T>
 void Automation<T>::add_actions(const std::vector<Action<T> *> &actions) {
@@ -270,7 +443,7 @@ void Automation<T>::process_trigger_(T x) {
   this->actions_.play(x);
 }
 template<typename T>
-LambdaCondition<T>::LambdaCondition(std::function<bool(T)> &&f)
+LambdaCondition<T>::LambdaCondition(InlineFunction<bool(T)> &&f)
     : f_(std::move(f)) {
 
 }
@@ -280,21 +453,19 @@ bool LambdaCondition<T>::check(T x) {
 }
 
 template<typename T>
-LambdaAction<T>::LambdaAction(std::function<void(T)> &&f) : f_(std::move(f)) {}
+LambdaAction<T>::LambdaAction(InlineFunction<void(T)> &&f) : f_(std::move(f)) {}
 template<typename T>
-void LambdaAction<T>::play(T x) {
+bool LambdaAction<T>::play(T x) {
   this->f_(x);
-  this->play_next(x);
+  return true;
 }
 
 template<typename T>
 Action<T> *ActionList<T>::add_action(Action<T> *action) {
-  if (this->actions_end_ == nullptr) {
-    this->actions_begin_ = action;
-  } else {
-    this->actions_end_->next_ = action;
-  }
-  return this->actions_end_ = action;
+  action->parent_ = this;
+  action->index_ = this->actions_.size();
+  this->actions_.push_back(action);
+  return action;
 }
 template<typename T>
 void ActionList<T>::add_actions(const std::vector<Action<T> *> &actions) {
@@ -304,8 +475,14 @@ void ActionList<T>::add_actions(const std::vector<Action<T> *> &actions) {
 }
 template<typename T>
 void ActionList<T>::play(T x) {
-  if (this->actions_begin_ != nullptr)
-    this->actions_begin_->play(x);
+  this->play_from(0, x);
+}
+template<typename T>
+void ActionList<T>::play_from(uint16_t index, T x) {
+  for (; index < this->actions_.size(); index++) {
+    if (!this->actions_[index]->play(x))
+      return;
+  }
 }
 
 ESPHOMELIB_NAMESPACE_END
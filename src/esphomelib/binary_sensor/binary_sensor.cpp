@@ -4,6 +4,7 @@
 
 #include "esphomelib/binary_sensor/binary_sensor.h"
 #include "esphomelib/log.h"
+#include "esphomelib/rtc_memory.h"
 
 #ifdef USE_BINARY_SENSOR
 
@@ -19,6 +20,17 @@ void BinarySensor::add_on_state_callback(binary_callback_t &&callback) {
 
 void BinarySensor::publish_state(bool state) {
   bool actual = state != this->inverted_;
+  if (this->first_value_) {
+    // There's only a state to save once the first one is published.
+    if (global_rtc_memory.are_snapshots_enabled()) {
+      global_rtc_memory.add_on_snapshot_callback([this]() {
+        global_rtc_memory.save(this->get_name(), "state", this->value);
+      });
+    }
+    // Don't re-publish (and re-trigger automations for) the state from before deep sleep.
+    if (global_rtc_memory.is_deep_sleep_wakeup() && global_rtc_memory.restore(this->get_name(), "state", &this->value))
+      this->first_value_ = false;
+  }
   if (!this->first_value_ && actual == this->value)
     return;
   this->first_value_ = false;
@@ -34,7 +46,9 @@ void BinarySensor::set_inverted(bool inverted) {
 std::string BinarySensor::device_class() {
   return "";
 }
-BinarySensor::BinarySensor(const std::string &name) : Nameable(name) {}
+BinarySensor::BinarySensor(const std::string &name) : Nameable(name) {
+
+}
 bool BinarySensor::get_value() const {
   return this->value;
 }
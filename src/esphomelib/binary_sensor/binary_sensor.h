@@ -17,7 +17,7 @@ ESPHOMELIB_NAMESPACE_BEGIN
 namespace binary_sensor {
 
 /// typedef for binary_sensor callbacks. First parameter is new value.
-using binary_callback_t = std::function<void(bool)>;
+using binary_callback_t = InlineFunction<void(bool)>;
 
 class PressTrigger;
 class ReleaseTrigger;
@@ -43,7 +43,7 @@ void Component::set_interval(const std::string &name, uint32_t interval, time_fu
       .f = std::move(f),
       .remove = false,
   };
-  this->time_functions_.push_back(function);
+  this->time_functions_.push_back(std::move(function));
 }
 
 bool Component::cancel_interval(const std::string &name) {
@@ -62,7 +62,7 @@ void Component::set_timeout(const std::string &name, uint32_t timeout, time_func
       .f = std::move(f),
       .remove = false,
   };
-  this->time_functions_.push_back(function);
+  this->time_functions_.push_back(std::move(function));
 }
 
 bool Component::cancel_timeout(const std::string &name) {
@@ -107,13 +107,15 @@ void Component::loop_internal() {
                   type, tf->name.c_str(), i, tf->interval, tf->last_execution, now);
       }
 
-      tf->f();
-      // The vector might have reallocated due to new items
+      // The function may add time functions, which can reallocate the vector (and move the function) while it runs.
+      time_func_t f = std::move(tf->f);
+      f();
       tf = &this->time_functions_[i];
 
       if (tf->type == TimeFunction::INTERVAL) {
         const uint32_t amount = (now - tf->last_execution) / tf->interval;
         tf->last_execution += (amount * tf->interval);
+        tf->f = std::move(f);
       } else if (tf->type == TimeFunction::DEFER || tf->type == TimeFunction::TIMEOUT) {
         tf->remove = true;
       }
@@ -152,7 +154,7 @@ void Component::defer(const std::string &name, Component::time_func_t &&f) {
       .f = std::move(f),
       .remove = false,
   };
-  this->time_functions_.push_back(function);
+  this->time_functions_.push_back(std::move(function));
 }
 void Component::set_timeout(uint32_t timeout, Component::time_func_t &&f) {
   this->set_timeout("", timeout, std::move(f));
@@ -5,10 +5,13 @@
 #ifndef ESPHOMELIB_COMPONENT_H
 #define ESPHOMELIB_COMPONENT_H
 
+#include <cstdint>
 #include <functional>
 #include <map>
+#include <string>
 #include <vector>
 #include "esphomelib/defines.h"
+#include "esphomelib/inline_function.h"
 
 #define assert_setup(t) assert((t)->get_component_state() == esphomelib::Component::SETUP || (t)->get_component_state() == esphomelib::Component::LOOP)
 #define assert_construction_state(t) assert((t)->get_component_state() == esphomelib::Component::CONSTRUCTION)
@@ -117,7 +120,7 @@ class Component {
    * @see set_interval()
    * @see set_timeout()
    */
-  using time_func_t = std::function<void()>;
+  using time_func_t = InlineFunction<void()>;
 
   void set_interval(uint32_t interval, time_func_t &&f);
 
@@ -15,7 +15,7 @@ ESPHOMELIB_NAMESPACE_BEGIN
 namespace cover {
 
 Cover::Cover(const std::string &name) : Nameable(name) {}
-void Cover::add_on_publish_state_callback(std::function<void(CoverState)> &&f) {
+void Cover::add_on_publish_state_callback(InlineFunction<void(CoverState)> &&f) {
   this->state_callback_.add(std::move(f));
 }
 void Cover::publish_state(CoverState state) {
@@ -41,7 +41,7 @@ class Cover : public Nameable {
   virtual void close() = 0;
   virtual void stop() = 0;
 
-  void add_on_publish_state_callback(std::function<void(CoverState)> &&f);
+  void add_on_publish_state_callback(InlineFunction<void(CoverState)> &&f);
 
   void publish_state(CoverState state);
 
@@ -72,7 +72,7 @@ class OpenAction : public Action<T> {
  public:
   explicit OpenAction(Cover *cover);
 
-  void play(T x) override;
+  bool play(T x) override;
 
  protected:
   Cover *cover_;
@@ -83,7 +83,7 @@ class CloseAction : public Action<T> {
  public:
   explicit CloseAction(Cover *cover);
 
-  void play(T x) override;
+  bool play(T x) override;
 
  protected:
   Cover *cover_;
@@ -94,7 +94,7 @@ class StopAction : public Action<T> {
  public:
   explicit StopAction(Cover *cover);
 
-  void play(T x) override;
+  bool play(T x) override;
 
  protected:
   Cover *cover_;
@@ -108,9 +108,9 @@ OpenAction<T>::OpenAction(Cover *cover)
 
 }
 template<typename T>
-void OpenAction<T>::play(T x) {
+bool OpenAction<T>::play(T x) {
   this->cover_->open();
-  this->play_next(x);
+  return true;
 }
 
 template<typename T>
@@ -119,9 +119,9 @@ CloseAction<T>::CloseAction(Cover *cover)
 
 }
 template<typename T>
-void CloseAction<T>::play(T x) {
+bool CloseAction<T>::play(T x) {
   this->cover_->close();
-  this->play_next(x);
+  return true;
 }
 
 template<typename T>
@@ -131,9 +131,9 @@ StopAction<T>::StopAction(Cover *cover)
 }
 
 template<typename T>
-void StopAction<T>::play(T x) {
+bool StopAction<T>::play(T x) {
   this->cover_->stop();
-  this->play_next(x);
+  return true;
 }
 
 template<typename T>
@@ -0,0 +1,80 @@
+//
+//  crc.cpp
+//  esphomelib
+//
+//  Copyright © 2018 Otto Winter. All rights reserved.
+//
+
+#include "esphomelib/crc.h"
+
+#ifdef ARDUINO
+  #include "esphomelib/esphal.h"
+#else
+  #define PROGMEM
+  #define pgm_read_byte(addr) (*reinterpret_cast<const uint8_t *>(addr))
+  #define pgm_read_word(addr) (*reinterpret_cast<const uint16_t *>(addr))
+  #define pgm_read_dword(addr) (*reinterpret_cast<const uint32_t *>(addr))
+#endif
+#ifdef ARDUINO_ARCH_ESP32
+  #include <rom/crc.h>
+#endif
+
+ESPHOMELIB_NAMESPACE_BEGIN
+
+// Each table holds the CRC of the nibble i shifted through the polynomial (4 bit steps).
+static const uint8_t CRC8_DALLAS_TABLE[16] PROGMEM = {
+    0x00, 0x9D, 0x23, 0xBE, 0x46, 0xDB, 0x65, 0xF8, 0x8C, 0x11, 0xAF, 0x32, 0xCA, 0x57, 0xE9, 0x74,
+};
+static const uint8_t CRC8_SENSIRION_TABLE[16] PROGMEM = {
+    0x00, 0x31, 0x62, 0x53, 0xC4, 0xF5, 0xA6, 0x97, 0xB9, 0x88, 0xDB, 0xEA, 0x7D, 0x4C, 0x1F, 0x2E,
+};
+static const uint16_t CRC16_TABLE[16] PROGMEM = {
+    0x0000, 0xCC01, 0xD801, 0x1400, 0xF001, 0x3C00, 0x2800, 0xE401,
+    0xA001, 0x6C00, 0x7800, 0xB401, 0x5000, 0x9C01, 0x8801, 0x4400,
+};
+#ifndef ARDUINO_ARCH_ESP32
+static const uint32_t CRC32_TABLE[16] PROGMEM = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+#endif
+
+uint8_t crc8_dallas(const uint8_t *data, size_t len, uint8_t crc) {
+  while (len--) {
+    crc ^= *data++;
+    crc = (crc >> 4) ^ pgm_read_byte(&CRC8_DALLAS_TABLE[crc & 0x0F]);
+    crc = (crc >> 4) ^ pgm_read_byte(&CRC8_DALLAS_TABLE[crc & 0x0F]);
+  }
+  return crc;
+}
+uint8_t crc8_sensirion(const uint8_t *data, size_t len, uint8_t crc) {
+  while (len--) {
+    crc ^= *data++;
+    crc = (crc << 4) ^ pgm_read_byte(&CRC8_SENSIRION_TABLE[crc >> 4]);
+    crc = (crc << 4) ^ pgm_read_byte(&CRC8_SENSIRION_TABLE[crc >> 4]);
+  }
+  return crc;
+}
+uint16_t crc16(const uint8_t *data, size_t len, uint16_t crc) {
+  while (len--) {
+    crc ^= *data++;
+    crc = (crc >> 4) ^ pgm_read_word(&CRC16_TABLE[crc & 0x0F]);
+    crc = (crc >> 4) ^ pgm_read_word(&CRC16_TABLE[crc & 0x0F]);
+  }
+  return crc;
+}
+uint32_t crc32(const uint8_t *data, size_t len, uint32_t crc) {
+#ifdef ARDUINO_ARCH_ESP32
+  return crc32_le(crc, data, len);
+#else
+  crc = ~crc;
+  while (len--) {
+    crc ^= *data++;
+    crc = (crc >> 4) ^ pgm_read_dword(&CRC32_TABLE[crc & 0x0F]);
+    crc = (crc >> 4) ^ pgm_read_dword(&CRC32_TABLE[crc & 0x0F]);
+  }
+  return ~crc;
+#endif
+}
+
+ESPHOMELIB_NAMESPACE_END
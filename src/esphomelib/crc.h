@@ -0,0 +1,48 @@
+//
+//  crc.h
+//  esphomelib
+//
+//  Copyright © 2018 Otto Winter. All rights reserved.
+//
+
+#ifndef ESPHOMELIB_CRC_H
+#define ESPHOMELIB_CRC_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esphomelib/defines.h"
+
+ESPHOMELIB_NAMESPACE_BEGIN
+
+/** Table-driven CRC implementations.
+ *
+ * All of them process one nibble at a time with a 16-entry table in PROGMEM, which is several times
+ * faster than the usual bit-at-a-time loop while keeping the tables tiny (16-64 bytes each).
+ *
+ * Every function takes the CRC of the previous data as last argument so that data can be
+ * checked in multiple chunks.
+ */
+
+/// Calculate the Dallas/Maxim 1-Wire CRC-8 (polynomial 0x31 reflected, init 0x00), used for ROM codes and scratch pads.
+uint8_t crc8_dallas(const uint8_t *data, size_t len, uint8_t crc = 0x00);
+
+/// Calculate the Sensirion CRC-8 (polynomial 0x31, init 0xFF), used by SHT3x, SHT2x, SGP30 and similar sensors.
+uint8_t crc8_sensirion(const uint8_t *data, size_t len, uint8_t crc = 0xFF);
+
+/** Calculate the reflected CRC-16 with polynomial 0x8005.
+ *
+ * Use init 0xFFFF for CRC-16/MODBUS (the default) and 0x0000 for CRC-16/ARC as used by 1-Wire devices.
+ */
+uint16_t crc16(const uint8_t *data, size_t len, uint16_t crc = 0xFFFF);
+
+/** Calculate the standard CRC-32 (IEEE 802.3, as used by zlib).
+ *
+ * Like zlib's crc32(), pass the result of the previous chunk as crc to continue a calculation.
+ * On the ESP32 this uses the table-driven implementation in ROM.
+ */
+uint32_t crc32(const uint8_t *data, size_t len, uint32_t crc = 0);
+
+ESPHOMELIB_NAMESPACE_END
+
+#endif //ESPHOMELIB_CRC_H
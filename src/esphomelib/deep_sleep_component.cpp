@@ -11,6 +11,7 @@
 #include "esphomelib/log.h"
 #include "esphomelib/helpers.h"
 #include "esphomelib/ota_component.h"
+#include "esphomelib/rtc_memory.h"
 
 #ifdef USE_DEEP_SLEEP
 
@@ -18,6 +19,10 @@ ESPHOMELIB_NAMESPACE_BEGIN
 
 static const char *TAG = "deep_sleep";
 
+DeepSleepComponent::DeepSleepComponent() {
+  // Let the other components know that their state should be saved before going to sleep.
+  global_rtc_memory.enable_snapshots();
+}
 void DeepSleepComponent::setup() {
   ESP_LOGCONFIG(TAG, "Setting up Deep Sleep...");
   if (this->sleep_duration_.has_value())
@@ -77,6 +82,9 @@ void DeepSleepComponent::begin_sleep() {
   ESP_LOGI(TAG, "Beginning Deep Sleep");
 
   run_safe_shutdown_hooks("deep-sleep");
+  if (this->sleep_duration_.has_value())
+    global_rtc_memory.set_sleep_duration(*this->sleep_duration_ / 1000);
+  global_rtc_memory.snapshot();
 
 #ifdef ARDUINO_ARCH_ESP32
   if (this->sleep_duration_.has_value())
@@ -42,6 +42,8 @@ enum WakeupPinMode {
  */
 class DeepSleepComponent : public Component {
  public:
+  DeepSleepComponent();
+
   /// Set the duration in ms the component should sleep once it's in deep sleep mode.
   void set_sleep_duration(uint32_t time_ms);
 #ifdef ARDUINO_ARCH_ESP32
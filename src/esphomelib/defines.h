@@ -54,6 +54,7 @@
   #define USE_SWITCH
   #define USE_SIMPLE_SWITCH
   #define USE_IR_TRANSMITTER
+  #define USE_IR_RECEIVER
   #define USE_GPIO_SWITCH
   #define USE_RESTART_SWITCH
   #define USE_SHUTDOWN_SWITCH
@@ -107,6 +108,9 @@
   #ifndef USE_BINARY_SENSOR
     #define USE_BINARY_SENSOR
   #endif
+  #ifndef USE_SENSOR
+    #define USE_SENSOR
+  #endif
 #endif
 #ifdef USE_TEMPLATE_BINARY_SENSOR
   #ifndef USE_BINARY_SENSOR
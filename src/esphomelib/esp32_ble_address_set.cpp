@@ -0,0 +1,80 @@
+//
+//  esp32_ble_address_set.cpp
+//  esphomelib
+//
+//  Copyright © 2018 Otto Winter. All rights reserved.
+//
+
+#include "esphomelib/esp32_ble_address_set.h"
+
+ESPHOMELIB_NAMESPACE_BEGIN
+
+uint32_t ESP32BLEAddressSet::mark_seen(uint64_t address, uint32_t scan) {
+  const int index = this->find_(address);
+  if (index < 0)
+    return 0;
+  Entry &entry = this->entries_[index];
+  uint32_t last_seen = 0;
+  if (entry.address == address) {
+    last_seen = entry.last_seen;
+  } else if (this->size_ < ESP32_BLE_ADDRESS_SET_SIZE * 3 / 4) {
+    // Keep some slots empty so that probe sequences stay short.
+    entry.address = address;
+    this->size_++;
+  } else {
+    return 0;
+  }
+  entry.last_seen = scan;
+  return last_seen;
+}
+uint32_t ESP32BLEAddressSet::get_last_seen(uint64_t address) const {
+  const int index = this->find_(address);
+  if (index < 0 || this->entries_[index].address != address)
+    return 0;
+  return this->entries_[index].last_seen;
+}
+void ESP32BLEAddressSet::evict_older_than(uint32_t scan) {
+  for (uint16_t i = 0; i < ESP32_BLE_ADDRESS_SET_SIZE; i++) {
+    // Removing shifts a following entry into this slot, check it again.
+    while (this->entries_[i].address != 0 && this->entries_[i].last_seen < scan)
+      this->remove_(i);
+  }
+}
+uint16_t ESP32BLEAddressSet::size() const {
+  return this->size_;
+}
+uint16_t ESP32BLEAddressSet::home_(uint64_t address) {
+  // Fibonacci hashing, the upper bits of the product are well mixed.
+  return uint32_t((address * 0x9E3779B97F4A7C15ULL) >> 32) % ESP32_BLE_ADDRESS_SET_SIZE;
+}
+int ESP32BLEAddressSet::find_(uint64_t address) const {
+  uint16_t index = home_(address);
+  for (uint16_t i = 0; i < ESP32_BLE_ADDRESS_SET_SIZE; i++) {
+    const uint64_t slot = this->entries_[index].address;
+    if (slot == address || slot == 0)
+      return index;
+    index = (index + 1) % ESP32_BLE_ADDRESS_SET_SIZE;
+  }
+  return -1;
+}
+void ESP32BLEAddressSet::remove_(uint16_t index) {
+  // Backward-shift deletion: move later entries of the probe sequence into the hole, as long as that doesn't
+  // put them before their home slot, so that no lookup ever stops early at the freed slot.
+  uint16_t next = index;
+  while (true) {
+    next = (next + 1) % ESP32_BLE_ADDRESS_SET_SIZE;
+    const uint64_t address = this->entries_[next].address;
+    if (address == 0)
+      break;
+    const uint16_t home = home_(address);
+    const bool home_in_between = index <= next ? (index < home && home <= next) : (index < home || home <= next);
+    if (home_in_between)
+      continue;
+    this->entries_[index] = this->entries_[next];
+    index = next;
+  }
+  this->entries_[index].address = 0;
+  this->size_--;
+}
+
+ESPHOMELIB_NAMESPACE_END
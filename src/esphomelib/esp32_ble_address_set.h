@@ -0,0 +1,60 @@
+//
+//  esp32_ble_address_set.h
+//  esphomelib
+//
+//  Copyright © 2018 Otto Winter. All rights reserved.
+//
+
+#ifndef ESPHOMELIB_ESP32_BLE_ADDRESS_SET_H
+#define ESPHOMELIB_ESP32_BLE_ADDRESS_SET_H
+
+#include <cstdint>
+
+#include "esphomelib/defines.h"
+
+ESPHOMELIB_NAMESPACE_BEGIN
+
+/// The number of addresses ESP32BLEAddressSet can hold, must be a power of two.
+const uint16_t ESP32_BLE_ADDRESS_SET_SIZE = 128;
+
+/** Bounded open-addressing hash set of BLE addresses that remembers in which scan each address was last seen.
+ *
+ * Uses linear probing in a fixed table, so lookups are constant time and no memory is allocated after
+ * construction. Addresses that haven't been seen for a while are removed with evict_older_than(), in place.
+ * Plain computation without any ESP-IDF dependencies, so it's also tested on the host.
+ */
+class ESP32BLEAddressSet {
+ public:
+  /** Mark the address as seen in the given scan.
+   *
+   * @return The scan in which the address was seen before, or 0 if it's new. If the set is full,
+   *         new addresses are not stored and 0 is returned every time.
+   */
+  uint32_t mark_seen(uint64_t address, uint32_t scan);
+  /// Return the scan in which the address was last seen, or 0 if it's unknown.
+  uint32_t get_last_seen(uint64_t address) const;
+  /// Remove all addresses last seen before the given scan.
+  void evict_older_than(uint32_t scan);
+  /// Return the number of stored addresses.
+  uint16_t size() const;
+
+ protected:
+  struct Entry {
+    uint64_t address; ///< 0 means the slot is empty
+    uint32_t last_seen;
+  };
+
+  /// Return the slot where the probe sequence of address starts.
+  static uint16_t home_(uint64_t address);
+  /// Return the index of the slot holding address or the empty slot where it would be inserted, -1 if full.
+  int find_(uint64_t address) const;
+  /// Remove the entry in the given slot without allocating, keeping all other entries reachable.
+  void remove_(uint16_t index);
+
+  Entry entries_[ESP32_BLE_ADDRESS_SET_SIZE]{};
+  uint16_t size_{0};
+};
+
+ESPHOMELIB_NAMESPACE_END
+
+#endif //ESPHOMELIB_ESP32_BLE_ADDRESS_SET_H
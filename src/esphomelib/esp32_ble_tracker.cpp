@@ -16,6 +16,8 @@
 #include <esp_bt.h>
 #include <freertos/task.h>
 #include <esp_gap_ble_api.h>
+#include <algorithm>
+#include <cstring>
 #include "esphomelib/log.h"
 
 ESPHOMELIB_NAMESPACE_BEGIN
@@ -25,8 +27,10 @@ ESPHOMELIB_NAMESPACE_BEGIN
 
 static const char *TAG = "esp32_ble";
 
+/// Addresses that weren't seen in this many scans are removed from the set of discovered addresses.
+static const uint32_t ESP32_BLE_ADDRESS_MAX_AGE = 2;
+
 ESP32BLETracker *global_esp32_ble_tracker = nullptr;
-SemaphoreHandle_t semaphore_scan_end;
 
 void ESP32BLETracker::setup() {
   global_esp32_ble_tracker = this;
@@ -40,6 +44,13 @@ void ESP32BLETracker::setup() {
       nullptr, // Handle, not needed
       0 // core
   );
+
+  if (!this->metric_sensors_.empty()) {
+    this->metrics_last_time_ = millis();
+    this->set_interval("metrics", this->metrics_interval_, [this]() {
+      this->publish_metrics_();
+    });
+  }
 }
 
 void ESP32BLETracker::gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param) {
@@ -58,13 +69,22 @@ void ESP32BLETracker::gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_ga
 }
 
 void ESP32BLETracker::ble_core_task(void *params) {
-  semaphore_scan_end = xSemaphoreCreateMutex();
+  if (ESP32BLETracker::ble_setup()) {
+    // BLE takes some time to be fully set up, 200ms should be more than enough
+    delay(200);
+    global_esp32_ble_tracker->start_scan();
+  }
+
+  // Scans are restarted from the GAP event handler, this task isn't needed anymore.
+  vTaskDelete(nullptr);
+}
 
+bool ESP32BLETracker::ble_setup() {
   // Initialize non-volatile storage for the bluetooth controller
   esp_err_t err = nvs_flash_init();
   if (err != ESP_OK) {
     ESP_LOGE(TAG, "nvs_flash_init failed: %d", err);
-    return;
+    return false;
   }
 
   // Initialize the bluetooth controller with the default configuration
@@ -72,29 +92,29 @@ void ESP32BLETracker::ble_core_task(void *params) {
   err = esp_bt_controller_init(&bt_cfg);
   if (err != ESP_OK) {
     ESP_LOGE(TAG, "esp_bt_controller_init failed: %d", err);
-    return;
+    return false;
   }
 
   err = esp_bt_controller_enable(ESP_BT_MODE_BLE);
   if (err != ESP_OK) {
     ESP_LOGE(TAG, "esp_bt_controller_enable failed: %d", err);
-    return;
+    return false;
   }
 
   err = esp_bluedroid_init();
   if (err != ESP_OK) {
     ESP_LOGE(TAG, "esp_bluedroid_init failed: %d", err);
-    return;
+    return false;
   }
   err = esp_bluedroid_enable();
   if (err != ESP_OK) {
     ESP_LOGE(TAG, "esp_bluedroid_enable failed: %d", err);
-    return;
+    return false;
   }
   err = esp_ble_gap_register_callback(ESP32BLETracker::gap_event_handler);
   if (err != ESP_OK) {
     ESP_LOGE(TAG, "esp_ble_gap_register_callback failed: %d", err);
-    return;
+    return false;
   }
 
   // Empty name
@@ -103,69 +123,139 @@ void ESP32BLETracker::ble_core_task(void *params) {
   esp_ble_io_cap_t iocap = ESP_IO_CAP_NONE;
   esp_ble_gap_set_security_param(ESP_BLE_SM_IOCAP_MODE, &iocap, sizeof(uint8_t));
 
-  // BLE takes some time to be fully set up, 200ms should be more than enough
-  delay(200);
-
-  while (true) {
-    global_esp32_ble_tracker->start_scan(true);
-    // wait for result
-    xSemaphoreTake(semaphore_scan_end, portMAX_DELAY);
-    xSemaphoreGive(semaphore_scan_end);
-  }
+  return true;
 }
 
-std::string ble_extract_name(const uint8_t *payload, uint8_t len) {
+bool ble_parse_advertisement(const uint8_t *data, uint8_t len, ESP32BLEParsedAdvertisement *out) {
+  ESP32BLEDataView short_name{};
+  bool valid = true;
   uint8_t i = 0;
   while (i < len) {
-    uint8_t field_length = payload[i++];
-    if (field_length == 0)  // last field has length 0
+    const uint8_t field_length = data[i];
+    if (field_length == 0) // remaining data is padding
       break;
+    if (i + 1 + field_length > len) {
+      valid = false;
+      break;
+    }
 
-    uint8_t field_type = payload[i++];
-    field_length--; // remaining data without adv type
-
-    if (field_type == ESP_BLE_AD_TYPE_NAME_CMPL) {
-      return std::string(reinterpret_cast<const char *>(&payload[i]), field_length);
+    const uint8_t field_type = data[i + 1];
+    const ESP32BLEDataView value{&data[i + 2], uint8_t(field_length - 1)};
+    switch (field_type) {
+      case ESP_BLE_AD_TYPE_NAME_CMPL: out->name = value; break;
+      case ESP_BLE_AD_TYPE_NAME_SHORT: short_name = value; break;
+      case ESP_BLE_AD_MANUFACTURER_SPECIFIC_TYPE: out->manufacturer_data = value; break;
+      case ESP_BLE_AD_TYPE_SERVICE_DATA: out->service_data = value; break;
+      case ESP_BLE_AD_TYPE_16SRV_PART:
+      case ESP_BLE_AD_TYPE_16SRV_CMPL: out->service_uuids_16 = value; break;
+      case ESP_BLE_AD_TYPE_32SRV_PART:
+      case ESP_BLE_AD_TYPE_32SRV_CMPL: out->service_uuids_32 = value; break;
+      case ESP_BLE_AD_TYPE_128SRV_PART:
+      case ESP_BLE_AD_TYPE_128SRV_CMPL: out->service_uuids_128 = value; break;
+      case ESP_BLE_AD_TYPE_TX_PWR:
+        if (value.len == 1)
+          out->tx_power = int8_t(value.data[0]);
+        break;
+      default: break;
     }
 
-    i += field_length;
+    i += 1 + field_length;
   }
 
-  return "";
+  if (out->name.len == 0)
+    out->name = short_name;
+  return valid;
+}
+
+std::string ESP32BLEParsedAdvertisement::get_name() const {
+  return std::string(reinterpret_cast<const char *>(this->name.data), this->name.len);
+}
+bool ESP32BLEParsedAdvertisement::has_service_uuid(uint16_t uuid) const {
+  for (uint8_t i = 0; i + 1 < this->service_uuids_16.len; i += 2) {
+    if ((this->service_uuids_16.data[i] | (this->service_uuids_16.data[i + 1] << 8)) == uuid)
+      return true;
+  }
+  return false;
+}
+optional<uint16_t> ESP32BLEParsedAdvertisement::get_manufacturer_id() const {
+  if (this->manufacturer_data.len < 2)
+    return {};
+  return uint16_t(this->manufacturer_data.data[0] | (this->manufacturer_data.data[1] << 8));
 }
 
 uint64_t ble_addr_to_uint64(const esp_bd_addr_t address) {
   uint64_t u = 0;
   u |= uint64_t(address[0] & 0xFF) << 40;
-  u |= uint64_t(address[0] & 0xFF) << 32;
-  u |= uint64_t(address[1] & 0xFF) << 24;
-  u |= uint64_t(address[2] & 0xFF) << 16;
-  u |= uint64_t(address[3] & 0xFF) << 8;
-  u |= uint64_t(address[4] & 0xFF) << 0;
+  u |= uint64_t(address[1] & 0xFF) << 32;
+  u |= uint64_t(address[2] & 0xFF) << 24;
+  u |= uint64_t(address[3] & 0xFF) << 16;
+  u |= uint64_t(address[4] & 0xFF) << 8;
+  u |= uint64_t(address[5] & 0xFF) << 0;
   return u;
 }
 
 void ESP32BLETracker::gap_scan_result(const esp_ble_gap_cb_param_t::ble_scan_result_evt_param &param) {
+  // This runs in the bluetooth task, so only hand the data over to the main loop here.
   if (param.search_evt == ESP_GAP_SEARCH_INQ_RES_EVT) {
+    ESP32BLEAdvertisement advertisement{};
+    advertisement.scan = this->scans_completed_.load(std::memory_order_relaxed) + 1;
+    advertisement.address = ble_addr_to_uint64(param.bda);
+    advertisement.rssi = param.rssi;
+    advertisement.address_type = param.ble_addr_type;
+    advertisement.data_len = std::min(size_t(param.adv_data_len) + param.scan_rsp_len, sizeof(advertisement.data));
+    memcpy(advertisement.data, param.ble_adv, advertisement.data_len);
+    if (!this->advertisements_.push(advertisement))
+      this->dropped_.fetch_add(1, std::memory_order_relaxed);
+  } else if (param.search_evt == ESP_GAP_SEARCH_INQ_CMPL_EVT) {
+    this->scans_completed_.fetch_add(1, std::memory_order_release);
+    // Start the next scan right away, the scan parameters stay the same.
+    this->scan_end_us_ = micros();
+    esp_ble_gap_start_scanning(this->scan_interval_);
+  }
+}
+void ESP32BLETracker::loop() {
+  ESP32BLEAdvertisement advertisement;
+  while (this->advertisements_.pop(&advertisement)) {
+    // Finish the previous scans before counting this advertisement towards a new one.
+    while (this->scan_ < advertisement.scan)
+      this->process_scan_complete_();
+    this->process_advertisement_(advertisement);
+  }
+
+  const uint32_t dropped = this->dropped_.load(std::memory_order_relaxed);
+  if (dropped != this->last_dropped_) {
+    ESP_LOGW(TAG, "Dropped %u BLE advertisements, the main loop can't keep up!", dropped - this->last_dropped_);
+    this->last_dropped_ = dropped;
+  }
+
+  while (this->scan_ <= this->scans_completed_.load(std::memory_order_acquire))
+    this->process_scan_complete_();
+
+  this->check_timeouts_();
+}
+void ESP32BLETracker::process_advertisement_(const ESP32BLEAdvertisement &advertisement) {
+  this->metrics_processed_++;
+
+  ESP32BLEParsedAdvertisement parsed{};
+  if (!ble_parse_advertisement(advertisement.data, advertisement.data_len, &parsed)) {
+    ESP_LOGV(TAG, "Received malformed advertisement data.");
+  }
+
+  const uint32_t last_seen = this->discovered_.mark_seen(advertisement.address, this->scan_);
+  if (last_seen != this->scan_) {
     char mac[24];
     snprintf(mac, 24, "%02X:%02X:%02X:%02X:%02X:%02X",
-             param.bda[0], param.bda[1], param.bda[2], param.bda[3], param.bda[4], param.bda[5]);
-
-    uint64_t address = ble_addr_to_uint64(param.bda);
-    // O(N^2), but won't be called that often anyway and this is probably better with memory allocation
-    for (auto addr : this->discovered_) {
-      if (addr == address) {
-        ESP_LOGV(TAG, "Already discovered device %s", mac);
-        return;
-      }
-    }
-    this->discovered_.push_back(address);
+             uint8_t(advertisement.address >> 40), uint8_t(advertisement.address >> 32),
+             uint8_t(advertisement.address >> 24), uint8_t(advertisement.address >> 16),
+             uint8_t(advertisement.address >> 8), uint8_t(advertisement.address));
 
-    if_debug {
-      ESP_LOGD(TAG, "Found device %s RSSI=%d", mac, param.rssi);
+    if (last_seen != 0) {
+      ESP_LOGV(TAG, "Rediscovered device %s RSSI=%d", mac, advertisement.rssi);
+    } else if_debug {
+      ESP_LOGD(TAG, "Found device %s RSSI=%d", mac, advertisement.rssi);
 
       const char *address_type_s;
-      switch (param.ble_addr_type) {
+      switch (advertisement.address_type) {
         case BLE_ADDR_TYPE_PUBLIC: address_type_s = "PUBLIC"; break;
         case BLE_ADDR_TYPE_RANDOM: address_type_s = "RANDOM"; break;
         case BLE_ADDR_TYPE_RPA_PUBLIC: address_type_s = "RPA_PUBLIC"; break;
@@ -173,62 +263,122 @@ void ESP32BLETracker::gap_scan_result(const esp_ble_gap_cb_param_t::ble_scan_res
         default: address_type_s = "UNKNOWN"; break;
       }
       ESP_LOGD(TAG, "    Address Type: %s", address_type_s);
-
-      std::string name = ble_extract_name(param.ble_adv, param.adv_data_len);
-      ESP_LOGD(TAG, "    Name: '%s'", name.c_str());
+      ESP_LOGD(TAG, "    Name: '%s'", parsed.get_name().c_str());
+      if (parsed.tx_power.has_value())
+        ESP_LOGD(TAG, "    TX Power: %d dBm", *parsed.tx_power);
+      if (parsed.get_manufacturer_id().has_value())
+        ESP_LOGD(TAG, "    Manufacturer ID: 0x%04X", *parsed.get_manufacturer_id());
     }
+  }
 
-    for (auto *dev : this->devices_) {
-      if (dev->address_ == address) {
-        dev->publish_state(true);
+  const uint32_t now = millis();
+  for (auto *dev : this->devices_) {
+    if (dev->address_ == advertisement.address) {
+      dev->last_seen_ = now;
+      dev->publish_state(true);
 
-        // no break here - maybe someone has a use-case where they need several binary sensors with the same
-        // address, shouldn't slow things down much anyway.
-      }
+      // no break here - maybe someone has a use-case where they need several binary sensors with the same
+      // address, shouldn't slow things down much anyway.
+    }
+  }
+  for (auto *sensor : this->rssi_sensors_) {
+    if (sensor->address_ == advertisement.address)
+      sensor->push_new_value(advertisement.rssi);
+  }
+
+  this->advertisement_callback_.call(advertisement, parsed);
+}
+void ESP32BLETracker::process_scan_complete_() {
+  ESP_LOGD(TAG, "Scan complete, %u devices discovered recently.", this->discovered_.size());
+  for (auto *device : this->devices_) {
+    if (device->timeout_ == 0 && this->discovered_.get_last_seen(device->address_) != this->scan_)
+      device->publish_state(false);
+  }
+  if (this->scan_ >= ESP32_BLE_ADDRESS_MAX_AGE)
+    this->discovered_.evict_older_than(this->scan_ - ESP32_BLE_ADDRESS_MAX_AGE + 1);
+  this->scan_++;
+}
+void ESP32BLETracker::check_timeouts_() {
+  const uint32_t now = millis();
+  for (auto *device : this->devices_) {
+    if (device->timeout_ != 0 && device->value && now - device->last_seen_ > device->timeout_) {
+      ESP_LOGD(TAG, "'%s': No advertisement received for %u ms.", device->get_name().c_str(), device->timeout_);
+      device->publish_state(false);
     }
-  } else if (param.search_evt == ESP_GAP_SEARCH_INQ_CMPL_EVT) {
-    ESP_LOGD(TAG, "Scan complete.");
-    xSemaphoreGive(semaphore_scan_end);
   }
 }
 void ESP32BLETracker::gap_scan_set_param_complete(const esp_ble_gap_cb_param_t::ble_scan_param_cmpl_evt_param &param) {
   if (param.status != ESP_BT_STATUS_SUCCESS) {
     ESP_LOGE(TAG, "Scan set_param failed: %d", param.status);
+    return;
   }
+  esp_ble_gap_start_scanning(this->scan_interval_);
 }
 void ESP32BLETracker::gap_scan_start_complete(const esp_ble_gap_cb_param_t::ble_scan_start_cmpl_evt_param &param) {
   if (param.status != ESP_BT_STATUS_SUCCESS) {
     ESP_LOGE(TAG, "Scan start failed: %d", param.status);
+    return;
   }
-}
-void ESP32BLETracker::start_scan(bool first) {
-  xSemaphoreTake(semaphore_scan_end, portMAX_DELAY);
-
-  ESP_LOGD(TAG, "Starting scan...");
-  if (!first) {
-    // also O(N^2), but will only be called once every minute or so
-    for (auto *device : this->devices_) {
-      bool found = false;
-      for (auto discover : this->discovered_) {
-        if (discover == device->address_) {
-          found = true;
-          break;
-        }
-      }
-      if (!found) {
-        device->publish_state(false);
-      }
-    }
+  if (this->scan_end_us_ != 0) {
+    const uint32_t gap = micros() - this->scan_end_us_;
+    uint32_t max_gap = this->max_scan_gap_us_.load(std::memory_order_relaxed);
+    // Only the BLE task writes a new maximum, the main loop only resets it to 0.
+    while (gap > max_gap && !this->max_scan_gap_us_.compare_exchange_weak(max_gap, gap, std::memory_order_relaxed)) {}
   }
-  this->discovered_.clear();
-  this->scan_params_.scan_type = BLE_SCAN_TYPE_ACTIVE;
+}
+void ESP32BLETracker::start_scan() {
+  const bool filter_duplicates = this->should_filter_duplicates_();
+  ESP_LOGCONFIG(TAG, "Starting BLE scan:");
+  ESP_LOGCONFIG(TAG, "    Interval: %.1f ms, Window: %.1f ms", this->scan_timing_interval_ * 0.625f,
+                this->scan_timing_window_ * 0.625f);
+  ESP_LOGCONFIG(TAG, "    Active: %s", this->active_ ? "YES" : "NO");
+  ESP_LOGCONFIG(TAG, "    Filter duplicates: %s", filter_duplicates ? "YES" : "NO");
+
+  this->scan_params_.scan_type = this->active_ ? BLE_SCAN_TYPE_ACTIVE : BLE_SCAN_TYPE_PASSIVE;
   this->scan_params_.own_addr_type = BLE_ADDR_TYPE_PUBLIC;
   this->scan_params_.scan_filter_policy = BLE_SCAN_FILTER_ALLOW_UND_RPA_DIR;
-  this->scan_params_.scan_interval = uint16_t(100 / 0.625f);
-  this->scan_params_.scan_window = uint16_t(100 / 0.625f);
+  this->scan_params_.scan_interval = this->scan_timing_interval_;
+  this->scan_params_.scan_window = this->scan_timing_window_;
+  this->scan_params_.scan_duplicate = filter_duplicates ? BLE_SCAN_DUPLICATE_ENABLE : BLE_SCAN_DUPLICATE_DISABLE;
 
+  // The first scan is started once the parameters are set, see gap_scan_set_param_complete().
   esp_ble_gap_set_scan_params(&this->scan_params_);
-  esp_ble_gap_start_scanning(this->scan_interval_);
+}
+bool ESP32BLETracker::should_filter_duplicates_() const {
+  if (this->filter_duplicates_.has_value())
+    return *this->filter_duplicates_;
+  if (!this->rssi_sensors_.empty() || this->has_advertisement_callback_)
+    return false;
+  for (auto *device : this->devices_) {
+    if (device->timeout_ != 0)
+      return false;
+  }
+  return true;
+}
+void ESP32BLETracker::publish_metrics_() {
+  const uint32_t now = millis();
+  const float seconds = (now - this->metrics_last_time_) / 1000.0f;
+  this->metrics_last_time_ = now;
+  const uint32_t dropped_total = this->dropped_.load(std::memory_order_relaxed);
+  const uint32_t dropped = dropped_total - this->metrics_last_dropped_;
+  this->metrics_last_dropped_ = dropped_total;
+  const uint32_t received = this->metrics_processed_ + dropped;
+  this->metrics_processed_ = 0;
+  const uint32_t max_gap_us = this->max_scan_gap_us_.exchange(0, std::memory_order_relaxed);
+
+  for (auto *sensor : this->metric_sensors_) {
+    switch (sensor->metric_) {
+      case ESP32_BLE_METRIC_ADVERTISEMENT_RATE:
+        sensor->push_new_value(seconds > 0 ? received / seconds : 0.0f);
+        break;
+      case ESP32_BLE_METRIC_DROPPED:
+        sensor->push_new_value(dropped);
+        break;
+      case ESP32_BLE_METRIC_SCAN_GAP:
+        sensor->push_new_value(max_gap_us / 1000.0f);
+        break;
+    }
+  }
 }
 ESP32BLEDevice *ESP32BLETracker::make_device(const std::string &name, std::array<uint8_t, 6> address) {
   uint64_t addr = ble_addr_to_uint64(address.cbegin());
@@ -236,6 +386,39 @@ ESP32BLEDevice *ESP32BLETracker::make_device(const std::string &name, std::array
   this->devices_.push_back(dev);
   return dev;
 }
+ESP32BLERSSISensor *ESP32BLETracker::make_rssi_sensor(const std::string &name, std::array<uint8_t, 6> address) {
+  uint64_t addr = ble_addr_to_uint64(address.cbegin());
+  auto *sensor = new ESP32BLERSSISensor(name, addr);
+  this->rssi_sensors_.push_back(sensor);
+  return sensor;
+}
+void ESP32BLETracker::add_on_advertisement_callback(
+    InlineFunction<void(const ESP32BLEAdvertisement &, const ESP32BLEParsedAdvertisement &)> &&callback) {
+  this->has_advertisement_callback_ = true;
+  this->advertisement_callback_.add(std::move(callback));
+}
+ESP32BLEMetricSensor *ESP32BLETracker::make_metric_sensor(const std::string &name, ESP32BLEMetric metric) {
+  auto *sensor = new ESP32BLEMetricSensor(name, metric);
+  this->metric_sensors_.push_back(sensor);
+  return sensor;
+}
+void ESP32BLETracker::set_scan_timing(float interval, float window) {
+  // The controller counts in units of 0.625ms, from 2.5ms (0x0004) to 10.24s (0x4000).
+  const auto to_units = [](float ms) -> uint16_t {
+    return uint16_t(clamp(4.0f, 16384.0f, ms / 0.625f));
+  };
+  this->scan_timing_interval_ = to_units(interval);
+  this->scan_timing_window_ = std::min(to_units(window), this->scan_timing_interval_);
+}
+void ESP32BLETracker::set_active(bool active) {
+  this->active_ = active;
+}
+void ESP32BLETracker::set_filter_duplicates(bool filter_duplicates) {
+  this->filter_duplicates_ = filter_duplicates;
+}
+void ESP32BLETracker::set_metrics_interval(uint32_t metrics_interval) {
+  this->metrics_interval_ = metrics_interval;
+}
 void ESP32BLETracker::set_scan_interval(uint32_t scan_interval) {
   this->scan_interval_ = scan_interval;
 }
@@ -247,6 +430,41 @@ ESP32BLEDevice::ESP32BLEDevice(const std::string &name, uint64_t address)
 std::string ESP32BLEDevice::device_class() {
   return "presence";
 }
+void ESP32BLEDevice::set_timeout(uint32_t timeout) {
+  this->timeout_ = timeout;
+}
+
+ESP32BLERSSISensor::ESP32BLERSSISensor(const std::string &name, uint64_t address)
+    : Sensor(name), address_(address) {
+  // Advertisements arrive several times per second and RSSI is noisy, so replace the default filter.
+  this->clear_filters();
+  this->add_exponential_moving_average_filter(0.1f, 20);
+}
+ESP32BLEMetricSensor::ESP32BLEMetricSensor(const std::string &name, ESP32BLEMetric metric)
+    : Sensor(name), metric_(metric) {
+  // Metrics are already aggregated over the metrics interval.
+  this->clear_filters();
+}
+std::string ESP32BLEMetricSensor::unit_of_measurement() {
+  switch (this->metric_) {
+    case ESP32_BLE_METRIC_ADVERTISEMENT_RATE: return "adv/s";
+    case ESP32_BLE_METRIC_SCAN_GAP: return "ms";
+    default: return "";
+  }
+}
+std::string ESP32BLEMetricSensor::icon() {
+  return "mdi:bluetooth";
+}
+int8_t ESP32BLEMetricSensor::accuracy_decimals() {
+  return this->metric_ == ESP32_BLE_METRIC_DROPPED ? 0 : 1;
+}
+
+std::string ESP32BLERSSISensor::unit_of_measurement() {
+  return "dB";
+}
+std::string ESP32BLERSSISensor::icon() {
+  return "mdi:signal";
+}
 
 ESPHOMELIB_NAMESPACE_END
 
@@ -10,24 +10,97 @@
 #define ESPHOMELIB_ESP32_BLE_TRACKER_H
 
 #include "esphomelib/component.h"
+#include "esphomelib/esp32_ble_address_set.h"
+#include "esphomelib/spsc_queue.h"
 #include "esphomelib/binary_sensor/binary_sensor.h"
+#include "esphomelib/sensor/sensor.h"
+#include "esphomelib/helpers.h"
+#include "esphomelib/optional.h"
 #include "esphomelib/defines.h"
 
 #ifdef USE_ESP32_BLE_TRACKER
 
 #include <string>
 #include <array>
+#include <atomic>
 #include <esp_gap_ble_api.h>
 
 ESPHOMELIB_NAMESPACE_BEGIN
 
 class ESP32BLEDevice;
+class ESP32BLERSSISensor;
+class ESP32BLEMetricSensor;
+
+/// Statistics about the BLE tracker itself, see ESP32BLETracker::make_metric_sensor().
+enum ESP32BLEMetric {
+  ESP32_BLE_METRIC_ADVERTISEMENT_RATE = 0, ///< Received advertisements per second (including dropped ones).
+  ESP32_BLE_METRIC_DROPPED, ///< Advertisements dropped because the main loop couldn't keep up, per interval.
+  ESP32_BLE_METRIC_SCAN_GAP, ///< The longest time (in ms) the radio wasn't scanning between two scans.
+};
+
+/// One advertisement report, copied from the BLE task to the main loop.
+struct ESP32BLEAdvertisement {
+  /// The number of the scan this advertisement was received in, starting at 1.
+  uint32_t scan;
+  uint64_t address;
+  int8_t rssi;
+  esp_ble_addr_type_t address_type;
+  /// Length of the advertisement data plus the scan response data.
+  uint8_t data_len;
+  uint8_t data[ESP_BLE_ADV_DATA_LEN_MAX + ESP_BLE_SCAN_RSP_DATA_LEN_MAX];
+};
+
+/// A view of some bytes inside an advertisement, doesn't own or copy the data.
+struct ESP32BLEDataView {
+  const uint8_t *data;
+  uint8_t len;
+};
+
+/** The fields of an advertisement, parsed without copying.
+ *
+ * All views point into the data of the ESP32BLEAdvertisement that was parsed, so they're only
+ * valid for as long as that advertisement is. Fields that weren't present have a length of 0.
+ * If a field appears several times, the last one is used.
+ */
+struct ESP32BLEParsedAdvertisement {
+  /// The complete local name, or the shortened one if there's no complete name.
+  ESP32BLEDataView name{};
+  /// Manufacturer specific data, starts with the 16-bit company identifier (little endian).
+  ESP32BLEDataView manufacturer_data{};
+  /// Service data, starts with the 16-bit service UUID (little endian).
+  ESP32BLEDataView service_data{};
+  /// List of 16-bit service UUIDs (little endian).
+  ESP32BLEDataView service_uuids_16{};
+  /// List of 32-bit service UUIDs (little endian).
+  ESP32BLEDataView service_uuids_32{};
+  /// List of 128-bit service UUIDs (little endian).
+  ESP32BLEDataView service_uuids_128{};
+  /// The transmit power level in dBm.
+  optional<int8_t> tx_power{};
+
+  /// Return the name as a string, empty if there's no name.
+  std::string get_name() const;
+  /// Return whether the 16-bit service UUID is advertised.
+  bool has_service_uuid(uint16_t uuid) const;
+  /// Return the company identifier of the manufacturer data, if there is any.
+  optional<uint16_t> get_manufacturer_id() const;
+};
+
+/** Parse the advertising data structures of an advertisement (and its scan response).
+ *
+ * @param data The raw data, a sequence of [length, type, value...] structures.
+ * @param len The length of data.
+ * @param out The parsed fields are stored here, pointing into data.
+ * @return Whether the data was well-formed, if not, the fields before the malformed structure are still stored.
+ */
+bool ble_parse_advertisement(const uint8_t *data, uint8_t len, ESP32BLEParsedAdvertisement *out);
 
 /** The ESP32BLETracker class is a hub for all ESP32 Bluetooth Low Energy devices.
  *
- * This implementation is currently only quite basic and only supports using scan to
- * see if BLE beacons can be found. In the future, this class will support exposing the RSSI
- * service data and some GATTC standardized information like temperature.
+ * This implementation only scans and doesn't connect to devices. Advertisements are reported to presence binary
+ * sensors and RSSI sensors, and the parsed advertisement data (name, manufacturer data, service data,
+ * service UUIDs and TX power) is available through add_on_advertisement_callback(). In the future,
+ * this class might support reading some GATTC standardized information like temperature.
  *
  * The implementation uses a lightweight version of the amazing ESP32 BLE Arduino library by
  * Neil Kolban. This was done because the ble library was quite huge and esphomelib would only
@@ -46,7 +119,8 @@ class ESP32BLETracker : public Component {
    *
    * Each time a BLE scan yields the MAC address in the address parameter, the binary sensor
    * will immediately go to true. When a whole scan interval does not discover a device with this
-   * MAC address, the binary sensor will be set to false.
+   * MAC address, the binary sensor will be set to false. To mark devices as not present sooner,
+   * use ESP32BLEDevice::set_timeout() on the return value.
    *
    * The address parameter accepts a MAC address as an array of length 6 with each MAC address
    * part in an unsigned int. To set it up, do something like this:
@@ -78,25 +152,99 @@ class ESP32BLETracker : public Component {
    */
   ESP32BLEDevice *make_device(const std::string &name, std::array<uint8_t, 6> address);
 
+  /** Create a sensor reporting the signal strength (RSSI, in dB) of the device with the given MAC address.
+   *
+   * Every advertisement of the device is a new value, by default the values are smoothed with an
+   * exponential moving average. The sensor needs to be registered like any other sensor:
+   *
+   * ```cpp
+   * App.register_sensor(tracker->make_rssi_sensor("Phone RSSI", {0xAC, 0x37, 0x43, 0x77, 0x5F, 0x4C}));
+   * ```
+   *
+   * @param name The name of the sensor.
+   * @param address The MAC address to match.
+   * @return The sensor, use this to change the filters.
+   */
+  ESP32BLERSSISensor *make_rssi_sensor(const std::string &name, std::array<uint8_t, 6> address);
+
+  /** Add a callback that's called in the main loop with every received advertisement.
+   *
+   * The parsed fields point into the advertisement, so copy everything that's needed after the callback.
+   */
+  void add_on_advertisement_callback(InlineFunction<void(const ESP32BLEAdvertisement &,
+                                                           const ESP32BLEParsedAdvertisement &)> &&callback);
+
+  /** Create a sensor for a statistic of the tracker, published every metrics interval.
+   *
+   * ```cpp
+   * App.register_sensor(tracker->make_metric_sensor("BLE Advertisements", ESP32_BLE_METRIC_ADVERTISEMENT_RATE));
+   * ```
+   *
+   * @see set_metrics_interval
+   */
+  ESP32BLEMetricSensor *make_metric_sensor(const std::string &name, ESP32BLEMetric metric);
+
   /** Set the number of seconds (!) that a single BLE scan should take.
    *
-   * This parameter is useful when adjusting how long it should take for a bluetooth device
-   * to be marked as disconnected.
+   * A new scan is started immediately after one ends, so this only controls how long it should take
+   * for a bluetooth device without a timeout to be marked as disconnected. 0 means scanning forever,
+   * then devices are only marked as disconnected by their timeout.
    *
    * @param scan_interval The interval in seconds to reset the scan.
    */
   void set_scan_interval(uint32_t scan_interval);
 
+  /** Set the duty cycle of the radio: in every period of `interval` ms, the radio listens for `window` ms.
+   *
+   * The ESP32 has only one radio for WiFi and bluetooth, so the remaining time is left to WiFi. A higher
+   * duty cycle finds devices sooner and drops fewer advertisements, but WiFi suffers. Both values must
+   * be between 2.5ms and 10240ms and window can't be larger than interval. Defaults to 100ms/100ms.
+   *
+   * @param interval The scan interval in ms.
+   * @param window The scan window in ms.
+   */
+  void set_scan_timing(float interval, float window);
+
+  /** Set whether to request scan responses from devices (active scanning).
+   *
+   * Scan responses often contain the device name, but every response request costs radio time.
+   * Defaults to false (passive scanning).
+   */
+  void set_active(bool active);
+
+  /** Set whether the bluetooth controller should only report the first advertisement of each device per scan.
+   *
+   * This takes a lot of load off the BLE stack and the main loop, but RSSI sensors, device timeouts and
+   * advertisement callbacks need every advertisement. By default, duplicates are filtered only if none
+   * of those are used.
+   */
+  void set_filter_duplicates(bool filter_duplicates);
+
+  /// Set how often (in ms) the metric sensors are published. Defaults to 60s.
+  void set_metrics_interval(uint32_t metrics_interval);
+
   // ========== INTERNAL METHODS ==========
   // (In most use cases you won't need these)
   /// Setup the FreeRTOS task and the Bluetooth stack.
   void setup() override;
+  /// Process the advertisements and finished scans reported by the BLE task.
+  void loop() override;
 
  protected:
-  /// The FreeRTOS task managing the bluetooth interface.
+  /// The FreeRTOS task setting up the bluetooth interface, deletes itself once scanning is configured.
   static void ble_core_task(void *params);
-  /// Start a single scan by setting up the parameters and doing some esp-idf calls.
-  void start_scan(bool first);
+  /// Initialize the bluetooth controller and stack, returns false on failure.
+  static bool ble_setup();
+  /// Set the scan parameters, the first scan is started once they're applied.
+  void start_scan();
+  /// Publish the values of all metric sensors.
+  void publish_metrics_();
+  /// Handle one advertisement in the main loop.
+  void process_advertisement_(const ESP32BLEAdvertisement &advertisement);
+  /// Handle the end of a scan in the main loop: devices not seen during the scan are marked as not present.
+  void process_scan_complete_();
+  /// Mark devices with a timeout as not present if they haven't been seen for that long.
+  void check_timeouts_();
   /// Callback that will handle all GAP events and redistribute them to other callbacks.
   static void gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param);
   /// Called when a `ESP_GAP_BLE_SCAN_RESULT_EVT` event is received.
@@ -105,15 +253,44 @@ class ESP32BLETracker : public Component {
   void gap_scan_set_param_complete(const esp_ble_gap_cb_param_t::ble_scan_param_cmpl_evt_param &param);
   /// Called when a `ESP_GAP_BLE_SCAN_START_COMPLETE_EVT` event is received.
   void gap_scan_start_complete(const esp_ble_gap_cb_param_t::ble_scan_start_cmpl_evt_param &param);
+  /// Whether the controller should filter duplicate advertisements, see set_filter_duplicates().
+  bool should_filter_duplicates_() const;
 
   /// An array of registered devices to track
   std::vector<ESP32BLEDevice *> devices_;
-  /// An array of MAC addresses discovered during this scan. Used to mark registered devices as undiscovered.
-  std::vector<uint64_t> discovered_;
+  std::vector<ESP32BLERSSISensor *> rssi_sensors_;
+  std::vector<ESP32BLEMetricSensor *> metric_sensors_;
+  CallbackManager<void(const ESP32BLEAdvertisement &, const ESP32BLEParsedAdvertisement &)> advertisement_callback_{};
+  bool has_advertisement_callback_{false};
+  /// All recently discovered addresses and the scan they were last seen in, only used by the main loop.
+  ESP32BLEAddressSet discovered_;
+  /// The number of the scan that's currently running, as seen by the main loop. Starts at 1.
+  uint32_t scan_{1};
+  /// Advertisements from the BLE task (producer) to the main loop (consumer).
+  SPSCQueue<ESP32BLEAdvertisement, 32> advertisements_;
+  /// Number of finished scans, incremented by the BLE task.
+  std::atomic<uint32_t> scans_completed_{0};
+  /// Number of advertisements dropped because the queue was full, incremented by the BLE task.
+  std::atomic<uint32_t> dropped_{0};
+  uint32_t last_dropped_{0};
   /// A structure holding the ESP BLE scan parameters.
   esp_ble_scan_params_t scan_params_;
   /// The interval in seconds to perform scans.
   uint32_t scan_interval_{300};
+  /// The scan interval and window in units of 0.625ms.
+  uint16_t scan_timing_interval_{160};
+  uint16_t scan_timing_window_{160};
+  bool active_{false};
+  optional<bool> filter_duplicates_{};
+
+  /// micros() when the last scan ended, only used by the BLE task.
+  uint32_t scan_end_us_{0};
+  /// The longest gap between two scans since the metrics were last published, written by the BLE task.
+  std::atomic<uint32_t> max_scan_gap_us_{0};
+  uint32_t metrics_interval_{60000};
+  uint32_t metrics_last_time_{0};
+  uint32_t metrics_processed_{0};
+  uint32_t metrics_last_dropped_{0};
 };
 
 /// Simple helper class to expose an BLE device as a binary sensor.
@@ -121,16 +298,55 @@ class ESP32BLEDevice : public binary_sensor::BinarySensor {
  public:
   ESP32BLEDevice(const std::string &name, uint64_t address);
 
+  /** Set the time (in ms) after which the device is marked as not present if no advertisement is received.
+   *
+   * Devices send advertisements every few hundred milliseconds up to a few seconds, so something like
+   * 30s avoids flapping. Defaults to 0, which means the device is only marked as not present at the end
+   * of a scan in which it wasn't seen.
+   */
+  void set_timeout(uint32_t timeout);
+
  protected:
   friend ESP32BLETracker;
 
   std::string device_class() override;
 
+  uint64_t address_;
+  uint32_t timeout_{0};
+  /// millis() of the last advertisement.
+  uint32_t last_seen_{0};
+};
+
+/// Sensor for a statistic of the BLE tracker, see ESP32BLEMetric.
+class ESP32BLEMetricSensor : public sensor::Sensor {
+ public:
+  ESP32BLEMetricSensor(const std::string &name, ESP32BLEMetric metric);
+
+  std::string unit_of_measurement() override;
+  std::string icon() override;
+  int8_t accuracy_decimals() override;
+
+ protected:
+  friend ESP32BLETracker;
+
+  ESP32BLEMetric metric_;
+};
+
+/// Sensor for the signal strength of a BLE device, in dB.
+class ESP32BLERSSISensor : public sensor::Sensor {
+ public:
+  ESP32BLERSSISensor(const std::string &name, uint64_t address);
+
+  std::string unit_of_measurement() override;
+  std::string icon() override;
+
+ protected:
+  friend ESP32BLETracker;
+
   uint64_t address_;
 };
 
 extern ESP32BLETracker *global_esp32_ble_tracker;
-extern SemaphoreHandle_t semaphore_scan_end;
 
 ESPHOMELIB_NAMESPACE_END
 
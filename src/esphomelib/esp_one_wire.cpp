@@ -7,6 +7,7 @@
 //
 
 #include "esphomelib/esp_one_wire.h"
+#include "esphomelib/helpers.h"
 
 #ifdef USE_ONE_WIRE
 
@@ -25,11 +26,12 @@ bool ESPOneWire::reset() {
     delayMicroseconds(2);
   } while (!this->pin_->digital_read());
 
-  // Send 480µs LOW TX reset pulse
+  // Send 480µs LOW TX reset pulse, being interrupted only makes it longer which is fine.
   this->pin_->pin_mode(OUTPUT);
   this->pin_->digital_write(false);
   delayMicroseconds(480);
 
+  disable_interrupts();
   // Switch into RX mode, letting the pin float
   this->pin_->pin_mode(INPUT);
   // after 15µs-60µs wait time, slave pulls low for 60µs-240µs
@@ -37,11 +39,13 @@ bool ESPOneWire::reset() {
   delayMicroseconds(70);
 
   bool r = !this->pin_->digital_read();
+  enable_interrupts();
   delayMicroseconds(410);
   return r;
 }
 
 void ESPOneWire::write_bit(bool bit) {
+  disable_interrupts();
   // Initiate write/read by pulling low.
   this->pin_->pin_mode(OUTPUT);
   this->pin_->digital_write(false);
@@ -60,9 +64,11 @@ void ESPOneWire::write_bit(bool bit) {
     // grace period, 1µs recovery time
     delayMicroseconds(5);
   }
+  enable_interrupts();
 }
 
 bool ESPOneWire::read_bit() {
+  disable_interrupts();
   // Initiate read slot by pulling LOW for at least 1µs
   this->pin_->pin_mode(OUTPUT);
   this->pin_->digital_write(false);
@@ -73,6 +79,7 @@ bool ESPOneWire::read_bit() {
   delayMicroseconds(10);
 
   bool r = this->pin_->digital_read();
+  enable_interrupts();
   // read time slot at least 60µs long + 1µs recovery time between slots
   delayMicroseconds(53);
   return r;
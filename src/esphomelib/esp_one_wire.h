@@ -25,6 +25,9 @@ const int ONE_WIRE_ROM_SEARCH = 0xF0;
  *
  * It's more or less the same as Arduino's internal library but uses some fancy C++ and 64 bit
  * unsigned integers to make our lives easier.
+ *
+ * Interrupts are only disabled for the timing-critical part of each individual time slot (at most ~70µs),
+ * never for whole transactions. The 1-Wire protocol allows arbitrarily long pauses between slots.
  */
 class ESPOneWire {
  public:
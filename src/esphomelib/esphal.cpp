@@ -108,4 +108,8 @@ GPIOInputPin::GPIOInputPin() : GPIOPin() {
 
 }
 
+#ifdef ARDUINO_ARCH_ESP32
+rmt_channel_t next_rmt_channel = RMT_CHANNEL_0;
+#endif
+
 ESPHOMELIB_NAMESPACE_END
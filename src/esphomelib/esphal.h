@@ -7,6 +7,7 @@
 
 #ifdef ARDUINO_ARCH_ESP32
   #include <esp32-hal.h>
+  #include <driver/rmt.h>
 #endif
 #ifdef ARDUINO_ARCH_ESP8266
   #include "Arduino.h"
@@ -103,6 +104,11 @@ class GPIOInputPin : public GPIOPin {
   GPIOInputPin(uint8_t pin, uint8_t mode = INPUT, bool inverted = false); // NOLINT
 };
 
+#ifdef ARDUINO_ARCH_ESP32
+/// The next unused RMT channel, shared by all components using the RMT peripheral (IR transmitter and receiver).
+extern rmt_channel_t next_rmt_channel;
+#endif
+
 ESPHOMELIB_NAMESPACE_END
 
 #endif //ESPHOMELIB_ESPHAL_H
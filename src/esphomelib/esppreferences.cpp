@@ -4,227 +4,288 @@
 
 #include "esphomelib/esppreferences.h"
 
-#include <functional>
+#include <cstring>
+#include <algorithm>
 
+#include "esphomelib/esppreferences_log.h"
 #include "esphomelib/log.h"
 #include "esphomelib/helpers.h"
+#include "esphomelib/esphal.h"
 
 ESPHOMELIB_NAMESPACE_BEGIN
 
 static const char *TAG = "preferences";
+/// FNV offset basis for the collision check hash, any value other than the standard basis works.
+static const uint32_t CHECK_HASH_BASIS = 0x5BD1E995UL;
 
 #ifdef ARDUINO_ARCH_ESP32
-void ESPPreferences::begin(const std::string &name) {
-  const std::string key = truncate_string(name, 15);
-  ESP_LOGV(TAG, "Opening preferences with key '%s'", key.c_str());
-  this->preferences_.begin(key.c_str());
+bool NVSPreferenceBackend::begin(const std::string &name) {
+  const std::string ns = truncate_string(name, 15);
+  ESP_LOGV(TAG, "Opening NVS namespace '%s'", ns.c_str());
+  esp_err_t err = nvs_open(ns.c_str(), NVS_READWRITE, &this->handle_);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "Opening NVS namespace failed: %d", err);
+    return false;
+  }
+  this->is_open_ = true;
+  return true;
+}
+bool NVSPreferenceBackend::load(uint32_t key, ESPPreferenceEntry *entry) {
+  if (!this->is_open_)
+    return false;
+  char name[9];
+  snprintf(name, sizeof(name), "%08x", key);
+  size_t length = sizeof(ESPPreferenceEntry);
+  esp_err_t err = nvs_get_blob(this->handle_, name, entry, &length);
+  return err == ESP_OK && length == sizeof(ESPPreferenceEntry);
+}
+bool NVSPreferenceBackend::commit(const std::vector<ESPPreferenceEntry> &entries) {
+  if (!this->is_open_)
+    return false;
+  for (auto &entry : entries) {
+    char name[9];
+    snprintf(name, sizeof(name), "%08x", entry.key);
+    esp_err_t err = nvs_set_blob(this->handle_, name, &entry, sizeof(ESPPreferenceEntry));
+    if (err != ESP_OK) {
+      ESP_LOGE(TAG, "Writing preference %s failed: %d", name, err);
+      return false;
+    }
+  }
+  return nvs_commit(this->handle_) == ESP_OK;
 }
+#endif
+
+void ESPPreferences::begin(const std::string &name) {
+  if (this->backend_ == nullptr) {
+#ifdef ARDUINO_ARCH_ESP32
+    this->backend_ = new NVSPreferenceBackend();
+#endif
+#ifdef ARDUINO_ARCH_ESP8266
+    this->backend_ = new LogPreferenceBackend(new ESP8266PreferenceFlash());
+#endif
+  }
+  this->opened_ = this->backend_ != nullptr && this->backend_->begin(name);
+  if (!this->opened_) {
+    ESP_LOGE(TAG, "Could not open preferences, values won't be stored across reboots!");
+  }
+
+  add_shutdown_hook([this](const char *cause) {
+    this->commit();
+  });
+}
+void ESPPreferences::dump_config() {
+  if (this->backend_ != nullptr)
+    this->backend_->dump_config();
+  // begin() usually runs before the logger exists, so repeat its error here.
+  if (!this->opened_)
+    ESP_LOGE(TAG, "Could not open preferences, values won't be stored across reboots!");
+}
+void ESPPreferences::set_backend(ESPPreferenceBackend *backend) {
+  this->backend_ = backend;
+  this->opened_ = false;
+}
+void ESPPreferences::set_commit_delay(uint32_t commit_delay) {
+  this->commit_delay_ = commit_delay;
+}
+bool ESPPreferences::commit() {
+  if (this->pending_.empty())
+    return true;
+  if (!this->opened_)
+    return false;
 
-std::string ESPPreferences::get_preference_key(const std::string &friendly_name, const std::string &key) {
-  // TODO: Improve this - the hash function is less than ideal.
-  size_t h = std::hash<std::string>{}(friendly_name);
-  char buffer[8];
-  snprintf(buffer, sizeof(buffer), "%0zx", h);
-  std::string name_hash = std::string(buffer);
-  std::string trunc_key = truncate_string(key, 7);
-  return name_hash + "-" + trunc_key;
+  ESP_LOGV(TAG, "Committing %u preferences.", unsigned(this->pending_.size()));
+  if (!this->backend_->commit(this->pending_)) {
+    ESP_LOGE(TAG, "Committing preferences failed!");
+    // keep the values staged and try again after the next commit delay.
+    this->last_put_ = millis();
+    return false;
+  }
+  this->pending_.clear();
+  return true;
+}
+void ESPPreferences::loop() {
+  if (this->opened_ && !this->pending_.empty() && millis() - this->last_put_ >= this->commit_delay_)
+    this->commit();
+}
+ESPPreferenceEntry ESPPreferences::make_entry_(const std::string &friendly_name, const std::string &key,
+                                               uint8_t type) const {
+  std::string name = friendly_name;
+  name += '\0';
+  name += key;
+  const uint32_t check = fnv1a_hash(name, CHECK_HASH_BASIS);
+
+  ESPPreferenceEntry entry{};
+  entry.key = fnv1a_hash(name);
+  entry.check = uint16_t((check >> 16) ^ check);
+  entry.type = type;
+  return entry;
+}
+bool ESPPreferences::find_(ESPPreferenceEntry *entry, bool *collision) {
+  ESPPreferenceEntry found{};
+  auto it = std::find_if(this->pending_.begin(), this->pending_.end(), [entry](const ESPPreferenceEntry &e) {
+    return e.key == entry->key;
+  });
+  if (it != this->pending_.end()) {
+    found = *it;
+  } else if (!this->opened_ || !this->backend_->load(entry->key, &found)) {
+    *collision = false;
+    return false;
+  }
+
+  *collision = found.check != entry->check;
+  if (*collision || found.type != entry->type || found.length > sizeof(found.data))
+    return false;
+  *entry = found;
+  return true;
+}
+size_t ESPPreferences::put_(ESPPreferenceEntry entry, const void *value, uint8_t length) {
+  ESPPreferenceEntry existing = entry;
+  bool collision;
+  if (this->find_(&existing, &collision) && existing.length == length && memcmp(existing.data, value, length) == 0) {
+    // Value didn't change, no need to write anything.
+    return length;
+  }
+  if (collision) {
+    ESP_LOGE(TAG, "Preference key 0x%08X is already used by another component (hash collision)!", entry.key);
+    return 0;
+  }
+
+  entry.length = length;
+  memcpy(entry.data, value, length);
+  auto it = std::find_if(this->pending_.begin(), this->pending_.end(), [&entry](const ESPPreferenceEntry &e) {
+    return e.key == entry.key;
+  });
+  if (it != this->pending_.end())
+    *it = entry;
+  else
+    this->pending_.push_back(entry);
+  this->last_put_ = millis();
+  return length;
+}
+bool ESPPreferences::get_(ESPPreferenceEntry entry, void *value, uint8_t length) {
+  bool collision;
+  if (!this->find_(&entry, &collision)) {
+    if (collision)
+      ESP_LOGW(TAG, "Preference key 0x%08X belongs to another component (hash collision)!", entry.key);
+    return false;
+  }
+  if (entry.length != length)
+    return false;
+  memcpy(value, entry.data, length);
+  return true;
 }
+
 bool ESPPreferences::get_bool(const std::string &friendly_name, const std::string &key, bool default_value) {
-  const std::string key_ = this->get_preference_key(friendly_name, key);
-  bool value = this->preferences_.getBool(key_.c_str(), default_value);
-  ESP_LOGVV(TAG, "'%s' -> recovered bool %s", key_.c_str(), value ? "ON" : "OFF");
-  return value;
+  uint8_t value = default_value;
+  this->get_(this->make_entry_(friendly_name, key, PREFERENCE_TYPE_BOOL), &value, sizeof(value));
+  ESP_LOGVV(TAG, "'%s/%s' -> recovered bool %s", friendly_name.c_str(), key.c_str(), value ? "ON" : "OFF");
+  return value != 0;
 }
 int8_t ESPPreferences::get_int8(const std::string &friendly_name, const std::string &key, int8_t default_value) {
-  const std::string key_ = this->get_preference_key(friendly_name, key);
-  int8_t value = this->preferences_.getChar(key_.c_str(), default_value);
-  ESP_LOGVV(TAG, "'%s' -> recovered int8 %d", key_.c_str(), value);
+  int8_t value = default_value;
+  this->get_(this->make_entry_(friendly_name, key, PREFERENCE_TYPE_INT8), &value, sizeof(value));
+  ESP_LOGVV(TAG, "'%s/%s' -> recovered int8 %d", friendly_name.c_str(), key.c_str(), value);
   return value;
 }
 uint8_t ESPPreferences::get_uint8(const std::string &friendly_name, const std::string &key, uint8_t default_value) {
-  const std::string key_ = this->get_preference_key(friendly_name, key);
-  uint8_t value = this->preferences_.getUChar(key_.c_str(), default_value);
-  ESP_LOGVV(TAG, "'%s' -> recovered uint8 %u", key_.c_str(), value);
+  uint8_t value = default_value;
+  this->get_(this->make_entry_(friendly_name, key, PREFERENCE_TYPE_UINT8), &value, sizeof(value));
+  ESP_LOGVV(TAG, "'%s/%s' -> recovered uint8 %u", friendly_name.c_str(), key.c_str(), value);
   return value;
 }
 int16_t ESPPreferences::get_int16(const std::string &friendly_name, const std::string &key, int16_t default_value) {
-  const std::string key_ = this->get_preference_key(friendly_name, key);
-  int16_t value = this->preferences_.getShort(key_.c_str(), default_value);
-  ESP_LOGVV(TAG, "'%s' -> recovered int16 %d", key_.c_str(), value);
+  int16_t value = default_value;
+  this->get_(this->make_entry_(friendly_name, key, PREFERENCE_TYPE_INT16), &value, sizeof(value));
+  ESP_LOGVV(TAG, "'%s/%s' -> recovered int16 %d", friendly_name.c_str(), key.c_str(), value);
   return value;
 }
 uint16_t ESPPreferences::get_uint16(const std::string &friendly_name, const std::string &key, uint16_t default_value) {
-  const std::string key_ = this->get_preference_key(friendly_name, key);
-  uint16_t value = this->preferences_.getUShort(key_.c_str(), default_value);
-  ESP_LOGVV(TAG, "'%s' -> recovered uint16 %u", key_.c_str(), value);
+  uint16_t value = default_value;
+  this->get_(this->make_entry_(friendly_name, key, PREFERENCE_TYPE_UINT16), &value, sizeof(value));
+  ESP_LOGVV(TAG, "'%s/%s' -> recovered uint16 %u", friendly_name.c_str(), key.c_str(), value);
   return value;
 }
 int32_t ESPPreferences::get_int32(const std::string &friendly_name, const std::string &key, int32_t default_value) {
-  const std::string key_ = this->get_preference_key(friendly_name, key);
-  int32_t value = this->preferences_.getInt(key_.c_str(), default_value);
-  ESP_LOGVV(TAG, "'%s' -> recovered int32 %d", key_.c_str(), value);
+  int32_t value = default_value;
+  this->get_(this->make_entry_(friendly_name, key, PREFERENCE_TYPE_INT32), &value, sizeof(value));
+  ESP_LOGVV(TAG, "'%s/%s' -> recovered int32 %d", friendly_name.c_str(), key.c_str(), value);
   return value;
 }
 uint32_t ESPPreferences::get_uint32(const std::string &friendly_name, const std::string &key, uint32_t default_value) {
-  const std::string key_ = this->get_preference_key(friendly_name, key);
-  uint32_t value = this->preferences_.getUInt(key_.c_str(), default_value);
-  ESP_LOGVV(TAG, "'%s' -> recovered uint32 %u", key_.c_str(), value);
+  uint32_t value = default_value;
+  this->get_(this->make_entry_(friendly_name, key, PREFERENCE_TYPE_UINT32), &value, sizeof(value));
+  ESP_LOGVV(TAG, "'%s/%s' -> recovered uint32 %u", friendly_name.c_str(), key.c_str(), value);
   return value;
 }
 int64_t ESPPreferences::get_int64(const std::string &friendly_name, const std::string &key, int64_t default_value) {
-  const std::string key_ = this->get_preference_key(friendly_name, key);
-  int64_t value = this->preferences_.getLong64(key_.c_str(), default_value);
-  ESP_LOGVV(TAG, "'%s' -> recovered int64 %lld", key_.c_str(), value);
+  int64_t value = default_value;
+  this->get_(this->make_entry_(friendly_name, key, PREFERENCE_TYPE_INT64), &value, sizeof(value));
+  ESP_LOGVV(TAG, "'%s/%s' -> recovered int64 %lld", friendly_name.c_str(), key.c_str(), value);
   return value;
 }
 uint64_t ESPPreferences::get_uint64(const std::string &friendly_name, const std::string &key, uint64_t default_value) {
-  const std::string key_ = this->get_preference_key(friendly_name, key);
-  uint64_t value = this->preferences_.getULong64(key_.c_str(), default_value);
-  ESP_LOGVV(TAG, "'%s' -> recovered uint64 %llu", key_.c_str(), value);
+  uint64_t value = default_value;
+  this->get_(this->make_entry_(friendly_name, key, PREFERENCE_TYPE_UINT64), &value, sizeof(value));
+  ESP_LOGVV(TAG, "'%s/%s' -> recovered uint64 %llu", friendly_name.c_str(), key.c_str(), value);
   return value;
 }
 float ESPPreferences::get_float(const std::string &friendly_name, const std::string &key, float default_value) {
-  const std::string key_ = this->get_preference_key(friendly_name, key);
-  float value = this->preferences_.getFloat(key_.c_str(), default_value);
-  ESP_LOGVV(TAG, "'%s' -> recovered float %f", key_.c_str(), value);
+  float value = default_value;
+  this->get_(this->make_entry_(friendly_name, key, PREFERENCE_TYPE_FLOAT), &value, sizeof(value));
+  ESP_LOGVV(TAG, "'%s/%s' -> recovered float %f", friendly_name.c_str(), key.c_str(), value);
   return value;
 }
 double ESPPreferences::get_double(const std::string &friendly_name, const std::string &key, double default_value) {
-  const std::string key_ = this->get_preference_key(friendly_name, key);
-  double value = this->preferences_.getFloat(key_.c_str(), default_value);
-  ESP_LOGVV(TAG, "'%s' -> recovered double %llf", key_.c_str(), value);
+  double value = default_value;
+  this->get_(this->make_entry_(friendly_name, key, PREFERENCE_TYPE_DOUBLE), &value, sizeof(value));
+  ESP_LOGVV(TAG, "'%s/%s' -> recovered double %f", friendly_name.c_str(), key.c_str(), value);
   return value;
 }
 size_t ESPPreferences::put_bool(const std::string &friendly_name, const std::string &key, bool value) {
-  const std::string key_ = this->get_preference_key(friendly_name, key);
-  ESP_LOGVV(TAG, "'%s' -> putting bool %s", key_.c_str(), value ? "ON" : "OFF");
-  return this->preferences_.putBool(key_.c_str(), value);
+  ESP_LOGVV(TAG, "'%s/%s' -> putting bool %s", friendly_name.c_str(), key.c_str(), value ? "ON" : "OFF");
+  const uint8_t raw = value ? 1 : 0;
+  return this->put_(this->make_entry_(friendly_name, key, PREFERENCE_TYPE_BOOL), &raw, sizeof(raw));
 }
 size_t ESPPreferences::put_int8(const std::string &friendly_name, const std::string &key, int8_t value) {
-  const std::string key_ = this->get_preference_key(friendly_name, key);
-  ESP_LOGVV(TAG, "'%s' -> putting int8 %d", key_.c_str(), value);
-  return this->preferences_.putChar(key_.c_str(), value);
+  ESP_LOGVV(TAG, "'%s/%s' -> putting int8 %d", friendly_name.c_str(), key.c_str(), value);
+  return this->put_(this->make_entry_(friendly_name, key, PREFERENCE_TYPE_INT8), &value, sizeof(value));
 }
 size_t ESPPreferences::put_uint8(const std::string &friendly_name, const std::string &key, uint8_t value) {
-  const std::string key_ = this->get_preference_key(friendly_name, key);
-  ESP_LOGVV(TAG, "'%s' -> putting uint8 %u", key_.c_str(), value);
-  return this->preferences_.putUChar(key_.c_str(), value);
-  return this->preferences_.putUChar(this->get_preference_key(friendly_name, key).c_str(), value);
+  ESP_LOGVV(TAG, "'%s/%s' -> putting uint8 %u", friendly_name.c_str(), key.c_str(), value);
+  return this->put_(this->make_entry_(friendly_name, key, PREFERENCE_TYPE_UINT8), &value, sizeof(value));
 }
 size_t ESPPreferences::put_int16(const std::string &friendly_name, const std::string &key, int16_t value) {
-  const std::string key_ = this->get_preference_key(friendly_name, key);
-  ESP_LOGVV(TAG, "'%s' -> putting int16 %d", key_.c_str(), value);
-  return this->preferences_.putShort(key_.c_str(), value);
+  ESP_LOGVV(TAG, "'%s/%s' -> putting int16 %d", friendly_name.c_str(), key.c_str(), value);
+  return this->put_(this->make_entry_(friendly_name, key, PREFERENCE_TYPE_INT16), &value, sizeof(value));
 }
 size_t ESPPreferences::put_uint16(const std::string &friendly_name, const std::string &key, uint16_t value) {
-  const std::string key_ = this->get_preference_key(friendly_name, key);
-  ESP_LOGVV(TAG, "'%s' -> putting uint16 %u", key_.c_str(), value);
-  return this->preferences_.putUShort(key_.c_str(), value);
+  ESP_LOGVV(TAG, "'%s/%s' -> putting uint16 %u", friendly_name.c_str(), key.c_str(), value);
+  return this->put_(this->make_entry_(friendly_name, key, PREFERENCE_TYPE_UINT16), &value, sizeof(value));
 }
 size_t ESPPreferences::put_int32(const std::string &friendly_name, const std::string &key, int32_t value) {
-  const std::string key_ = this->get_preference_key(friendly_name, key);
-  ESP_LOGVV(TAG, "'%s' -> putting int32 %d", key_.c_str(), value);
-  return this->preferences_.putInt(key_.c_str(), value);
+  ESP_LOGVV(TAG, "'%s/%s' -> putting int32 %d", friendly_name.c_str(), key.c_str(), value);
+  return this->put_(this->make_entry_(friendly_name, key, PREFERENCE_TYPE_INT32), &value, sizeof(value));
 }
 size_t ESPPreferences::put_uint32(const std::string &friendly_name, const std::string &key, uint32_t value) {
-  const std::string key_ = this->get_preference_key(friendly_name, key);
-  ESP_LOGVV(TAG, "'%s' -> putting uint32 %u", key_.c_str(), value);
-  return this->preferences_.putUInt(key_.c_str(), value);
+  ESP_LOGVV(TAG, "'%s/%s' -> putting uint32 %u", friendly_name.c_str(), key.c_str(), value);
+  return this->put_(this->make_entry_(friendly_name, key, PREFERENCE_TYPE_UINT32), &value, sizeof(value));
 }
 size_t ESPPreferences::put_int64(const std::string &friendly_name, const std::string &key, int64_t value) {
-  const std::string key_ = this->get_preference_key(friendly_name, key);
-  ESP_LOGVV(TAG, "'%s' -> putting int64 %lld", key_.c_str(), value);
-  return this->preferences_.putLong64(key_.c_str(), value);
+  ESP_LOGVV(TAG, "'%s/%s' -> putting int64 %lld", friendly_name.c_str(), key.c_str(), value);
+  return this->put_(this->make_entry_(friendly_name, key, PREFERENCE_TYPE_INT64), &value, sizeof(value));
 }
 size_t ESPPreferences::put_uint64(const std::string &friendly_name, const std::string &key, uint64_t value) {
-  const std::string key_ = this->get_preference_key(friendly_name, key);
-  ESP_LOGVV(TAG, "'%s' -> putting uint64 %llu", key_.c_str(), value);
-  return this->preferences_.putULong64(key_.c_str(), value);
+  ESP_LOGVV(TAG, "'%s/%s' -> putting uint64 %llu", friendly_name.c_str(), key.c_str(), value);
+  return this->put_(this->make_entry_(friendly_name, key, PREFERENCE_TYPE_UINT64), &value, sizeof(value));
 }
 size_t ESPPreferences::put_float(const std::string &friendly_name, const std::string &key, float value) {
-  const std::string key_ = this->get_preference_key(friendly_name, key);
-  ESP_LOGVV(TAG, "'%s' -> putting float %f", key_.c_str(), value);
-  return this->preferences_.putFloat(key_.c_str(), value);
+  ESP_LOGVV(TAG, "'%s/%s' -> putting float %f", friendly_name.c_str(), key.c_str(), value);
+  return this->put_(this->make_entry_(friendly_name, key, PREFERENCE_TYPE_FLOAT), &value, sizeof(value));
 }
 size_t ESPPreferences::put_double(const std::string &friendly_name, const std::string &key, double value) {
-  const std::string key_ = this->get_preference_key(friendly_name, key);
-  ESP_LOGVV(TAG, "'%s' -> putting double %f", key_.c_str(), value);
-  return this->preferences_.putDouble(key_.c_str(), value);
+  ESP_LOGVV(TAG, "'%s/%s' -> putting double %f", friendly_name.c_str(), key.c_str(), value);
+  return this->put_(this->make_entry_(friendly_name, key, PREFERENCE_TYPE_DOUBLE), &value, sizeof(value));
 }
-#endif
-#ifdef ARDUINO_ARCH_ESP8266
-// TODO implement this for ESP8266
-
-void ESPPreferences::begin(const std::string &name) {
-
-}
-bool ESPPreferences::get_bool(const std::string &friendly_name, const std::string &key, bool default_value) {
-  return default_value;
-}
-int8_t ESPPreferences::get_int8(const std::string &friendly_name, const std::string &key, int8_t default_value) {
-  return default_value;
-}
-uint8_t ESPPreferences::get_uint8(const std::string &friendly_name, const std::string &key, uint8_t default_value) {
-  return default_value;
-}
-int16_t ESPPreferences::get_int16(const std::string &friendly_name, const std::string &key, int16_t default_value) {
-  return default_value;
-}
-uint16_t ESPPreferences::get_uint16(const std::string &friendly_name, const std::string &key, uint16_t default_value) {
-  return default_value;
-}
-int32_t ESPPreferences::get_int32(const std::string &friendly_name, const std::string &key, int32_t default_value) {
-  return default_value;
-}
-uint32_t ESPPreferences::get_uint32(const std::string &friendly_name, const std::string &key, uint32_t default_value) {
-  return default_value;
-}
-int64_t ESPPreferences::get_int64(const std::string &friendly_name, const std::string &key, int64_t default_value) {
-  return default_value;
-}
-uint64_t ESPPreferences::get_uint64(const std::string &friendly_name, const std::string &key, uint64_t default_value) {
-  return default_value;
-}
-float ESPPreferences::get_float(const std::string &friendly_name, const std::string &key, float default_value) {
-  return default_value;
-}
-double ESPPreferences::get_double(const std::string &friendly_name, const std::string &key, double default_value) {
-  return default_value;
-}
-size_t ESPPreferences::put_bool(const std::string &friendly_name, const std::string &key, bool value) {
-  return 0;
-}
-size_t ESPPreferences::put_int8(const std::string &friendly_name, const std::string &key, int8_t value) {
-  return 0;
-}
-size_t ESPPreferences::put_uint8(const std::string &friendly_name, const std::string &key, uint8_t value) {
-  return 0;
-}
-size_t ESPPreferences::put_int16(const std::string &friendly_name, const std::string &key, int16_t value) {
-  return 0;
-}
-size_t ESPPreferences::put_uint16(const std::string &friendly_name, const std::string &key, uint16_t value) {
-  return 0;
-}
-size_t ESPPreferences::put_int32(const std::string &friendly_name, const std::string &key, int32_t value) {
-  return 0;
-}
-size_t ESPPreferences::put_uint32(const std::string &friendly_name, const std::string &key, uint32_t value) {
-  return 0;
-}
-size_t ESPPreferences::put_int64(const std::string &friendly_name, const std::string &key, int64_t value) {
-  return 0;
-}
-size_t ESPPreferences::put_uint64(const std::string &friendly_name, const std::string &key, uint64_t value) {
-  return 0;
-}
-size_t ESPPreferences::put_float(const std::string &friendly_name, const std::string &key, float value) {
-  return 0;
-}
-size_t ESPPreferences::put_double(const std::string &friendly_name, const std::string &key, double value) {
-  return 0;
-}
-#endif
 
 ESPPreferences global_preferences;
 
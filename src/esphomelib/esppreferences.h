@@ -6,17 +6,88 @@
 #define ESPHOMELIB_ESPPREFERENCES_H
 
 #include <string>
+#include <vector>
+#include <cstdint>
 
 #ifdef ARDUINO_ARCH_ESP32
-#include <Preferences.h>
+#include <nvs.h>
 #endif
 
-#include "esphomelib/espmath.h"
 #include "esphomelib/defines.h"
 
 ESPHOMELIB_NAMESPACE_BEGIN
 
-/// Helper class to allow easy access to non-volatile storage like SPIFFS to save preferences.
+/// The type of value stored in a ESPPreferenceEntry, used to reject reading a value with the wrong type.
+enum ESPPreferenceType : uint8_t {
+  PREFERENCE_TYPE_BOOL = 0x01,
+  PREFERENCE_TYPE_INT8,
+  PREFERENCE_TYPE_UINT8,
+  PREFERENCE_TYPE_INT16,
+  PREFERENCE_TYPE_UINT16,
+  PREFERENCE_TYPE_INT32,
+  PREFERENCE_TYPE_UINT32,
+  PREFERENCE_TYPE_INT64,
+  PREFERENCE_TYPE_UINT64,
+  PREFERENCE_TYPE_FLOAT,
+  PREFERENCE_TYPE_DOUBLE,
+};
+
+/// A single stored preference value, this is the unit the backends store.
+struct ESPPreferenceEntry {
+  /// FNV-1a hash of the friendly name and key.
+  uint32_t key;
+  /// A second, independent 16-bit hash of the friendly name and key to detect collisions of key.
+  uint16_t check;
+  /// The ESPPreferenceType of the value.
+  uint8_t type;
+  /// The number of bytes used in data.
+  uint8_t length;
+  uint8_t data[8];
+};
+
+/// Interface for the non-volatile storage ESPPreferences commits its values to.
+class ESPPreferenceBackend {
+ public:
+  /// Open the storage for the application with the specified name.
+  virtual bool begin(const std::string &name) = 0;
+
+  /// Load the entry with the given key into entry, returns false if it doesn't exist.
+  virtual bool load(uint32_t key, ESPPreferenceEntry *entry) = 0;
+
+  /// Atomically (if the storage allows it) write all entries.
+  virtual bool commit(const std::vector<ESPPreferenceEntry> &entries) = 0;
+
+  /// Log where the preferences are stored, called once the logger is set up.
+  virtual void dump_config() {}
+};
+
+#ifdef ARDUINO_ARCH_ESP32
+/** Store preferences as blobs in the ESP32's NVS partition.
+ *
+ * NVS is already a CRC-checked, wear-leveled log so each entry is just stored as a single blob
+ * named by the hex representation of its key. A commit only issues a single nvs_commit().
+ */
+class NVSPreferenceBackend : public ESPPreferenceBackend {
+ public:
+  bool begin(const std::string &name) override;
+  bool load(uint32_t key, ESPPreferenceEntry *entry) override;
+  bool commit(const std::vector<ESPPreferenceEntry> &entries) override;
+
+ protected:
+  nvs_handle handle_{0};
+  bool is_open_{false};
+};
+#endif
+
+/** Helper class to allow easy access to non-volatile storage to save preferences.
+ *
+ * Values are addressed by the friendly name of their component and a key. Both are hashed into a stable
+ * 32-bit key (plus a 16-bit check hash to detect collisions), so names can be of any length.
+ *
+ * Writes are only staged in RAM: they're committed to the backend in a single batch once no new values
+ * have been put for commit_delay ms, or when the node shuts down. Putting a value that's identical to
+ * the stored one doesn't cause a write at all.
+ */
 class ESPPreferences {
  public:
   /// Start the preferences object with the specified app name.
@@ -46,14 +117,49 @@ class ESPPreferences {
   float get_float(const std::string &friendly_name, const std::string &key, float default_value);
   double get_double(const std::string &friendly_name, const std::string &key, double default_value);
 
+  /** Manually set the storage backend, must be called before begin().
+   *
+   * Defaults to NVSPreferenceBackend on the ESP32 and a LogPreferenceBackend in the EEPROM sector
+   * on the ESP8266. A single sector isn't enough for the log, so on the ESP8266 values are only stored
+   * across reboots with a backend on reserved sectors, see ESP8266PreferenceFlash.
+   */
+  void set_backend(ESPPreferenceBackend *backend);
+
+  /// Set how long (in ms) values are staged in RAM after the last put before they're committed. Defaults to 1000ms.
+  void set_commit_delay(uint32_t commit_delay);
+
+  /// Write all staged values to the backend now. Returns true if there was nothing to commit or the commit succeeded.
+  bool commit();
+
+  /// Internal: Commit staged values once the commit delay has passed. Called by Application::loop().
+  void loop();
+
+  /// Internal: Log the storage backend configuration. Called by Application::setup().
+  void dump_config();
+
  protected:
+  /// Build an entry (without value) for the given friendly name and key.
+  ESPPreferenceEntry make_entry_(const std::string &friendly_name, const std::string &key, uint8_t type) const;
 
-#ifdef ARDUINO_ARCH_ESP32
-  /// Return a key for the nvs storage by hashing the friendly name and truncating the key to 7 characters.
-  std::string get_preference_key(const std::string &friendly_name, const std::string &key);
+  /** Find the current value for entry->key, either in the staged values or in the backend.
+   *
+   * @return false if it doesn't exist, or it exists but belongs to another name (hash collision)
+   *         or has another type.
+   */
+  bool find_(ESPPreferenceEntry *entry, bool *collision);
 
-  Preferences preferences_;
-#endif
+  /// Stage the value of the entry for writing, returns the number of bytes written or 0 on failure.
+  size_t put_(ESPPreferenceEntry entry, const void *value, uint8_t length);
+
+  /// Read the value of the entry into value, returns false if the value doesn't exist.
+  bool get_(ESPPreferenceEntry entry, void *value, uint8_t length);
+
+  ESPPreferenceBackend *backend_{nullptr};
+  /// Whether the backend was opened successfully, values stay staged in RAM otherwise.
+  bool opened_{false};
+  std::vector<ESPPreferenceEntry> pending_;
+  uint32_t commit_delay_{1000};
+  uint32_t last_put_{0};
 };
 
 extern ESPPreferences global_preferences;
@@ -0,0 +1,334 @@
+//
+//  esppreferences_log.cpp
+//  esphomelib
+//
+//  Copyright © 2018 Otto Winter. All rights reserved.
+//
+
+#include "esphomelib/esppreferences_log.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "esphomelib/crc.h"
+#include "esphomelib/log.h"
+#include "esphomelib/helpers.h"
+
+#ifdef ARDUINO_ARCH_ESP8266
+extern "C" {
+#include "spi_flash.h"
+}
+extern "C" uint32_t _SPIFFS_end;
+#endif
+
+ESPHOMELIB_NAMESPACE_BEGIN
+
+static const char *TAG = "preferences.log";
+
+static const uint32_t LOG_SECTOR_MAGIC = 0x46505345UL; // "ESPF"
+static const uint8_t LOG_RECORD_TYPE_HEADER = 0xF0;
+static const uint8_t LOG_RECORD_TYPE_COMMIT = 0xF1;
+
+#ifdef ARDUINO_ARCH_ESP8266
+ESP8266PreferenceFlash::ESP8266PreferenceFlash()
+    // The EEPROM sector directly follows SPIFFS.
+    : ESP8266PreferenceFlash(((uint32_t) &_SPIFFS_end - 0x40200000) / SPI_FLASH_SEC_SIZE, 1) {
+
+}
+ESP8266PreferenceFlash::ESP8266PreferenceFlash(uint32_t first_sector, size_t num_sectors)
+    : first_sector_(first_sector), num_sectors_(num_sectors) {
+
+}
+size_t ESP8266PreferenceFlash::get_sector_size() const {
+  return SPI_FLASH_SEC_SIZE;
+}
+size_t ESP8266PreferenceFlash::get_num_sectors() const {
+  return this->num_sectors_;
+}
+bool ESP8266PreferenceFlash::read(size_t sector, size_t offset, uint32_t *data, size_t length) {
+  const uint32_t address = (this->first_sector_ + sector) * SPI_FLASH_SEC_SIZE + offset;
+  noInterrupts();
+  SpiFlashOpResult res = spi_flash_read(address, data, length);
+  interrupts();
+  return res == SPI_FLASH_RESULT_OK;
+}
+bool ESP8266PreferenceFlash::write(size_t sector, size_t offset, const uint32_t *data, size_t length) {
+  const uint32_t address = (this->first_sector_ + sector) * SPI_FLASH_SEC_SIZE + offset;
+  noInterrupts();
+  SpiFlashOpResult res = spi_flash_write(address, const_cast<uint32_t *>(data), length);
+  interrupts();
+  return res == SPI_FLASH_RESULT_OK;
+}
+bool ESP8266PreferenceFlash::erase(size_t sector) {
+  noInterrupts();
+  SpiFlashOpResult res = spi_flash_erase_sector(this->first_sector_ + sector);
+  interrupts();
+  return res == SPI_FLASH_RESULT_OK;
+}
+void ESP8266PreferenceFlash::dump_config() {
+  const uint32_t start = this->first_sector_ * SPI_FLASH_SEC_SIZE;
+  ESP_LOGCONFIG(TAG, "    Flash: 0x%06X to 0x%06X (%u sectors)", start,
+                start + this->num_sectors_ * SPI_FLASH_SEC_SIZE - 1, unsigned(this->num_sectors_));
+}
+#endif
+
+#ifndef ARDUINO
+FilePreferenceFlash::FilePreferenceFlash(const std::string &path, size_t num_sectors, size_t sector_size)
+    : num_sectors_(num_sectors), sector_size_(sector_size) {
+  this->file_ = fopen(path.c_str(), "r+b");
+  if (this->file_ == nullptr) {
+    // new image, start with erased flash.
+    this->file_ = fopen(path.c_str(), "w+b");
+    for (size_t i = 0; this->file_ != nullptr && i < num_sectors; i++)
+      this->erase(i);
+  }
+}
+FilePreferenceFlash::~FilePreferenceFlash() {
+  if (this->file_ != nullptr)
+    fclose(this->file_);
+}
+size_t FilePreferenceFlash::get_sector_size() const {
+  return this->sector_size_;
+}
+size_t FilePreferenceFlash::get_num_sectors() const {
+  return this->num_sectors_;
+}
+bool FilePreferenceFlash::read(size_t sector, size_t offset, uint32_t *data, size_t length) {
+  if (this->file_ == nullptr || fseek(this->file_, sector * this->sector_size_ + offset, SEEK_SET) != 0)
+    return false;
+  return fread(data, 1, length, this->file_) == length;
+}
+bool FilePreferenceFlash::write(size_t sector, size_t offset, const uint32_t *data, size_t length) {
+  std::vector<uint32_t> current(length / 4);
+  if (!this->read(sector, offset, current.data(), length))
+    return false;
+  // NOR flash can only clear bits
+  for (size_t i = 0; i < current.size(); i++)
+    current[i] &= data[i];
+  if (fseek(this->file_, sector * this->sector_size_ + offset, SEEK_SET) != 0)
+    return false;
+  bool ok = fwrite(current.data(), 1, length, this->file_) == length;
+  return fflush(this->file_) == 0 && ok;
+}
+bool FilePreferenceFlash::erase(size_t sector) {
+  if (this->file_ == nullptr || fseek(this->file_, sector * this->sector_size_, SEEK_SET) != 0)
+    return false;
+  std::vector<uint8_t> erased(this->sector_size_, 0xFF);
+  bool ok = fwrite(erased.data(), 1, erased.size(), this->file_) == erased.size();
+  return fflush(this->file_) == 0 && ok;
+}
+#endif
+
+LogPreferenceBackend::LogPreferenceBackend(PreferenceFlash *flash)
+    : flash_(flash) {
+
+}
+bool LogPreferenceBackend::begin(const std::string &name) {
+  if (this->flash_->get_num_sectors() < 2) {
+    // With a single sector, a power loss between erasing and rewriting it would lose all preferences.
+    ESP_LOGE(TAG, "The preference log needs at least 2 flash sectors, but only got %u!",
+             unsigned(this->flash_->get_num_sectors()));
+    return false;
+  }
+
+  // Find the valid sector with the highest sequence number, falling back to older ones
+  // if it doesn't contain a single commit (for example when a compaction was interrupted).
+  std::vector<std::pair<uint32_t, size_t>> sectors;
+  for (size_t i = 0; i < this->flash_->get_num_sectors(); i++) {
+    uint32_t sequence;
+    if (this->read_header_(i, &sequence))
+      sectors.emplace_back(sequence, i);
+  }
+  std::sort(sectors.begin(), sectors.end());
+
+  for (auto it = sectors.rbegin(); it != sectors.rend(); it++) {
+    if (this->replay_(it->second)) {
+      this->active_sector_ = it->second;
+      this->sequence_ = it->first;
+      ESP_LOGV(TAG, "Loaded %u preferences from sector %d (sequence %u), next slot %u.",
+               unsigned(this->live_.size()), this->active_sector_, this->sequence_, unsigned(this->next_slot_));
+      return true;
+    }
+  }
+
+  ESP_LOGD(TAG, "No preferences found in flash.");
+  this->live_.clear();
+  this->active_sector_ = -1;
+  if (!sectors.empty())
+    this->sequence_ = sectors.back().first;
+  return true;
+}
+bool LogPreferenceBackend::load(uint32_t key, ESPPreferenceEntry *entry) {
+  auto it = std::lower_bound(this->live_.begin(), this->live_.end(), key,
+                             [](const ESPPreferenceEntry &e, uint32_t k) {
+    return e.key < k;
+  });
+  if (it == this->live_.end() || it->key != key)
+    return false;
+  *entry = *it;
+  return true;
+}
+bool LogPreferenceBackend::commit(const std::vector<ESPPreferenceEntry> &entries) {
+  std::vector<ESPPreferenceEntry> live = this->live_;
+  for (auto &entry : entries)
+    apply_(&live, entry);
+
+  // entries + commit record
+  if (this->active_sector_ < 0 || this->next_slot_ + entries.size() + 1 > this->slots_per_sector_())
+    return this->compact_(live);
+
+  const size_t sector = this->active_sector_;
+  const uint32_t start = this->next_slot_;
+  for (auto &entry : entries) {
+    if (!this->write_record_(sector, this->next_slot_++, entry))
+      return false;
+  }
+  if (!this->write_commit_(sector, this->next_slot_++, start, entries.size()))
+    return false;
+
+  this->live_ = std::move(live);
+  return true;
+}
+void LogPreferenceBackend::dump_config() {
+  ESP_LOGCONFIG(TAG, "Preferences:");
+  this->flash_->dump_config();
+  ESP_LOGCONFIG(TAG, "    Stored preferences: %u", unsigned(this->live_.size()));
+}
+size_t LogPreferenceBackend::size() const {
+  return this->live_.size();
+}
+size_t LogPreferenceBackend::slots_per_sector_() const {
+  return this->flash_->get_sector_size() / sizeof(Record);
+}
+bool LogPreferenceBackend::read_record_(size_t sector, size_t slot, Record *record, bool *erased) {
+  uint32_t *words = reinterpret_cast<uint32_t *>(record);
+  *erased = false;
+  if (!this->flash_->read(sector, slot * sizeof(Record), words, sizeof(Record)))
+    return false;
+
+  *erased = true;
+  for (size_t i = 0; i < sizeof(Record) / 4; i++)
+    *erased = *erased && words[i] == 0xFFFFFFFFUL;
+  if (*erased)
+    return false;
+  return record->crc == crc32(reinterpret_cast<const uint8_t *>(&record->entry), sizeof(ESPPreferenceEntry));
+}
+bool LogPreferenceBackend::write_record_(size_t sector, size_t slot, const ESPPreferenceEntry &entry) {
+  Record record{};
+  record.entry = entry;
+  record.crc = crc32(reinterpret_cast<const uint8_t *>(&record.entry), sizeof(ESPPreferenceEntry));
+  if (!this->flash_->write(sector, slot * sizeof(Record), reinterpret_cast<const uint32_t *>(&record),
+                           sizeof(Record))) {
+    ESP_LOGE(TAG, "Writing to flash sector %u failed!", unsigned(sector));
+    return false;
+  }
+  return true;
+}
+bool LogPreferenceBackend::write_commit_(size_t sector, size_t slot, uint32_t start, uint32_t count) {
+  ESPPreferenceEntry commit{};
+  commit.key = count;
+  commit.type = LOG_RECORD_TYPE_COMMIT;
+  commit.length = sizeof(uint32_t);
+  memcpy(commit.data, &start, sizeof(uint32_t));
+  return this->write_record_(sector, slot, commit);
+}
+bool LogPreferenceBackend::read_header_(size_t sector, uint32_t *sequence) {
+  Record record{};
+  bool erased;
+  if (!this->read_record_(sector, 0, &record, &erased))
+    return false;
+  if (record.entry.type != LOG_RECORD_TYPE_HEADER || record.entry.key != LOG_SECTOR_MAGIC)
+    return false;
+  memcpy(sequence, record.entry.data, sizeof(uint32_t));
+  return true;
+}
+bool LogPreferenceBackend::replay_(size_t sector) {
+  // The valid records since the last commit record, with their slot.
+  std::vector<std::pair<size_t, ESPPreferenceEntry>> transaction;
+  bool has_commit = false;
+  size_t slot = 1;
+  this->live_.clear();
+
+  for (; slot < this->slots_per_sector_(); slot++) {
+    Record record{};
+    bool erased;
+    if (!this->read_record_(sector, slot, &record, &erased)) {
+      if (erased)
+        break;
+      // Torn or corrupted record, the commit record of its transaction (if any) won't find all of
+      // its records so the whole transaction is discarded.
+      ESP_LOGW(TAG, "Skipping corrupted record %u in sector %u.", unsigned(slot), unsigned(sector));
+      continue;
+    }
+
+    if (record.entry.type == LOG_RECORD_TYPE_COMMIT) {
+      // A commit covers all records from its start slot up to itself, all of them must be valid.
+      uint32_t start;
+      memcpy(&start, record.entry.data, sizeof(uint32_t));
+      const size_t count = record.entry.key;
+      auto first = std::find_if(transaction.begin(), transaction.end(),
+                                [start](const std::pair<size_t, ESPPreferenceEntry> &p) {
+        return p.first >= start;
+      });
+      if (start + count == slot && size_t(transaction.end() - first) == count) {
+        for (auto it = first; it != transaction.end(); it++)
+          apply_(&this->live_, it->second);
+        has_commit = true;
+      }
+      transaction.clear();
+    } else {
+      transaction.emplace_back(slot, record.entry);
+    }
+  }
+  // Anything in transaction now was never committed, just leave it in flash and append after it.
+  this->next_slot_ = slot;
+  return has_commit;
+}
+bool LogPreferenceBackend::compact_(const std::vector<ESPPreferenceEntry> &live) {
+  if (live.size() + 2 > this->slots_per_sector_()) {
+    ESP_LOGE(TAG, "Too many preferences (%u) to fit into a flash sector!", unsigned(live.size()));
+    return false;
+  }
+
+  const size_t sector = (this->active_sector_ + 1) % this->flash_->get_num_sectors();
+  const uint32_t sequence = this->sequence_ + 1;
+  ESP_LOGD(TAG, "Compacting %u preferences into sector %u.", unsigned(live.size()), unsigned(sector));
+  if (!this->flash_->erase(sector)) {
+    ESP_LOGE(TAG, "Erasing flash sector %u failed!", unsigned(sector));
+    return false;
+  }
+
+  ESPPreferenceEntry header{};
+  header.key = LOG_SECTOR_MAGIC;
+  header.type = LOG_RECORD_TYPE_HEADER;
+  header.length = sizeof(uint32_t);
+  memcpy(header.data, &sequence, sizeof(uint32_t));
+  if (!this->write_record_(sector, 0, header))
+    return false;
+
+  size_t slot = 1;
+  for (auto &entry : live) {
+    if (!this->write_record_(sector, slot++, entry))
+      return false;
+  }
+  if (!this->write_commit_(sector, slot++, 1, live.size()))
+    return false;
+
+  this->active_sector_ = sector;
+  this->sequence_ = sequence;
+  this->next_slot_ = slot;
+  this->live_ = live;
+  return true;
+}
+void LogPreferenceBackend::apply_(std::vector<ESPPreferenceEntry> *live, const ESPPreferenceEntry &entry) {
+  auto it = std::lower_bound(live->begin(), live->end(), entry.key,
+                             [](const ESPPreferenceEntry &e, uint32_t k) {
+    return e.key < k;
+  });
+  if (it != live->end() && it->key == entry.key)
+    *it = entry;
+  else
+    live->insert(it, entry);
+}
+
+ESPHOMELIB_NAMESPACE_END
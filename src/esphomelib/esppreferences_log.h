@@ -0,0 +1,143 @@
+//
+//  esppreferences_log.h
+//  esphomelib
+//
+//  Copyright © 2018 Otto Winter. All rights reserved.
+//
+
+#ifndef ESPHOMELIB_ESPPREFERENCES_LOG_H
+#define ESPHOMELIB_ESPPREFERENCES_LOG_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "esphomelib/esppreferences.h"
+#include "esphomelib/defines.h"
+
+ESPHOMELIB_NAMESPACE_BEGIN
+
+/** Interface for a range of raw NOR flash sectors used by LogPreferenceBackend.
+ *
+ * Like real NOR flash, erasing sets all bits of a sector to 1 and writing can only clear bits.
+ * All offsets and lengths are multiples of 4 bytes.
+ */
+class PreferenceFlash {
+ public:
+  virtual size_t get_sector_size() const = 0;
+  virtual size_t get_num_sectors() const = 0;
+  virtual bool read(size_t sector, size_t offset, uint32_t *data, size_t length) = 0;
+  virtual bool write(size_t sector, size_t offset, const uint32_t *data, size_t length) = 0;
+  virtual bool erase(size_t sector) = 0;
+  /// Log which flash region is used.
+  virtual void dump_config() {}
+};
+
+#ifdef ARDUINO_ARCH_ESP8266
+/** Raw flash sectors on the ESP8266.
+ *
+ * The default constructor uses the single sector the Arduino linker scripts reserve for the EEPROM library
+ * (directly after SPIFFS). That's not enough for LogPreferenceBackend, which refuses to start with fewer
+ * than two sectors, so by default preferences aren't stored across reboots on the ESP8266 (like before the
+ * log existed). To store them, reserve at least two sectors in a custom linker script (for example by
+ * shrinking SPIFFS) and pass them to the second constructor:
+ *
+ * ```cpp
+ * global_preferences.set_backend(new LogPreferenceBackend(new ESP8266PreferenceFlash(first_sector, 2)));
+ * ```
+ */
+class ESP8266PreferenceFlash : public PreferenceFlash {
+ public:
+  ESP8266PreferenceFlash();
+  ESP8266PreferenceFlash(uint32_t first_sector, size_t num_sectors);
+
+  size_t get_sector_size() const override;
+  size_t get_num_sectors() const override;
+  bool read(size_t sector, size_t offset, uint32_t *data, size_t length) override;
+  bool write(size_t sector, size_t offset, const uint32_t *data, size_t length) override;
+  bool erase(size_t sector) override;
+  void dump_config() override;
+
+ protected:
+  uint32_t first_sector_;
+  size_t num_sectors_;
+};
+#endif
+
+#ifndef ARDUINO
+/** A flash image stored in a regular file, for testing LogPreferenceBackend on the host.
+ *
+ * Writes behave like NOR flash (they can only clear bits) so that missing erases are caught.
+ */
+class FilePreferenceFlash : public PreferenceFlash {
+ public:
+  FilePreferenceFlash(const std::string &path, size_t num_sectors, size_t sector_size = 4096);
+  ~FilePreferenceFlash();
+
+  size_t get_sector_size() const override;
+  size_t get_num_sectors() const override;
+  bool read(size_t sector, size_t offset, uint32_t *data, size_t length) override;
+  bool write(size_t sector, size_t offset, const uint32_t *data, size_t length) override;
+  bool erase(size_t sector) override;
+
+ protected:
+  FILE *file_{nullptr};
+  size_t num_sectors_;
+  size_t sector_size_;
+};
+#endif
+
+/** Preference storage as an append-only, CRC-checked log on raw flash sectors.
+ *
+ * Each sector starts with a header record (magic + sequence number) followed by fixed-size records,
+ * each being an ESPPreferenceEntry plus its CRC-32. A commit appends all changed entries followed by a
+ * commit record, so a commit that was interrupted by a power loss is ignored completely on the next boot.
+ *
+ * When the active sector is full, all live entries are compacted into the next sector (round-robin).
+ * The old sector stays valid until the compaction's commit record is written, and every sector is only
+ * erased once per full pass through all sectors, which spreads wear evenly. That needs at least two
+ * sectors, begin() fails with fewer. A copy of all live entries is kept in RAM.
+ */
+class LogPreferenceBackend : public ESPPreferenceBackend {
+ public:
+  explicit LogPreferenceBackend(PreferenceFlash *flash);
+
+  bool begin(const std::string &name) override;
+  bool load(uint32_t key, ESPPreferenceEntry *entry) override;
+  bool commit(const std::vector<ESPPreferenceEntry> &entries) override;
+  void dump_config() override;
+
+  /// Return the number of committed, distinct entries.
+  size_t size() const;
+
+ protected:
+  /// An entry plus its CRC as it's stored in flash.
+  struct Record {
+    ESPPreferenceEntry entry;
+    uint32_t crc;
+  };
+
+  size_t slots_per_sector_() const;
+  bool read_record_(size_t sector, size_t slot, Record *record, bool *erased);
+  bool write_record_(size_t sector, size_t slot, const ESPPreferenceEntry &entry);
+  /// Write a commit record for the count records starting at slot start.
+  bool write_commit_(size_t sector, size_t slot, uint32_t start, uint32_t count);
+  /// Read the header of the sector and return whether it's valid.
+  bool read_header_(size_t sector, uint32_t *sequence);
+  /// Replay all committed transactions of the sector into live_, returns false if it has no commit at all.
+  bool replay_(size_t sector);
+  /// Move all live entries to a freshly erased sector.
+  bool compact_(const std::vector<ESPPreferenceEntry> &live);
+  static void apply_(std::vector<ESPPreferenceEntry> *live, const ESPPreferenceEntry &entry);
+
+  PreferenceFlash *flash_;
+  /// All committed entries, sorted by key.
+  std::vector<ESPPreferenceEntry> live_;
+  int active_sector_{-1};
+  uint32_t sequence_{0};
+  size_t next_slot_{0};
+};
+
+ESPHOMELIB_NAMESPACE_END
+
+#endif //ESPHOMELIB_ESPPREFERENCES_LOG_H
@@ -41,7 +41,7 @@ const FanTraits &FanState::get_traits() const {
 void FanState::set_traits(const FanTraits &traits) {
   this->traits_ = traits;
 }
-void FanState::add_on_state_change_callback(std::function<void()> &&update_callback) {
+void FanState::add_on_state_change_callback(InlineFunction<void()> &&update_callback) {
   this->state_callback_.add(std::move(update_callback));
 }
 FanState::FanState(const std::string &name) : Nameable(name) {}
@@ -47,7 +47,7 @@ class FanState : public Nameable {
   explicit FanState(const std::string &name);
 
   /// Register a callback that will be called each time the state changes.
-  void add_on_state_change_callback(std::function<void()> &&update_callback);
+  void add_on_state_change_callback(InlineFunction<void()> &&update_callback);
 
   /// Get the current ON/OFF state of this fan.
   bool get_state() const;
@@ -97,7 +97,7 @@ class TurnOnAction : public Action<T> {
   void set_speed(std::function<FanSpeed(T)> &&speed);
   void set_speed(FanSpeed speed);
 
-  void play(T x) override;
+  bool play(T x) override;
 
  protected:
   FanState *state_;
@@ -110,7 +110,7 @@ class TurnOffAction : public Action<T> {
  public:
   explicit TurnOffAction(FanState *state);
 
-  void play(T x) override;
+  bool play(T x) override;
  protected:
   FanState *state_;
 };
@@ -120,7 +120,7 @@ class ToggleAction : public Action<T> {
  public:
   explicit ToggleAction(FanState *state);
 
-  void play(T x) override;
+  bool play(T x) override;
  protected:
   FanState *state_;
 };
@@ -130,9 +130,9 @@ ToggleAction<T>::ToggleAction(FanState *state) : state_(state) {
 
 }
 template<typename T>
-void ToggleAction<T>::play(T x) {
+bool ToggleAction<T>::play(T x) {
   this->state_->set_state(!this->state_->get_state());
-  this->play_next(x);
+  return true;
 }
 
 template<typename T>
@@ -156,7 +156,7 @@ void TurnOnAction<T>::set_speed(FanSpeed speed) {
   this->speed_ = speed;
 }
 template<typename T>
-void TurnOnAction<T>::play(T x) {
+bool TurnOnAction<T>::play(T x) {
   this->state_->set_state(true);
   if (this->oscillating_.has_value()) {
     this->state_->set_oscillating(this->oscillating_.value(x));
@@ -164,7 +164,7 @@ void TurnOnAction<T>::play(T x) {
   if (this->speed_.has_value()) {
     this->state_->set_speed(this->speed_.value(x));
   }
-  this->play_next(x);
+  return true;
 }
 
 template<typename T>
@@ -172,9 +172,9 @@ TurnOffAction<T>::TurnOffAction(FanState *state) : state_(state) {
 
 }
 template<typename T>
-void TurnOffAction<T>::play(T x) {
+bool TurnOffAction<T>::play(T x) {
   this->state_->set_state(false);
-  this->play_next(x);
+  return true;
 }
 
 template<typename T>
@@ -13,6 +13,7 @@
 
 #include "esphomelib/espmath.h"
 #include "esphomelib/helpers.h"
+#include "esphomelib/crc.h"
 #include "esphomelib/log.h"
 #include "esphomelib/esphal.h"
 
@@ -100,6 +101,10 @@ void ExponentialMovingAverage::set_alpha(float alpha) {
   this->alpha_ = alpha;
 }
 
+bool ExponentialMovingAverage::has_value() const {
+  return !this->first_value_;
+}
+
 float ExponentialMovingAverage::calculate_average() {
   return this->accumulator_;
 }
@@ -142,6 +147,17 @@ float SlidingWindowMovingAverage::calculate_average() {
     return this->sum_ / this->queue_.size();
 }
 
+std::vector<float> SlidingWindowMovingAverage::get_values() const {
+  std::vector<float> values;
+  std::queue<float> copy = this->queue_;
+  values.reserve(copy.size());
+  while (!copy.empty()) {
+    values.push_back(copy.front());
+    copy.pop();
+  }
+  return values;
+}
+
 size_t SlidingWindowMovingAverage::get_max_size() const {
   return this->max_size_;
 }
@@ -213,7 +229,7 @@ void reboot(const char *cause) {
   run_shutdown_hooks(cause);
   ESP.restart();
 }
-void add_shutdown_hook(std::function<void(const char *)> &&f) {
+void add_shutdown_hook(InlineFunction<void(const char *)> &&f) {
   shutdown_hooks.add(std::move(f));
 }
 void safe_reboot(const char *cause) {
@@ -221,7 +237,7 @@ void safe_reboot(const char *cause) {
   run_safe_shutdown_hooks(cause);
   ESP.restart();
 }
-void add_safe_shutdown_hook(std::function<void(const char *)> &&f) {
+void add_safe_shutdown_hook(InlineFunction<void(const char *)> &&f) {
   safe_shutdown_hooks.add(std::move(f));
 }
 
@@ -252,19 +268,16 @@ void enable_interrupts() {
 }
 
 uint8_t crc8(uint8_t *data, uint8_t len) {
-  uint8_t crc = 0;
-
-  while ((len--) != 0u) {
-    uint8_t inbyte = *data++;
-    for (uint8_t i = 8; i != 0u; i--) {
-      bool mix = (crc ^ inbyte) & 0x01;
-      crc >>= 1;
-      if (mix)
-        crc ^= 0x8C;
-      inbyte >>= 1;
-    }
+  return crc8_dallas(data, len);
+}
+
+uint32_t fnv1a_hash(const std::string &str, uint32_t basis) {
+  uint32_t hash = basis;
+  for (char c : str) {
+    hash ^= uint8_t(c);
+    hash *= 16777619UL;
   }
-  return crc;
+  return hash;
 }
 
 ESPHOMELIB_NAMESPACE_END
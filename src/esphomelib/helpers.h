@@ -8,12 +8,15 @@
 #include <string>
 #include <IPAddress.h>
 #include <memory>
+#include <new>
 #include <queue>
+#include <vector>
 #include <functional>
 #include <ArduinoJson.h>
 
 #include "esphomelib/esphal.h"
 #include "esphomelib/defines.h"
+#include "esphomelib/inline_function.h"
 #include "esphomelib/optional.h"
 
 #ifndef JSON_BUFFER_SIZE
@@ -50,7 +53,7 @@ bool is_empty(const IPAddress &address);
 void reboot(const char *cause);
 
 /// Add a shutdown callback.
-void add_shutdown_hook(std::function<void(const char *)> &&f);
+void add_shutdown_hook(InlineFunction<void(const char *)> &&f);
 
 /// Create a safe shutdown (and reboot) of the ESP, calling any registered shutdown and safe shutdown hooks.
 void safe_reboot(const char *cause);
@@ -59,7 +62,7 @@ void safe_reboot(const char *cause);
 void run_shutdown_hooks(const char *cause);
 
 /// Add a safe shutdown callback that will be called if the device is shut down intentionally.
-void add_safe_shutdown_hook(std::function<void(const char *)> &&f);
+void add_safe_shutdown_hook(InlineFunction<void(const char *)> &&f);
 
 /// Run safe shutdown and force shutdown hooks.
 void run_safe_shutdown_hooks(const char *cause);
@@ -137,9 +140,19 @@ void disable_interrupts();
 /// Cross-platform method to enable interrupts after they have been disabled.
 void enable_interrupts();
 
-/// Calculate a crc8 of data with the provided data length.
+/// Calculate a crc8 of data with the provided data length. Same as crc8_dallas() from crc.h.
 uint8_t crc8(uint8_t *data, uint8_t len);
 
+/** Calculate the 32-bit FNV-1a hash of str.
+ *
+ * Unlike std::hash, the result is stable across platforms and compiler versions so it can be used
+ * for keys that are persisted in flash.
+ *
+ * @param str The string to hash.
+ * @param basis The offset basis, pass a different value to get a second, independent hash.
+ */
+uint32_t fnv1a_hash(const std::string &str, uint32_t basis = 2166136261UL);
+
 optional<bool> parse_on_off(const char *str, const char *payload_on = "on", const char *payload_off = "off");
 
 /// Helper class that implements a sliding window moving average.
@@ -164,6 +177,9 @@ class SlidingWindowMovingAverage {
   size_t get_max_size() const;
   void set_max_size(size_t max_size);
 
+  /// Return a copy of all values currently in the window, oldest first.
+  std::vector<float> get_values() const;
+
  protected:
   std::queue<float> queue_;
   size_t max_size_;
@@ -182,6 +198,9 @@ class ExponentialMovingAverage {
   void set_alpha(float alpha);
   float get_alpha() const;
 
+  /// Return whether this average has received at least one value.
+  bool has_value() const;
+
  protected:
   bool first_value_{true};
   float alpha_;
@@ -192,6 +211,8 @@ template<typename... X> class CallbackManager;
 
 
 /** Simple helper class to allow having multiple subscribers to a signal.
+ *
+ * Callbacks are stored as InlineFunction, so lambdas capturing a few pointers don't need any heap allocation.
  *
  * @tparam Ts The arguments for the callback, wrapped in void().
  */
@@ -199,52 +220,53 @@ template<typename... Ts>
 class CallbackManager<void(Ts...)> {
  public:
   /// Add a callback to the internal callback list.
-  void add(std::function<void(Ts...)> &&callback);
+  void add(InlineFunction<void(Ts...)> &&callback);
 
   /// Call all callbacks in this manager.
   void call(Ts... args);
 
  protected:
-  std::vector<std::function<void(Ts...)>> callbacks_;
+  std::vector<InlineFunction<void(Ts...)>> callbacks_;
 };
 
+/** A value of type T that's either a constant or computed by a lambda from a trigger value of type X.
+ *
+ * Automations embed many of these (delays, MQTT topics, light brightness, ...) and most of them are
+ * constants. So only one of the two representations is stored: constants inline, lambdas behind an owned
+ * pointer. A constant only costs sizeof(T) and a tag instead of also carrying an empty std::function.
+ */
 template<typename T, typename X>
 class TemplatableValue {
  public:
-  TemplatableValue() : type_(EMPTY) {
-
-  }
-
-  TemplatableValue(T const &value) : type_(VALUE), value_(value) {
-
-  }
-
-  TemplatableValue(std::function<T(X)> f) : type_(LAMBDA), f_(f) {
+  TemplatableValue();
+  TemplatableValue(T const &value); // NOLINT
+  TemplatableValue(std::function<T(X)> f); // NOLINT
+  TemplatableValue(const TemplatableValue &other);
+  TemplatableValue(TemplatableValue &&other) noexcept;
+  TemplatableValue &operator=(const TemplatableValue &other);
+  TemplatableValue &operator=(TemplatableValue &&other) noexcept;
+  ~TemplatableValue();
 
-  }
+  bool has_value() const;
 
-  bool has_value() {
-    return this->type_ != EMPTY;
-  }
-
-  T value(X x) {
-    if (this->type_ == LAMBDA) {
-      return this->f_(x);
-    } else {
-      // return value also when empty
-      return this->value_;
-    }
-  }
+  /// Get the value for the trigger value x, a default-constructed T if empty.
+  T value(X x) const;
 
  protected:
-  enum {
+  void assign_(const TemplatableValue &other);
+  void assign_(TemplatableValue &&other);
+  void reset_();
+
+  enum : uint8_t {
     EMPTY,
     VALUE,
     LAMBDA,
-  } type_;
+  } type_{EMPTY};
 
-  T value_;
-  std::function<T(X)> f_;
+  union {
+    T value_;
+    std::function<T(X)> *f_;
+  };
 };
 
 extern CallbackManager<void(const char *)> shutdown_hooks;
@@ -272,8 +294,89 @@ std::unique_ptr<T> make_unique(Args &&...args) {
   return std::unique_ptr<T>(new T(std::forward<Args>(args)...));
 }
 
+template<typename T, typename X>
+TemplatableValue<T, X>::TemplatableValue() {}
+template<typename T, typename X>
+TemplatableValue<T, X>::TemplatableValue(T const &value) : type_(VALUE) {
+  new (&this->value_) T(value);
+}
+template<typename T, typename X>
+TemplatableValue<T, X>::TemplatableValue(std::function<T(X)> f) {
+  if (f) {
+    this->type_ = LAMBDA;
+    this->f_ = new std::function<T(X)>(std::move(f));
+  }
+}
+template<typename T, typename X>
+TemplatableValue<T, X>::TemplatableValue(const TemplatableValue &other) {
+  this->assign_(other);
+}
+template<typename T, typename X>
+TemplatableValue<T, X>::TemplatableValue(TemplatableValue &&other) noexcept {
+  this->assign_(std::move(other));
+}
+template<typename T, typename X>
+TemplatableValue<T, X> &TemplatableValue<T, X>::operator=(const TemplatableValue &other) {
+  if (this != &other) {
+    this->reset_();
+    this->assign_(other);
+  }
+  return *this;
+}
+template<typename T, typename X>
+TemplatableValue<T, X> &TemplatableValue<T, X>::operator=(TemplatableValue &&other) noexcept {
+  if (this != &other) {
+    this->reset_();
+    this->assign_(std::move(other));
+  }
+  return *this;
+}
+template<typename T, typename X>
+TemplatableValue<T, X>::~TemplatableValue() {
+  this->reset_();
+}
+template<typename T, typename X>
+bool TemplatableValue<T, X>::has_value() const {
+  return this->type_ != EMPTY;
+}
+template<typename T, typename X>
+T TemplatableValue<T, X>::value(X x) const {
+  switch (this->type_) {
+    case VALUE: return this->value_;
+    case LAMBDA: return (*this->f_)(x);
+    default: return T();
+  }
+}
+template<typename T, typename X>
+void TemplatableValue<T, X>::assign_(const TemplatableValue &other) {
+  this->type_ = other.type_;
+  if (other.type_ == VALUE)
+    new (&this->value_) T(other.value_);
+  else if (other.type_ == LAMBDA)
+    this->f_ = new std::function<T(X)>(*other.f_);
+}
+template<typename T, typename X>
+void TemplatableValue<T, X>::assign_(TemplatableValue &&other) {
+  this->type_ = other.type_;
+  if (other.type_ == VALUE) {
+    new (&this->value_) T(std::move(other.value_));
+  } else if (other.type_ == LAMBDA) {
+    // Take over the lambda, other doesn't own it anymore.
+    this->f_ = other.f_;
+    other.type_ = EMPTY;
+  }
+}
+template<typename T, typename X>
+void TemplatableValue<T, X>::reset_() {
+  if (this->type_ == VALUE)
+    this->value_.~T();
+  else if (this->type_ == LAMBDA)
+    delete this->f_;
+  this->type_ = EMPTY;
+}
+
 template<typename... Ts>
-void CallbackManager<void(Ts...)>::add(std::function<void(Ts...)> &&callback) {
+void CallbackManager<void(Ts...)>::add(InlineFunction<void(Ts...)> &&callback) {
   this->callbacks_.push_back(std::move(callback));
 }
 template<typename... Ts>
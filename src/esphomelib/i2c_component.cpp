@@ -9,12 +9,22 @@
 #include "esphomelib/i2c_component.h"
 #include "esphomelib/log.h"
 
+#include <algorithm>
+#include <cstdio>
+
 #ifdef USE_I2C
 
 ESPHOMELIB_NAMESPACE_BEGIN
 
 static const char *TAG = "i2c";
 
+/// The maximum number of bytes the Wire library can receive in a single request.
+#ifdef I2C_BUFFER_LENGTH
+static const uint8_t MAX_REQUEST_LENGTH = I2C_BUFFER_LENGTH;
+#else
+static const uint8_t MAX_REQUEST_LENGTH = BUFFER_LENGTH;
+#endif
+
 I2CComponent::I2CComponent(uint8_t sda_pin, uint8_t scl_pin, bool scan)
     : sda_pin_(sda_pin), scl_pin_(scl_pin), scan_(scan) {
 #ifdef ARDUINO_ARCH_ESP32
@@ -44,6 +54,12 @@ void I2CComponent::set_frequency(uint32_t frequency) {
 void I2CComponent::setup() {
   this->wire_->begin(this->sda_pin_, this->scl_pin_);
   this->wire_->setClock(this->frequency_);
+
+  if (this->stats_interval_ != 0) {
+    this->set_interval("stats", this->stats_interval_, [this]() {
+      this->dump_stats();
+    });
+  }
 }
 void I2CComponent::loop() {
   if (this->scan_) {
@@ -62,6 +78,95 @@ void I2CComponent::loop() {
       delay(1);
     }
   }
+
+  for (size_t i = 0; i < this->queue_.size();) {
+    QueuedTransaction &transaction = this->queue_[i];
+    // Only the oldest transaction of each device is active.
+    bool blocked = false;
+    for (size_t j = 0; j < i && !blocked; j++)
+      blocked = this->queue_[j].address == transaction.address;
+    if (blocked || int32_t(millis() - transaction.ready_at) < 0) {
+      i++;
+      continue;
+    }
+
+    bool success = this->run_steps_(&transaction);
+    if (success && transaction.step < transaction.transaction.steps_.size()) {
+      // Waiting, continue later.
+      i++;
+      continue;
+    }
+
+    // Move the transaction out of the queue first, the callback may enqueue new transactions.
+    QueuedTransaction done = std::move(transaction);
+    this->queue_.erase(this->queue_.begin() + i);
+    const uint32_t latency = millis() - done.enqueued_at;
+    I2CDeviceStats &stats = this->get_stats_(done.address);
+    stats.transactions++;
+    stats.total_latency += latency;
+    stats.max_latency = std::max(stats.max_latency, latency);
+    if (done.transaction.callback_)
+      done.transaction.callback_(success, done.result);
+  }
+}
+void I2CComponent::enqueue(uint8_t address, I2CTransaction transaction) {
+  QueuedTransaction queued;
+  queued.address = address;
+  queued.transaction = std::move(transaction);
+  queued.step = 0;
+  queued.ready_at = queued.enqueued_at = millis();
+  this->queue_.push_back(std::move(queued));
+}
+bool I2CComponent::run_steps_(QueuedTransaction *transaction) {
+  const uint32_t start = micros();
+  const std::vector<I2CStep> &steps = transaction->transaction.steps_;
+  bool success = true;
+  while (success && transaction->step < steps.size()) {
+    const I2CStep &step = steps[transaction->step++];
+    if (step.type == I2C_STEP_WAIT) {
+      transaction->ready_at = millis() + step.value;
+      break;
+    }
+    if (step.type == I2C_STEP_WRITE) {
+      this->begin_transmission_(transaction->address);
+      this->write_(transaction->address, step.data.data(), step.data.size());
+      success = this->end_transmission_(transaction->address);
+    } else {
+      const size_t offset = transaction->result.size();
+      transaction->result.resize(offset + step.value);
+      success = this->receive_(transaction->address, transaction->result.data() + offset, step.value);
+    }
+  }
+  this->get_stats_(transaction->address).bus_time_us += micros() - start;
+  return success;
+}
+I2CDeviceStats &I2CComponent::get_stats_(uint8_t address) {
+  for (auto &stats : this->stats_) {
+    if (stats.address == address)
+      return stats;
+  }
+  I2CDeviceStats stats{};
+  stats.address = address;
+  this->stats_.push_back(stats);
+  return this->stats_.back();
+}
+const I2CDeviceStats *I2CComponent::get_stats(uint8_t address) const {
+  for (auto &stats : this->stats_) {
+    if (stats.address == address)
+      return &stats;
+  }
+  return nullptr;
+}
+void I2CComponent::dump_stats() {
+  ESP_LOGI(TAG, "i2c device statistics (%u queued transactions):", this->queue_.size());
+  for (auto &stats : this->stats_) {
+    uint32_t avg_latency = stats.transactions == 0 ? 0 : stats.total_latency / stats.transactions;
+    ESP_LOGI(TAG, "    0x%02X: transactions=%u failures=%u bus_time=%uus latency avg=%ums max=%ums",
+             stats.address, stats.transactions, stats.failures, stats.bus_time_us, avg_latency, stats.max_latency);
+  }
+}
+void I2CComponent::set_stats_interval(uint32_t stats_interval) {
+  this->stats_interval_ = stats_interval;
 }
 float I2CComponent::get_setup_priority() const {
   return setup_priority::HARDWARE + 10.0f;
@@ -93,6 +198,8 @@ bool I2CComponent::end_transmission_(uint8_t address) {
       ESP_LOGW(TAG, "Unknown transmit error %u for address 0x%02X", status, address);
       break;
   }
+  if (status != 0)
+    this->get_stats_(address).failures++;
 
   return status == 0;
 }
@@ -101,6 +208,7 @@ bool I2CComponent::request_from_(uint8_t address, uint8_t len) {
   uint8_t ret = this->wire_->requestFrom(address, len);
   if (ret != len) {
     ESP_LOGW(TAG, "Requesting %u bytes from 0x%02X failed!", len, address);
+    this->get_stats_(address).failures++;
     return false;
   }
   return true;
@@ -124,22 +232,36 @@ void I2CComponent::write_16_(uint8_t address, const uint16_t *data, uint8_t len)
 bool I2CComponent::receive_(uint8_t address, uint8_t *data, uint8_t len) {
   if (!this->request_from_(address, len))
     return false;
-  for (uint8_t i = 0; i < len; i++) {
+  for (uint8_t i = 0; i < len; i++)
     data[i] = this->wire_->read();
-    ESP_LOGVV(TAG, "    Received 0b" BYTE_TO_BINARY_PATTERN " (0x%02X)",
-              BYTE_TO_BINARY(data[i]), data[i]);
+
+  if_very_verbose {
+    // One log line per request, not per byte.
+    char hex[3 * 32 + 1] = "";
+    size_t pos = 0;
+    for (uint8_t i = 0; i < len && pos + 4 <= sizeof(hex); i++)
+      pos += sprintf(hex + pos, "%02X ", data[i]);
+    ESP_LOGVV(TAG, "    Received %u bytes: %s%s", len, hex, len > 32 ? "..." : "");
   }
   return true;
 }
 bool I2CComponent::receive_16_(uint8_t address, uint16_t *data, uint8_t len) {
-  if (!this->request_from_(address, len * 2))
-    return false;
   auto *data_8 = reinterpret_cast<uint8_t *>(data);
-  for (uint8_t i = 0; i < len; i++) {
-    data_8[i * 2 + 1] = this->wire_->read();
-    data_8[i + 2] = this->wire_->read();
-    ESP_LOGVV(TAG, "    Received 0b" BYTE_TO_BINARY_PATTERN BYTE_TO_BINARY_PATTERN " (0x%04X)",
-              BYTE_TO_BINARY(data_8[i * 2 + 1]), BYTE_TO_BINARY(data_8[i * 2]), data[i]);
+  if (!this->receive_(address, data_8, len * 2))
+    return false;
+  // The words are sent MSB first, convert them in place.
+  for (uint8_t i = 0; i < len; i++)
+    data[i] = (uint16_t(data_8[i * 2]) << 8) | data_8[i * 2 + 1];
+  return true;
+}
+bool I2CComponent::read_block(uint8_t address, uint8_t register_, uint8_t *data, size_t len) {
+  while (len > 0) {
+    const uint8_t chunk = std::min(len, size_t(MAX_REQUEST_LENGTH));
+    if (!this->read_bytes(address, register_, data, chunk))
+      return false;
+    register_ += chunk;
+    data += chunk;
+    len -= chunk;
   }
   return true;
 }
@@ -195,6 +317,9 @@ void I2CDevice::set_address(uint8_t address) {
 bool I2CDevice::read_bytes(uint8_t register_, uint8_t *data, uint8_t len, uint32_t conversion) {
   return this->parent_->read_bytes(this->address_, register_, data, len, conversion);
 }
+bool I2CDevice::read_block(uint8_t register_, uint8_t *data, size_t len) {
+  return this->parent_->read_block(this->address_, register_, data, len);
+}
 bool I2CDevice::read_byte(uint8_t register_, uint8_t *data, uint32_t conversion) {
   return this->parent_->read_byte(this->address_, register_, data, conversion);
 }
@@ -219,6 +344,35 @@ bool I2CDevice::write_byte_16(uint8_t register_, uint16_t data) {
 void I2CDevice::set_parent(I2CComponent *parent) {
   this->parent_ = parent;
 }
+void I2CDevice::enqueue(I2CTransaction transaction) {
+  this->parent_->enqueue(this->address_, std::move(transaction));
+}
+
+I2CTransaction &I2CTransaction::write(uint8_t register_, const uint8_t *data, uint8_t len) {
+  I2CStep step{I2C_STEP_WRITE, 0, {register_}};
+  step.data.insert(step.data.end(), data, data + len);
+  this->steps_.push_back(std::move(step));
+  return *this;
+}
+I2CTransaction &I2CTransaction::write_byte(uint8_t register_, uint8_t data) {
+  return this->write(register_, &data, 1);
+}
+I2CTransaction &I2CTransaction::write_byte_16(uint8_t register_, uint16_t data) {
+  const uint8_t data8[2] = {uint8_t(data >> 8), uint8_t(data)};
+  return this->write(register_, data8, 2);
+}
+I2CTransaction &I2CTransaction::wait(uint32_t ms) {
+  this->steps_.push_back(I2CStep{I2C_STEP_WAIT, ms, {}});
+  return *this;
+}
+I2CTransaction &I2CTransaction::read(uint8_t len) {
+  this->steps_.push_back(I2CStep{I2C_STEP_READ, len, {}});
+  return *this;
+}
+I2CTransaction &I2CTransaction::then(callback_t &&callback) {
+  this->callback_ = std::move(callback);
+  return *this;
+}
 
 #ifdef ARDUINO_ARCH_ESP32
   uint8_t next_i2c_bus_num_ = 0;
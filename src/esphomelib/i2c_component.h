@@ -15,9 +15,71 @@
 #ifdef USE_I2C
 
 #include <Wire.h>
+#include <functional>
+#include <vector>
 
 ESPHOMELIB_NAMESPACE_BEGIN
 
+class I2CComponent;
+
+enum I2CStepType : uint8_t {
+  I2C_STEP_WRITE = 0,
+  I2C_STEP_WAIT,
+  I2C_STEP_READ,
+};
+
+/// Internal struct for a single step of an I2CTransaction.
+struct I2CStep {
+  I2CStepType type;
+  uint32_t value; ///< The time to wait in ms for waits, the number of bytes for reads.
+  std::vector<uint8_t> data; ///< The register followed by the data for writes.
+};
+
+/** A multi-step transaction for a single i2c device, executed asynchronously by I2CComponent::enqueue().
+ *
+ * Build it with the chainable methods, for example:
+ *
+ * ```cpp
+ * this->enqueue(I2CTransaction().write(REGISTER_MEASURE).wait(9).read(2).then(
+ *     [this](bool success, const std::vector<uint8_t> &data) { ... }));
+ * ```
+ *
+ * The bytes of all read steps are concatenated and passed to the callback.
+ */
+class I2CTransaction {
+ public:
+  using callback_t = std::function<void(bool success, const std::vector<uint8_t> &data)>;
+
+  /// Write the register number followed by len bytes of data.
+  I2CTransaction &write(uint8_t register_, const uint8_t *data = nullptr, uint8_t len = 0);
+  /// Write a single byte of data into the register.
+  I2CTransaction &write_byte(uint8_t register_, uint8_t data);
+  /// Write a single 16-bit word of data (MSB first) into the register.
+  I2CTransaction &write_byte_16(uint8_t register_, uint16_t data);
+  /// Wait ms milliseconds (for example for a conversion), other devices can use the bus meanwhile.
+  I2CTransaction &wait(uint32_t ms);
+  /// Read len bytes from the device.
+  I2CTransaction &read(uint8_t len);
+  /// Set the callback that's called with the result once the transaction is complete or has failed.
+  I2CTransaction &then(callback_t &&callback);
+
+ protected:
+  friend I2CComponent;
+
+  std::vector<I2CStep> steps_;
+  callback_t callback_;
+};
+
+/// Statistics about the communication with a single i2c device.
+struct I2CDeviceStats {
+  uint8_t address;
+  uint32_t transactions; ///< The number of completed queued transactions.
+  uint32_t failures; ///< NACKs and short reads, both for queued transactions and direct access.
+  uint32_t bus_time_us; ///< The time queued transactions have spent on the bus.
+  uint32_t total_latency; ///< The sum of the times (in ms) from enqueueing to completion.
+  uint32_t max_latency; ///< The longest time (in ms) from enqueueing to completion.
+};
+
 /** The I2CComponent is the base of esphomelib's i2c communication.
  *
  * It handles setting up the bus (with pins, clock frequency) and provides nice helper functions to
@@ -68,6 +130,14 @@ class I2CComponent : public Component {
    */
   bool read_bytes_16(uint8_t address, uint8_t register_, uint16_t *data, uint8_t len, uint32_t conversion = 0);
 
+  /** Read a block of len bytes from consecutive registers, starting at register_.
+   *
+   * Unlike read_bytes, len may exceed the buffer size of the Wire library. Larger blocks are split into
+   * multiple requests, each starting at the register following the previous one. So this requires
+   * the device to auto-increment the register address.
+   */
+  bool read_block(uint8_t address, uint8_t register_, uint8_t *data, size_t len);
+
   /// Read a single byte from a register into the data variable. Return true if successful.
   bool read_byte(uint8_t address, uint8_t register_, uint8_t *data, uint32_t conversion = 0);
 
@@ -100,6 +170,23 @@ class I2CComponent : public Component {
   /// Write a single 16-bit word of data into the specified register of address. Return true if successful.
   bool write_byte_16(uint8_t address, uint8_t register_, uint16_t data);
 
+  /** Queue a transaction for the device at address.
+   *
+   * Transactions are executed in loop() and never block on their waits: while one transaction
+   * waits for a conversion, transactions for other devices use the bus. Transactions for the same
+   * device are executed in the order they were enqueued.
+   */
+  void enqueue(uint8_t address, I2CTransaction transaction);
+
+  /// Get the statistics of the device at address, nullptr if there hasn't been any communication with it.
+  const I2CDeviceStats *get_stats(uint8_t address) const;
+
+  /// Log the statistics of all devices.
+  void dump_stats();
+
+  /// Set the interval in ms at which the device statistics are logged, 0 (the default) to disable.
+  void set_stats_interval(uint32_t stats_interval);
+
   // ========== INTERNAL METHODS ==========
   // (In most use cases you won't need these)
   /// Begin a write transmission to an address.
@@ -125,17 +212,39 @@ class I2CComponent : public Component {
   /// Request len amount of bytes from address and write the result it into data. Returns true iff was successful.
   bool receive_(uint8_t address, uint8_t *data, uint8_t len);
 
-  /// Request len amount of 16-bit words from address and write the result into data. Returns true iff was successful.
+  /** Request len amount of 16-bit words (MSB first) from address and write the result into data.
+   *
+   * All words are received in a single request and converted in place, len must be at most 127.
+   * Returns true iff was successful.
+   */
   bool receive_16_(uint8_t address, uint16_t *data, uint8_t len);
 
   /// Setup the i2c. bus
   void setup() override;
-  /// Do an address range scan if necessary.
+  /// Do an address range scan if necessary and execute queued transactions.
   void loop() override;
   /// Set a very high setup priority to make sure it's loaded before all other hardware.
   float get_setup_priority() const override;
 
  protected:
+  struct QueuedTransaction {
+    uint8_t address;
+    I2CTransaction transaction;
+    size_t step;
+    uint32_t ready_at;
+    uint32_t enqueued_at;
+    std::vector<uint8_t> result;
+  };
+
+  /// Run the steps of the transaction up to the next wait. Returns false if a step failed.
+  bool run_steps_(QueuedTransaction *transaction);
+
+  /// Get the statistics for address, creating them if necessary.
+  I2CDeviceStats &get_stats_(uint8_t address);
+
+  std::vector<QueuedTransaction> queue_;
+  std::vector<I2CDeviceStats> stats_;
+  uint32_t stats_interval_{0};
   TwoWire *wire_;
   uint8_t sda_pin_;
   uint8_t scl_pin_;
@@ -187,6 +296,9 @@ class I2CDevice {
    */
   bool read_bytes_16(uint8_t register_, uint16_t *data, uint8_t len, uint32_t conversion = 0);
 
+  /// Read a block of len bytes from consecutive registers, see I2CComponent::read_block().
+  bool read_block(uint8_t register_, uint8_t *data, size_t len);
+
   /// Read a single byte from a register into the data variable. Return true if successful.
   bool read_byte(uint8_t register_, uint8_t *data, uint32_t conversion = 0);
 
@@ -217,6 +329,9 @@ class I2CDevice {
   /// Write a single 16-bit word of data into the specified register. Return true if successful.
   bool write_byte_16(uint8_t register_, uint16_t data);
 
+  /// Queue a transaction for this device, see I2CComponent::enqueue().
+  void enqueue(I2CTransaction transaction);
+
   uint8_t address_;
   I2CComponent *parent_;
 };
@@ -0,0 +1,169 @@
+//
+//  inline_function.h
+//  esphomelib
+//
+//  Copyright © 2018 Otto Winter. All rights reserved.
+//
+
+#ifndef ESPHOMELIB_INLINE_FUNCTION_H
+#define ESPHOMELIB_INLINE_FUNCTION_H
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "esphomelib/defines.h"
+
+ESPHOMELIB_NAMESPACE_BEGIN
+
+/// The default size of the inline storage of InlineFunction, enough for a std::function or a lambda capturing 4 pointers.
+const size_t INLINE_FUNCTION_DEFAULT_SIZE = 4 * sizeof(void *);
+
+template<typename Signature, size_t SIZE = INLINE_FUNCTION_DEFAULT_SIZE>
+class InlineFunction;
+
+/** A move-only replacement for std::function that stores the callable inside the object itself.
+ *
+ * The ESP8266 toolchain's libstdc++ only stores plain function pointers inside std::function, every
+ * lambda (even one only capturing `this`) is copied to the heap. Callbacks are registered once and
+ * live forever, so that's a lot of small allocations that fragment the little heap there is.
+ *
+ * InlineFunction instead constructs the callable in a fixed buffer of SIZE bytes. Callables that don't
+ * fit are wrapped in a std::function first (which then allocates like before), so anything that can
+ * be passed as a std::function can also be passed as an InlineFunction, including std::function itself.
+ *
+ * @tparam R The return type.
+ * @tparam Args The argument types.
+ * @tparam SIZE The size of the inline storage in bytes.
+ */
+template<typename R, typename... Args, size_t SIZE>
+class InlineFunction<R(Args...), SIZE> {
+ public:
+  InlineFunction() = default;
+  InlineFunction(std::nullptr_t) {} // NOLINT
+
+  /// Store a copy of the callable f.
+  template<typename F, typename = typename std::enable_if<
+      !std::is_same<typename std::decay<F>::type, InlineFunction>::value>::type>
+  InlineFunction(F &&f) { // NOLINT
+    this->emplace_(std::forward<F>(f), std::integral_constant<bool, fits<typename std::decay<F>::type>()>());
+  }
+
+  InlineFunction(InlineFunction &&other) noexcept;
+  InlineFunction &operator=(InlineFunction &&other) noexcept;
+  InlineFunction(const InlineFunction &) = delete;
+  InlineFunction &operator=(const InlineFunction &) = delete;
+  ~InlineFunction();
+
+  /// Call the stored callable, must not be empty.
+  R operator()(Args... args) const;
+
+  /// Return whether a callable is stored.
+  explicit operator bool() const;
+
+  /// Return whether a callable of type F is stored inline, without allocating.
+  template<typename F>
+  static constexpr bool fits() {
+    return sizeof(F) <= SIZE && alignof(F) <= alignof(Storage);
+  }
+
+ protected:
+  using Storage = typename std::aligned_storage<SIZE>::type;
+
+  /// How to call, move and destroy a callable of one type, one static instance per type.
+  struct Operations {
+    R (*invoke)(void *f, Args... args);
+    void (*move)(void *dst, void *src);
+    void (*destroy)(void *f);
+  };
+
+  template<typename F>
+  struct OperationsFor {
+    static R invoke(void *f, Args... args) {
+      return (*static_cast<F *>(f))(std::forward<Args>(args)...);
+    }
+    static void move(void *dst, void *src) {
+      new (dst) F(std::move(*static_cast<F *>(src)));
+      static_cast<F *>(src)->~F();
+    }
+    static void destroy(void *f) {
+      static_cast<F *>(f)->~F();
+    }
+    static const Operations OPERATIONS;
+  };
+
+  template<typename F>
+  void emplace_(F &&f, std::true_type /* fits */);
+  template<typename F>
+  void emplace_(F &&f, std::false_type /* fits */);
+  void reset_();
+
+  mutable Storage storage_;
+  const Operations *operations_{nullptr};
+};
+
+template<typename R, typename... Args, size_t SIZE>
+template<typename F>
+const typename InlineFunction<R(Args...), SIZE>::Operations
+    InlineFunction<R(Args...), SIZE>::OperationsFor<F>::OPERATIONS = {
+    &OperationsFor<F>::invoke, &OperationsFor<F>::move, &OperationsFor<F>::destroy,
+};
+
+template<typename R, typename... Args, size_t SIZE>
+InlineFunction<R(Args...), SIZE>::InlineFunction(InlineFunction &&other) noexcept {
+  if (other.operations_ != nullptr) {
+    other.operations_->move(&this->storage_, &other.storage_);
+    this->operations_ = other.operations_;
+    other.operations_ = nullptr;
+  }
+}
+template<typename R, typename... Args, size_t SIZE>
+InlineFunction<R(Args...), SIZE> &InlineFunction<R(Args...), SIZE>::operator=(InlineFunction &&other) noexcept {
+  if (this != &other) {
+    this->reset_();
+    if (other.operations_ != nullptr) {
+      other.operations_->move(&this->storage_, &other.storage_);
+      this->operations_ = other.operations_;
+      other.operations_ = nullptr;
+    }
+  }
+  return *this;
+}
+template<typename R, typename... Args, size_t SIZE>
+InlineFunction<R(Args...), SIZE>::~InlineFunction() {
+  this->reset_();
+}
+template<typename R, typename... Args, size_t SIZE>
+R InlineFunction<R(Args...), SIZE>::operator()(Args... args) const {
+  return this->operations_->invoke(&this->storage_, std::forward<Args>(args)...);
+}
+template<typename R, typename... Args, size_t SIZE>
+InlineFunction<R(Args...), SIZE>::operator bool() const {
+  return this->operations_ != nullptr;
+}
+template<typename R, typename... Args, size_t SIZE>
+template<typename F>
+void InlineFunction<R(Args...), SIZE>::emplace_(F &&f, std::true_type) {
+  using T = typename std::decay<F>::type;
+  new (&this->storage_) T(std::forward<F>(f));
+  this->operations_ = &OperationsFor<T>::OPERATIONS;
+}
+template<typename R, typename... Args, size_t SIZE>
+template<typename F>
+void InlineFunction<R(Args...), SIZE>::emplace_(F &&f, std::false_type) {
+  static_assert(fits<std::function<R(Args...)>>(), "InlineFunction storage must be large enough for a std::function");
+  this->emplace_(std::function<R(Args...)>(std::forward<F>(f)), std::true_type());
+}
+template<typename R, typename... Args, size_t SIZE>
+void InlineFunction<R(Args...), SIZE>::reset_() {
+  if (this->operations_ != nullptr) {
+    this->operations_->destroy(&this->storage_);
+    this->operations_ = nullptr;
+  }
+}
+
+ESPHOMELIB_NAMESPACE_END
+
+#endif //ESPHOMELIB_INLINE_FUNCTION_H
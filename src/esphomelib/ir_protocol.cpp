@@ -0,0 +1,322 @@
+//
+//  ir_protocol.cpp
+//  esphomelib
+//
+//  Copyright © 2018 Otto Winter. All rights reserved.
+//
+
+#include "esphomelib/ir_protocol.h"
+
+#include <cstdlib>
+#include <algorithm>
+
+#ifdef ARDUINO
+  #include "esphomelib/esphal.h"
+#else
+  #define pgm_read_byte(addr) (*reinterpret_cast<const uint8_t *>(addr))
+  #define pgm_read_word(addr) (*reinterpret_cast<const uint16_t *>(addr))
+#endif
+
+ESPHOMELIB_NAMESPACE_BEGIN
+
+namespace ir {
+
+/** Added to the relative tolerance when matching durations.
+ *
+ * Demodulating receiver modules typically stretch marks and shorten spaces by up to ~100µs, which
+ * would exceed the relative tolerance for the short (400-600µs) bit timings on its own.
+ */
+static const uint32_t ABSOLUTE_TOLERANCE_US = 50;
+
+/// Cursor over raw timings that consumes marks and spaces if they match the expected durations.
+class RawReader {
+ public:
+  RawReader(const int16_t *raw, size_t len, uint8_t tolerance)
+      : raw_(raw), len_(len), tolerance_(tolerance) {}
+
+  bool peek_mark(uint32_t duration_us) const {
+    return this->pos_ < this->len_ && this->raw_[this->pos_] > 0 && this->matches_(this->raw_[this->pos_], duration_us);
+  }
+  bool peek_space(uint32_t duration_us) const {
+    return this->pos_ < this->len_ && this->raw_[this->pos_] < 0 && this->matches_(-this->raw_[this->pos_], duration_us);
+  }
+  bool expect_mark(uint32_t duration_us) {
+    if (!this->peek_mark(duration_us))
+      return false;
+    this->pos_++;
+    return true;
+  }
+  bool expect_space(uint32_t duration_us) {
+    if (!this->peek_space(duration_us))
+      return false;
+    this->pos_++;
+    return true;
+  }
+  /// The space after the last mark of a frame merges with the idle time, so it can be long or missing.
+  bool expect_space_or_end(uint32_t duration_us) {
+    if (this->is_end())
+      return true;
+    if (this->raw_[this->pos_] >= 0 || uint32_t(-this->raw_[this->pos_]) < this->lower_(duration_us))
+      return false;
+    this->pos_++;
+    return true;
+  }
+  /// Read a bit encoded in the length of the space after a mark of constant length, consumes nothing on failure.
+  bool read_space_bit(uint32_t mark_us, uint32_t one_us, uint32_t zero_us, uint32_t *value) {
+    if (!this->expect_mark(mark_us))
+      return false;
+    if (this->expect_space(one_us)) {
+      *value = (*value << 1) | 1;
+      return true;
+    }
+    if (this->expect_space(zero_us)) {
+      *value = *value << 1;
+      return true;
+    }
+    this->pos_--;
+    return false;
+  }
+  bool is_end() const {
+    return this->pos_ >= this->len_;
+  }
+
+ protected:
+  uint32_t margin_(uint32_t duration_us) const {
+    return duration_us * this->tolerance_ / 100 + ABSOLUTE_TOLERANCE_US;
+  }
+  uint32_t lower_(uint32_t duration_us) const {
+    const uint32_t margin = this->margin_(duration_us);
+    return margin < duration_us ? duration_us - margin : 0;
+  }
+  bool matches_(int32_t measured_us, uint32_t duration_us) const {
+    return uint32_t(measured_us) >= this->lower_(duration_us) &&
+        uint32_t(measured_us) <= duration_us + this->margin_(duration_us);
+  }
+
+  const int16_t *raw_;
+  size_t len_;
+  size_t pos_{0};
+  uint8_t tolerance_;
+};
+
+const char *protocol_to_string(Protocol protocol) {
+  switch (protocol) {
+    case PROTOCOL_NEC: return "NEC";
+    case PROTOCOL_LG: return "LG";
+    case PROTOCOL_SONY: return "Sony";
+    case PROTOCOL_PANASONIC: return "Panasonic";
+    default: return "UNKNOWN";
+  }
+}
+
+bool decode_nec(const int16_t *raw, size_t len, DecodedData *out, uint8_t tolerance) {
+  RawReader reader(raw, len, tolerance);
+  if (!reader.expect_mark(nec::HEADER_HIGH_US) || !reader.expect_space(nec::HEADER_LOW_US))
+    return false;
+
+  uint32_t address = 0, command = 0;
+  for (uint8_t i = 0; i < 16; i++) {
+    if (!reader.read_space_bit(nec::BIT_HIGH_US, nec::BIT_ONE_LOW_US, nec::BIT_ZERO_LOW_US, &address))
+      return false;
+  }
+  for (uint8_t i = 0; i < 16; i++) {
+    if (!reader.read_space_bit(nec::BIT_HIGH_US, nec::BIT_ONE_LOW_US, nec::BIT_ZERO_LOW_US, &command))
+      return false;
+  }
+  if (!reader.expect_mark(nec::BIT_HIGH_US) || !reader.expect_space_or_end(nec::HEADER_LOW_US) || !reader.is_end())
+    return false;
+
+  out->protocol = PROTOCOL_NEC;
+  out->address = address;
+  out->data = command;
+  out->nbits = 32;
+  return true;
+}
+
+bool decode_lg(const int16_t *raw, size_t len, DecodedData *out, uint8_t tolerance) {
+  RawReader reader(raw, len, tolerance);
+  if (!reader.expect_mark(lg::HEADER_HIGH_US) || !reader.expect_space(lg::HEADER_LOW_US))
+    return false;
+
+  uint32_t data = 0;
+  for (uint8_t nbits = 0; nbits < 28; nbits++) {
+    if (!reader.read_space_bit(lg::BIT_HIGH_US, lg::BIT_ONE_LOW_US, lg::BIT_ZERO_LOW_US, &data))
+      return false;
+  }
+  if (!reader.expect_mark(lg::BIT_HIGH_US) || !reader.expect_space_or_end(lg::HEADER_LOW_US) || !reader.is_end())
+    return false;
+
+  out->protocol = PROTOCOL_LG;
+  out->address = 0;
+  out->data = data;
+  out->nbits = 28;
+  return true;
+}
+
+bool decode_sony(const int16_t *raw, size_t len, DecodedData *out, uint8_t tolerance) {
+  RawReader reader(raw, len, tolerance);
+  if (!reader.expect_mark(sony::HEADER_HIGH_US) || !reader.expect_space(sony::HEADER_LOW_US))
+    return false;
+
+  uint32_t data = 0;
+  uint8_t nbits = 0;
+  while (!reader.is_end() && nbits < 20) {
+    if (reader.expect_mark(sony::BIT_ONE_HIGH_US)) {
+      data = (data << 1) | 1;
+    } else if (reader.expect_mark(sony::BIT_ZERO_HIGH_US)) {
+      data = data << 1;
+    } else {
+      return false;
+    }
+    nbits++;
+    if (!reader.expect_space(sony::BIT_LOW_US))
+      break;
+  }
+  if (!reader.expect_space_or_end(sony::HEADER_HIGH_US) || !reader.is_end())
+    return false;
+  if (nbits != 12 && nbits != 15 && nbits != 20)
+    return false;
+
+  out->protocol = PROTOCOL_SONY;
+  out->address = 0;
+  out->data = data;
+  out->nbits = nbits;
+  return true;
+}
+
+bool decode_panasonic(const int16_t *raw, size_t len, DecodedData *out, uint8_t tolerance) {
+  RawReader reader(raw, len, tolerance);
+  if (!reader.expect_mark(panasonic::HEADER_HIGH_US) || !reader.expect_space(panasonic::HEADER_LOW_US))
+    return false;
+
+  uint32_t address = 0, data = 0;
+  for (uint8_t i = 0; i < 16; i++) {
+    if (!reader.read_space_bit(panasonic::BIT_HIGH_US, panasonic::BIT_ONE_LOW_US, panasonic::BIT_ZERO_LOW_US,
+                               &address))
+      return false;
+  }
+  for (uint8_t i = 0; i < 32; i++) {
+    if (!reader.read_space_bit(panasonic::BIT_HIGH_US, panasonic::BIT_ONE_LOW_US, panasonic::BIT_ZERO_LOW_US,
+                               &data))
+      return false;
+  }
+  if (!reader.expect_mark(panasonic::BIT_HIGH_US) || !reader.expect_space_or_end(panasonic::HEADER_LOW_US) ||
+      !reader.is_end())
+    return false;
+
+  out->protocol = PROTOCOL_PANASONIC;
+  out->address = address;
+  out->data = data;
+  out->nbits = 48;
+  return true;
+}
+
+bool decode(const int16_t *raw, size_t len, DecodedData *out, uint8_t tolerance) {
+  // NEC and LG headers overlap with generous tolerances, they're told apart by the number of bits (32 vs 28).
+  return decode_nec(raw, len, out, tolerance) || decode_lg(raw, len, out, tolerance) ||
+      decode_sony(raw, len, out, tolerance) || decode_panasonic(raw, len, out, tolerance);
+}
+
+void EdgeFrameBuilder::set_idle_us(uint32_t idle_us) {
+  this->idle_us_ = idle_us;
+}
+bool EdgeFrameBuilder::add_edge(uint32_t time_us) {
+  bool completed = false;
+  if (this->has_edge_) {
+    const uint32_t gap = time_us - this->last_edge_;
+    if (gap > this->idle_us_) {
+      completed = this->complete_();
+    } else {
+      const auto duration = int16_t(std::min(gap, uint32_t(INT16_MAX)));
+      // Each frame starts with a mark, after that marks and spaces alternate.
+      this->timings_.push_back(this->timings_.size() % 2 == 0 ? duration : -duration);
+    }
+  }
+  this->has_edge_ = true;
+  this->last_edge_ = time_us;
+  return completed;
+}
+bool EdgeFrameBuilder::finish(uint32_t now_us) {
+  // Signed, as an edge may have arrived after now_us was read.
+  if (!this->has_edge_ || int32_t(now_us - this->last_edge_) < int32_t(this->idle_us_))
+    return false;
+  this->has_edge_ = false;
+  return this->complete_();
+}
+void EdgeFrameBuilder::reset() {
+  this->has_edge_ = false;
+  this->timings_.clear();
+}
+const std::vector<int16_t> &EdgeFrameBuilder::get_frame() const {
+  return this->frame_;
+}
+bool EdgeFrameBuilder::complete_() {
+  // A single edge without a following one is just a glitch.
+  if (this->timings_.empty())
+    return false;
+  std::swap(this->frame_, this->timings_);
+  this->timings_.clear();
+  return true;
+}
+
+uint8_t CompactCode::get_bits_per_index() const {
+  uint8_t bits = 1;
+  while (bits < 8 && (1u << bits) < this->num_durations)
+    bits++;
+  return bits;
+}
+int16_t CompactCode::get(uint16_t i) const {
+  const uint8_t bits = this->get_bits_per_index();
+  const uint32_t offset = uint32_t(i) * bits;
+  const uint8_t shift = offset % 8;
+  uint16_t value = pgm_read_byte(this->indices + offset / 8) >> shift;
+  if (shift + bits > 8)
+    value |= uint16_t(pgm_read_byte(this->indices + offset / 8 + 1)) << (8 - shift);
+  const uint8_t index = value & ((1u << bits) - 1);
+  return int16_t(pgm_read_word(this->durations + index));
+}
+
+bool encode_compact(const int16_t *raw, size_t len, std::vector<int16_t> *durations, std::vector<uint8_t> *indices,
+                    uint8_t tolerance) {
+  // Sort the timings and start a new table entry wherever there's a gap larger than the tolerance.
+  std::vector<size_t> order(len);
+  for (size_t i = 0; i < len; i++)
+    order[i] = i;
+  std::sort(order.begin(), order.end(), [raw](size_t a, size_t b) { return raw[a] < raw[b]; });
+
+  std::vector<int32_t> sums;
+  std::vector<uint16_t> counts;
+  std::vector<uint8_t> assignment(len);
+  for (size_t k = 0; k < len; k++) {
+    const int32_t value = raw[order[k]];
+    const int32_t prev = k == 0 ? 0 : raw[order[k - 1]];
+    if (k == 0 || (value > 0) != (prev > 0) || (value - prev) * 100 > std::abs(prev) * tolerance) {
+      if (sums.size() == 255)
+        return false;
+      sums.push_back(0);
+      counts.push_back(0);
+    }
+    sums.back() += value;
+    counts.back()++;
+    assignment[order[k]] = sums.size() - 1;
+  }
+
+  durations->clear();
+  for (size_t j = 0; j < sums.size(); j++)
+    durations->push_back(int16_t(sums[j] / counts[j]));
+
+  CompactCode code{0, nullptr, uint8_t(sums.size()), nullptr, 0};
+  const uint8_t bits = code.get_bits_per_index();
+  indices->assign((len * bits + 7) / 8, 0);
+  for (size_t i = 0; i < len; i++) {
+    const size_t offset = i * bits;
+    (*indices)[offset / 8] |= assignment[i] << (offset % 8);
+    if (offset % 8 + bits > 8)
+      (*indices)[offset / 8 + 1] |= assignment[i] >> (8 - offset % 8);
+  }
+  return true;
+}
+
+} // namespace ir
+
+ESPHOMELIB_NAMESPACE_END
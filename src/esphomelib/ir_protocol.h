@@ -0,0 +1,209 @@
+//
+//  ir_protocol.h
+//  esphomelib
+//
+//  Copyright © 2018 Otto Winter. All rights reserved.
+//
+
+#ifndef ESPHOMELIB_IR_PROTOCOL_H
+#define ESPHOMELIB_IR_PROTOCOL_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "esphomelib/defines.h"
+
+ESPHOMELIB_NAMESPACE_BEGIN
+
+/** Timing constants and decoders for vendor IR formats.
+ *
+ * Raw IR data is stored as in ir::SendData: an array of durations in microseconds,
+ * positive values are marks (carrier on) and negative values are spaces (carrier off).
+ * Everything in here is plain computation without any hardware access, so the decoders
+ * can be run against recorded timings on any host.
+ */
+namespace ir {
+
+namespace nec {
+
+const uint32_t CARRIER_FREQUENCY_HZ = 38000;
+const uint32_t HEADER_HIGH_US = 9000;
+const uint32_t HEADER_LOW_US = 4500;
+const uint32_t BIT_HIGH_US = 560;
+const uint32_t BIT_ONE_LOW_US = 1690;
+const uint32_t BIT_ZERO_LOW_US = 560;
+
+} // namespace nec
+
+namespace lg {
+
+const uint32_t CARRIER_FREQUENCY_HZ = 38000;
+const uint32_t HEADER_HIGH_US = 8000;
+const uint32_t HEADER_LOW_US = 4000;
+const uint32_t BIT_HIGH_US = 600;
+const uint32_t BIT_ONE_LOW_US = 1600;
+const uint32_t BIT_ZERO_LOW_US = 550;
+
+} // namespace lg
+
+namespace sony {
+
+const uint32_t CARRIER_FREQUENCY_HZ = 40000;
+const uint32_t HEADER_HIGH_US = 2400;
+const uint32_t HEADER_LOW_US = 600;
+const uint32_t BIT_ONE_HIGH_US = 1200;
+const uint32_t BIT_ZERO_HIGH_US = 600;
+const uint32_t BIT_LOW_US = 600;
+
+} // namespace sony
+
+namespace panasonic {
+
+const uint32_t CARRIER_FREQUENCY_HZ = 35000;
+const uint32_t HEADER_HIGH_US = 3502;
+const uint32_t HEADER_LOW_US = 1750;
+const uint32_t BIT_HIGH_US = 502;
+const uint32_t BIT_ZERO_LOW_US = 400;
+const uint32_t BIT_ONE_LOW_US = 1244;
+
+} // namespace panasonic
+
+/// The default tolerance for matching received durations against the protocol timings, in percent.
+const uint8_t DEFAULT_TOLERANCE = 25;
+
+enum Protocol {
+  PROTOCOL_NEC = 0,
+  PROTOCOL_LG,
+  PROTOCOL_SONY,
+  PROTOCOL_PANASONIC,
+};
+
+/** A decoded IR frame.
+ *
+ * The fields mirror the arguments of the ir::SendData::from_* constructors, so a received
+ * frame can be sent again with the same values:
+ *
+ *  - NEC: address and command (in data).
+ *  - LG: data and nbits.
+ *  - Sony: data and nbits.
+ *  - Panasonic: address and data.
+ */
+struct DecodedData {
+  Protocol protocol;
+  uint16_t address;
+  uint32_t data;
+  uint8_t nbits;
+};
+
+/// Return a human-readable name of the protocol, for example "NEC".
+const char *protocol_to_string(Protocol protocol);
+
+/// Decode an NEC frame (header, 16 address bits, 16 command bits, stop mark).
+bool decode_nec(const int16_t *raw, size_t len, DecodedData *out, uint8_t tolerance = DEFAULT_TOLERANCE);
+/// Decode an LG frame (header, 28 data bits, stop mark). Without the stop mark, the last bit couldn't be read.
+bool decode_lg(const int16_t *raw, size_t len, DecodedData *out, uint8_t tolerance = DEFAULT_TOLERANCE);
+/// Decode a Sony SIRC frame (header, 12, 15 or 20 bits encoded in the mark lengths).
+bool decode_sony(const int16_t *raw, size_t len, DecodedData *out, uint8_t tolerance = DEFAULT_TOLERANCE);
+/// Decode a Panasonic frame (header, 16 address bits, 32 data bits, stop mark).
+bool decode_panasonic(const int16_t *raw, size_t len, DecodedData *out, uint8_t tolerance = DEFAULT_TOLERANCE);
+
+/** Try all decoders on a captured frame.
+ *
+ * @param raw The frame, starting with the header mark.
+ * @param len The number of durations in raw.
+ * @param out Where the decoded frame is stored on success.
+ * @param tolerance How far (in percent) received durations may be off from the protocol timings.
+ * @return Whether any protocol matched.
+ */
+bool decode(const int16_t *raw, size_t len, DecodedData *out, uint8_t tolerance = DEFAULT_TOLERANCE);
+
+/** Assembles frames of timings from the times of consecutive signal edges, for receivers without a peripheral
+ * that does this (like the ESP8266 edge interrupt).
+ *
+ * A frame ends at every gap between two edges that's longer than the idle time, the edge after the gap
+ * starts the next frame with a mark. Edges can be added in any batches, for example as soon as they're
+ * taken out of an interrupt ring buffer, and no memory is allocated once the buffers have grown to the
+ * longest frame.
+ */
+class EdgeFrameBuilder {
+ public:
+  /// Set how long (in µs) the signal has to be idle for a frame to end.
+  void set_idle_us(uint32_t idle_us);
+
+  /** Add the time (in µs, may wrap around) of the next edge.
+   *
+   * @return Whether the gap before this edge completed a frame, which is then available in get_frame()
+   *         until the next call.
+   */
+  bool add_edge(uint32_t time_us);
+
+  /// Complete the current frame if there was no edge for the idle time at now_us. Returns whether a frame was completed.
+  bool finish(uint32_t now_us);
+
+  /// Discard the current frame, for example after edges were lost.
+  void reset();
+
+  /// The last completed frame, starting with a mark. Marks are positive and spaces are negative.
+  const std::vector<int16_t> &get_frame() const;
+
+ protected:
+  bool complete_();
+
+  uint32_t idle_us_{10000};
+  bool has_edge_{false};
+  uint32_t last_edge_{0};
+  std::vector<int16_t> timings_;
+  std::vector<int16_t> frame_;
+};
+
+/** A raw IR code in a compact format, for storing large code libraries in flash.
+ *
+ * Remotes only use a handful of distinct durations (header, bit mark, zero and one space, gap, ...),
+ * so instead of an int16 per timing, a code is stored as a small table of distinct durations and a
+ * stream of bit-packed indices into that table. Both arrays are meant to be placed in PROGMEM, the
+ * transmitter reads them timing by timing while sending. For example, an AC code with 200 timings and
+ * 6 distinct durations takes 12 + 75 bytes of flash instead of 400 bytes of heap.
+ *
+ * Use encode_compact() on a host to create the arrays from raw timings:
+ *
+ * ```cpp
+ * static const int16_t AC_DURATIONS[] PROGMEM = {3500, -1750, 430, -1300, -430, -10000};
+ * static const uint8_t AC_OFF[] PROGMEM = {0x21, 0x43, ...};
+ * transmitter->create_transmitter("AC Off", ir::CompactCode{38000, AC_DURATIONS, 6, AC_OFF, 211});
+ * ```
+ */
+struct CompactCode {
+  uint32_t carrier_frequency;
+  const int16_t *durations; ///< The distinct durations in µs (PROGMEM), positive means mark, negative means space.
+  uint8_t num_durations;
+  const uint8_t *indices; ///< Indices into durations (PROGMEM), packed LSB first with get_bits_per_index() bits each.
+  uint16_t length; ///< The number of timings.
+
+  /// The number of bits of each index, enough to address all durations.
+  uint8_t get_bits_per_index() const;
+  /// Get the duration of timing i in µs, positive means mark, negative means space.
+  int16_t get(uint16_t i) const;
+};
+
+/** Quantize raw timings into the duration table and index stream of a CompactCode.
+ *
+ * The timings are sorted and split into groups wherever two neighboring timings are more than
+ * tolerance percent apart or have a different sign. Each group becomes one table entry with the
+ * group's average duration.
+ *
+ * @param raw The raw timings, positive means mark, negative means space.
+ * @param len The number of timings in raw.
+ * @param durations The duration table is stored here.
+ * @param indices The packed index stream is stored here.
+ * @param tolerance How far apart (in percent) timings may be to be merged.
+ * @return Whether encoding succeeded, fails if there would be more than 255 distinct durations.
+ */
+bool encode_compact(const int16_t *raw, size_t len, std::vector<int16_t> *durations, std::vector<uint8_t> *indices,
+                    uint8_t tolerance = 10);
+
+} // namespace ir
+
+ESPHOMELIB_NAMESPACE_END
+
+#endif //ESPHOMELIB_IR_PROTOCOL_H
@@ -0,0 +1,183 @@
+//
+//  ir_receiver_component.cpp
+//  esphomelib
+//
+//  Copyright © 2018 Otto Winter. All rights reserved.
+//
+
+#include "esphomelib/ir_receiver_component.h"
+
+#include <algorithm>
+
+#include "esphomelib/log.h"
+
+#ifdef USE_IR_RECEIVER
+
+ESPHOMELIB_NAMESPACE_BEGIN
+
+static const char *TAG = "ir_receiver";
+
+IRReceiverComponent::IRReceiverComponent(GPIOPin *pin)
+    : pin_(pin) {
+#ifdef ARDUINO_ARCH_ESP32
+  this->channel_ = next_rmt_channel;
+  next_rmt_channel = rmt_channel_t(int(next_rmt_channel) + 1); // NOLINT
+#endif
+}
+
+#ifdef ARDUINO_ARCH_ESP32
+/// With the 80MHz APB clock, this divider makes one RMT tick one microsecond.
+static const uint8_t IR_RECEIVER_CLOCK_DIVIDER = 80;
+
+void IRReceiverComponent::setup() {
+  ESP_LOGCONFIG(TAG, "Setting up IR receiver...");
+  ESP_LOGCONFIG(TAG, "    Channel: %d", this->channel_);
+  ESP_LOGCONFIG(TAG, "    GPIO Pin: %u", this->pin_->get_pin());
+  ESP_LOGCONFIG(TAG, "    Idle time: %u µs", this->idle_us_);
+
+  rmt_config_t c{};
+  c.rmt_mode = RMT_MODE_RX;
+  c.channel = this->channel_;
+  c.clk_div = IR_RECEIVER_CLOCK_DIVIDER;
+  c.gpio_num = gpio_num_t(this->pin_->get_pin());
+  c.mem_block_num = 1;
+  // The filter threshold is in APB clock cycles, ignore glitches shorter than ~3µs.
+  c.rx_config.filter_en = true;
+  c.rx_config.filter_ticks_thresh = 250;
+  c.rx_config.idle_threshold = this->idle_us_;
+
+  if (rmt_config(&c) != ESP_OK || rmt_driver_install(this->channel_, this->buffer_size_, 0) != ESP_OK) {
+    ESP_LOGE(TAG, "Configuring RMT failed!");
+    this->mark_failed();
+    return;
+  }
+  rmt_get_ringbuf_handle(this->channel_, &this->ringbuf_);
+  rmt_rx_start(this->channel_, true);
+}
+
+void IRReceiverComponent::loop() {
+  size_t len = 0;
+  auto *items = reinterpret_cast<rmt_item32_t *>(xRingbufferReceive(this->ringbuf_, &len, 0));
+  if (items == nullptr)
+    return;
+
+  this->timings_.clear();
+  const size_t num_items = len / sizeof(rmt_item32_t);
+  for (size_t i = 0; i < num_items; i++) {
+    // A duration of 0 marks the end of the frame, the last space is the idle time.
+    if (items[i].duration0 == 0)
+      break;
+    this->timings_.push_back(int16_t(items[i].duration0));
+    if (items[i].duration1 == 0)
+      break;
+    this->timings_.push_back(-int16_t(items[i].duration1));
+  }
+  vRingbufferReturnItem(this->ringbuf_, items);
+
+  this->process_frame_(this->timings_);
+}
+
+void IRReceiverComponent::set_channel(rmt_channel_t channel) {
+  this->channel_ = channel;
+}
+void IRReceiverComponent::set_buffer_size(uint32_t buffer_size) {
+  this->buffer_size_ = buffer_size;
+}
+#endif
+
+#ifdef ARDUINO_ARCH_ESP8266
+void IRReceiverComponent::setup() {
+  ESP_LOGCONFIG(TAG, "Setting up IR receiver...");
+  ESP_LOGCONFIG(TAG, "    GPIO Pin: %u", this->pin_->get_pin());
+  ESP_LOGCONFIG(TAG, "    Idle time: %u µs", this->idle_us_);
+  if (active_ != nullptr) {
+    ESP_LOGE(TAG, "Only one IR receiver is supported on the ESP8266!");
+    this->mark_failed();
+    return;
+  }
+  active_ = this;
+  this->frame_builder_.set_idle_us(this->idle_us_);
+  this->pin_->setup();
+  attachInterrupt(digitalPinToInterrupt(this->pin_->get_pin()), IRReceiverComponent::gpio_intr_, CHANGE);
+}
+
+void IRReceiverComponent::loop() {
+  // Read the time before the edges, so that finish() never ends a frame whose next edge is already buffered.
+  const uint32_t now = micros();
+  const uint16_t write_pos = this->write_pos_;
+  const uint16_t count = write_pos - this->read_pos_;
+  if (count > IR_RECEIVER_BUFFER_SIZE) {
+    ESP_LOGW(TAG, "IR receiver buffer overflow, dropping %u edges!", count);
+    this->read_pos_ = write_pos;
+    this->frame_builder_.reset();
+    return;
+  }
+
+  // Frames are split at every gap longer than the idle time, even if the next frame already started.
+  for (; this->read_pos_ != write_pos; this->read_pos_++) {
+    if (this->frame_builder_.add_edge(this->edges_[this->read_pos_ % IR_RECEIVER_BUFFER_SIZE]))
+      this->process_frame_(this->frame_builder_.get_frame());
+  }
+  if (this->frame_builder_.finish(now))
+    this->process_frame_(this->frame_builder_.get_frame());
+}
+
+void ICACHE_RAM_ATTR IRReceiverComponent::gpio_intr_() {
+  IRReceiverComponent *receiver = active_;
+  const uint16_t pos = receiver->write_pos_;
+  receiver->edges_[pos % IR_RECEIVER_BUFFER_SIZE] = micros();
+  receiver->write_pos_ = pos + 1;
+}
+
+IRReceiverComponent *IRReceiverComponent::active_ = nullptr;
+#endif
+
+void IRReceiverComponent::process_frame_(const std::vector<int16_t> &timings) {
+  ir::DecodedData data{};
+  if (!ir::decode(timings.data(), timings.size(), &data, this->tolerance_)) {
+    ESP_LOGV(TAG, "Received IR frame with %u timings that matches no protocol.", unsigned(timings.size()));
+    return;
+  }
+  ESP_LOGD(TAG, "Received %s: address=0x%04X data=0x%08X nbits=%u", ir::protocol_to_string(data.protocol),
+           data.address, data.data, data.nbits);
+  this->receive_callback_.call(data);
+}
+
+void IRReceiverComponent::add_on_receive_callback(InlineFunction<void(ir::DecodedData)> &&callback) {
+  this->receive_callback_.add(std::move(callback));
+}
+IRReceiveTrigger *IRReceiverComponent::make_trigger(ir::Protocol protocol) {
+  return new IRReceiveTrigger(this, protocol);
+}
+void IRReceiverComponent::set_tolerance(uint8_t tolerance) {
+  this->tolerance_ = tolerance;
+}
+void IRReceiverComponent::set_idle_us(uint16_t idle_us) {
+  this->idle_us_ = std::min(idle_us, uint16_t(INT16_MAX));
+}
+float IRReceiverComponent::get_setup_priority() const {
+  return setup_priority::HARDWARE_LATE;
+}
+
+IRReceiveTrigger::IRReceiveTrigger(IRReceiverComponent *parent, ir::Protocol protocol)
+    : protocol_(protocol) {
+  parent->add_on_receive_callback([this](ir::DecodedData data) {
+    if (data.protocol != this->protocol_)
+      return;
+    if (this->address_.has_value() && *this->address_ != data.address)
+      return;
+    if (this->data_.has_value() && *this->data_ != data.data)
+      return;
+    this->trigger(data);
+  });
+}
+void IRReceiveTrigger::set_address(uint16_t address) {
+  this->address_ = address;
+}
+void IRReceiveTrigger::set_data(uint32_t data) {
+  this->data_ = data;
+}
+
+ESPHOMELIB_NAMESPACE_END
+
+#endif //USE_IR_RECEIVER
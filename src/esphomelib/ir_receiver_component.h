@@ -0,0 +1,136 @@
+//
+//  ir_receiver_component.h
+//  esphomelib
+//
+//  Copyright © 2018 Otto Winter. All rights reserved.
+//
+
+#ifndef ESPHOMELIB_IR_RECEIVER_COMPONENT_H
+#define ESPHOMELIB_IR_RECEIVER_COMPONENT_H
+
+#include <vector>
+
+#include "esphomelib/component.h"
+#include "esphomelib/automation.h"
+#include "esphomelib/esphal.h"
+#include "esphomelib/helpers.h"
+#include "esphomelib/ir_protocol.h"
+#include "esphomelib/defines.h"
+
+#ifdef USE_IR_RECEIVER
+
+#ifdef ARDUINO_ARCH_ESP32
+#include <driver/rmt.h>
+#endif
+
+ESPHOMELIB_NAMESPACE_BEGIN
+
+class IRReceiveTrigger;
+
+#ifdef ARDUINO_ARCH_ESP8266
+/// The number of edges the ESP8266 interrupt handler can buffer, must be a power of two.
+const uint16_t IR_RECEIVER_BUFFER_SIZE = 256;
+#endif
+
+/** Receive and decode IR codes from a demodulating IR receiver module (like a TSOP38238).
+ *
+ * The receiver captures the durations of all marks and spaces of a frame. On the ESP32, this is done
+ * by the RMT peripheral, on the ESP8266 an interrupt handler stores the time of every edge in a ring buffer.
+ * A frame ends at every gap longer than the idle time. Frames are then decoded in loop(),
+ * outside of the interrupt handler, using the NEC, LG, Sony and Panasonic decoders from ir_protocol.h.
+ *
+ * Decoded frames are passed to all callbacks and triggers:
+ *
+ * ```cpp
+ * auto *receiver = App.make_ir_receiver(GPIOInputPin(14, INPUT, true));
+ * auto *trigger = receiver->make_trigger(ir::PROTOCOL_NEC);
+ * trigger->set_address(0x20DF);
+ * trigger->set_data(0x10EF);
+ * App.make_automation(trigger)->add_action(...);
+ * ```
+ *
+ * As marks and spaces simply alternate, the pin's inverted setting is not used for decoding.
+ */
+class IRReceiverComponent : public Component {
+ public:
+  explicit IRReceiverComponent(GPIOPin *pin);
+
+  /// Add a callback that's called with every decoded frame.
+  void add_on_receive_callback(InlineFunction<void(ir::DecodedData)> &&callback);
+
+  /// Create a trigger for frames of the given protocol, optionally filtered further by address and data.
+  IRReceiveTrigger *make_trigger(ir::Protocol protocol);
+
+  /// Set how far (in percent) received durations may be off from the protocol timings. Defaults to 25%.
+  void set_tolerance(uint8_t tolerance);
+  /// Set how long (in µs) the signal has to be idle for a frame to end. Defaults to 10ms, at most 32767µs.
+  void set_idle_us(uint16_t idle_us);
+
+#ifdef ARDUINO_ARCH_ESP32
+  /// Manually set the RMT channel, by default the next free channel is used.
+  void set_channel(rmt_channel_t channel);
+  /// Set the size of the RMT receive ring buffer in bytes. Defaults to 1000.
+  void set_buffer_size(uint32_t buffer_size);
+#endif
+
+  // ========== INTERNAL METHODS ==========
+  // (In most use cases you won't need these)
+  void setup() override;
+  void loop() override;
+  float get_setup_priority() const override;
+
+ protected:
+  /// Decode a captured frame and notify all callbacks.
+  void process_frame_(const std::vector<int16_t> &timings);
+
+#ifdef ARDUINO_ARCH_ESP32
+  rmt_channel_t channel_;
+  uint32_t buffer_size_{1000};
+  RingbufHandle_t ringbuf_{nullptr};
+#endif
+
+#ifdef ARDUINO_ARCH_ESP8266
+  static void gpio_intr_();
+  /// The receiver whose pin the interrupt handler is attached to.
+  static IRReceiverComponent *active_;
+
+  /// micros() of the edges, written by the interrupt handler.
+  volatile uint32_t edges_[IR_RECEIVER_BUFFER_SIZE];
+  /// Total number of edges written by the interrupt handler, wraps around.
+  volatile uint16_t write_pos_{0};
+  /// Total number of edges processed by loop(), wraps around.
+  uint16_t read_pos_{0};
+  ir::EdgeFrameBuilder frame_builder_;
+#endif
+
+  GPIOPin *pin_;
+  uint8_t tolerance_{ir::DEFAULT_TOLERANCE};
+  uint16_t idle_us_{10000};
+#ifdef ARDUINO_ARCH_ESP32
+  /// Reused for each frame to avoid allocating in every loop.
+  std::vector<int16_t> timings_;
+#endif
+  CallbackManager<void(ir::DecodedData)> receive_callback_{};
+};
+
+/// Trigger for received IR frames of one protocol, with optional address and data filters.
+class IRReceiveTrigger : public Trigger<ir::DecodedData> {
+ public:
+  IRReceiveTrigger(IRReceiverComponent *parent, ir::Protocol protocol);
+
+  /// Only trigger for frames with this address (NEC and Panasonic).
+  void set_address(uint16_t address);
+  /// Only trigger for frames with this data (the command for NEC).
+  void set_data(uint32_t data);
+
+ protected:
+  ir::Protocol protocol_;
+  optional<uint16_t> address_{};
+  optional<uint32_t> data_{};
+};
+
+ESPHOMELIB_NAMESPACE_END
+
+#endif //USE_IR_RECEIVER
+
+#endif //ESPHOMELIB_IR_RECEIVER_COMPONENT_H
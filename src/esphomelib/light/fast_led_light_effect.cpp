@@ -0,0 +1,187 @@
+//
+//  fast_led_light_effect.cpp
+//  esphomelib
+//
+//  Copyright © 2018 Otto Winter. All rights reserved.
+//
+
+#include "esphomelib/light/fast_led_light_effect.h"
+
+#include "esphomelib/helpers.h"
+#include "esphomelib/log.h"
+#include "esphomelib/esphal.h"
+
+#ifdef USE_FAST_LED_LIGHT
+
+ESPHOMELIB_NAMESPACE_BEGIN
+
+namespace light {
+
+static const char *TAG = "light.fast_led_effect";
+
+void BaseFastLEDLightEffect::initialize(LightState *state) {
+  // Prevent any normal light set calls (like setting color manually) affecting our LED array
+  // while this effect is active. Otherwise, when choosing a color from the front-end while
+  // this effect is active, all LEDS would briefly go to the new color but then right back due
+  // to this effect
+  auto *output = (BaseFastLEDLightOutput *) state->get_output();
+  output->prevent_writing_leds();
+  this->frame_interval_ = 0;
+}
+void BaseFastLEDLightEffect::stop(LightState *state) {
+  // Tell the light output to respond to normal requests again.
+  auto *output = (BaseFastLEDLightOutput *) state->get_output();
+  output->unprevent_writing_leds();
+}
+void BaseFastLEDLightEffect::apply_effect(LightState *state) {
+  const uint32_t now = millis();
+  if (now - this->last_frame_ < this->frame_interval_)
+    return;
+  this->last_frame_ = now;
+
+  auto *output = (BaseFastLEDLightOutput *) state->get_output();
+  if (output->get_num_leds() == 0)
+    return;
+  const uint32_t start = micros();
+  this->render_(output, state, now);
+  const uint32_t render_time = micros() - start;
+
+  // make the output show the effect
+  output->schedule_show();
+
+  this->frame_interval_ = this->update_interval_;
+  if (this->frame_time_budget_ != 0 && render_time > this->frame_time_budget_) {
+    // Drop frames so that on average this effect uses at most frame_time_budget_ µs per update interval.
+    this->frame_interval_ = (uint64_t(this->update_interval_) * render_time) / this->frame_time_budget_;
+    ESP_LOGVV(TAG, "Rendering '%s' took %uµs (budget %uµs), next frame in %ums.", this->get_name().c_str(),
+              render_time, this->frame_time_budget_, this->frame_interval_);
+  }
+}
+void BaseFastLEDLightEffect::set_update_interval(uint32_t update_interval) {
+  this->update_interval_ = update_interval;
+}
+uint32_t BaseFastLEDLightEffect::get_update_interval() const {
+  return this->update_interval_;
+}
+void BaseFastLEDLightEffect::set_frame_time_budget(uint32_t frame_time_budget) {
+  this->frame_time_budget_ = frame_time_budget;
+}
+uint32_t BaseFastLEDLightEffect::get_frame_time_budget() const {
+  return this->frame_time_budget_;
+}
+CRGB BaseFastLEDLightEffect::get_color_(LightState *state) const {
+  float red, green, blue;
+  // Don't use LightState::get_current_values() here, it would apply this effect again.
+  LightColorValues v = state->get_current_values_lazy();
+  v.set_state(1.0f);
+  v.as_rgb(&red, &green, &blue);
+  return CRGB(red * 255, green * 255, blue * 255);
+}
+
+std::unique_ptr<LightEffect> FastLEDRainbowLightEffect::create() {
+  return make_unique<FastLEDRainbowLightEffect>();
+}
+std::string FastLEDRainbowLightEffect::get_name() const {
+  return "Rainbow Effect";
+}
+void FastLEDRainbowLightEffect::render_(BaseFastLEDLightOutput *output, LightState *state, uint32_t now) {
+  uint8_t hue = now / 75;
+  fill_rainbow(output->get_leds(), output->get_num_leds(), hue, 14);
+}
+
+FastLEDColorWipeLightEffect::FastLEDColorWipeLightEffect()
+    : color_(CHSV(random8(), 255, 255)) {
+  this->update_interval_ = 30;
+}
+std::unique_ptr<LightEffect> FastLEDColorWipeLightEffect::create() {
+  return make_unique<FastLEDColorWipeLightEffect>();
+}
+std::string FastLEDColorWipeLightEffect::get_name() const {
+  return "Color Wipe Effect";
+}
+void FastLEDColorWipeLightEffect::render_(BaseFastLEDLightOutput *output, LightState *state, uint32_t now) {
+  if (this->position_ >= output->get_num_leds()) {
+    this->position_ = 0;
+    this->color_ = CHSV(random8(), 255, 255);
+  }
+  output->get_leds()[this->position_++] = this->color_;
+}
+
+FastLEDTwinkleLightEffect::FastLEDTwinkleLightEffect() {
+  this->update_interval_ = 20;
+}
+std::unique_ptr<LightEffect> FastLEDTwinkleLightEffect::create() {
+  return make_unique<FastLEDTwinkleLightEffect>();
+}
+std::string FastLEDTwinkleLightEffect::get_name() const {
+  return "Twinkle Effect";
+}
+void FastLEDTwinkleLightEffect::set_twinkle_probability(float twinkle_probability) {
+  this->twinkle_probability_ = twinkle_probability;
+}
+void FastLEDTwinkleLightEffect::set_fade_out_rate(uint8_t fade_out_rate) {
+  this->fade_out_rate_ = fade_out_rate;
+}
+void FastLEDTwinkleLightEffect::render_(BaseFastLEDLightOutput *output, LightState *state, uint32_t now) {
+  CRGB *leds = output->get_leds();
+  const int num_leds = output->get_num_leds();
+  fadeToBlackBy(leds, num_leds, this->fade_out_rate_);
+  if (random_float() < this->twinkle_probability_)
+    leds[random16(num_leds)] = this->get_color_(state);
+}
+
+FastLEDScanLightEffect::FastLEDScanLightEffect() {
+  this->update_interval_ = 20;
+}
+std::unique_ptr<LightEffect> FastLEDScanLightEffect::create() {
+  return make_unique<FastLEDScanLightEffect>();
+}
+std::string FastLEDScanLightEffect::get_name() const {
+  return "Scan Effect";
+}
+void FastLEDScanLightEffect::set_tail_fade_rate(uint8_t tail_fade_rate) {
+  this->tail_fade_rate_ = tail_fade_rate;
+}
+void FastLEDScanLightEffect::render_(BaseFastLEDLightOutput *output, LightState *state, uint32_t now) {
+  CRGB *leds = output->get_leds();
+  const int num_leds = output->get_num_leds();
+  fadeToBlackBy(leds, num_leds, this->tail_fade_rate_);
+
+  if (this->position_ >= num_leds - 1)
+    this->reverse_ = true;
+  else if (this->position_ <= 0)
+    this->reverse_ = false;
+  this->position_ = clamp(0, num_leds - 1, this->position_ + (this->reverse_ ? -1 : 1));
+  leds[this->position_] = this->get_color_(state);
+}
+
+FastLEDFireworksLightEffect::FastLEDFireworksLightEffect() {
+  this->update_interval_ = 20;
+}
+std::unique_ptr<LightEffect> FastLEDFireworksLightEffect::create() {
+  return make_unique<FastLEDFireworksLightEffect>();
+}
+std::string FastLEDFireworksLightEffect::get_name() const {
+  return "Fireworks Effect";
+}
+void FastLEDFireworksLightEffect::set_spark_probability(float spark_probability) {
+  this->spark_probability_ = spark_probability;
+}
+void FastLEDFireworksLightEffect::set_fade_out_rate(uint8_t fade_out_rate) {
+  this->fade_out_rate_ = fade_out_rate;
+}
+void FastLEDFireworksLightEffect::render_(BaseFastLEDLightOutput *output, LightState *state, uint32_t now) {
+  CRGB *leds = output->get_leds();
+  const int num_leds = output->get_num_leds();
+  // Let existing sparks spread to their neighbors and burn out.
+  blur1d(leds, num_leds, 64);
+  fadeToBlackBy(leds, num_leds, this->fade_out_rate_);
+  if (random_float() < this->spark_probability_)
+    leds[random16(num_leds)] = CHSV(random8(), 200, 255);
+}
+
+} // namespace light
+
+ESPHOMELIB_NAMESPACE_END
+
+#endif //USE_FAST_LED_LIGHT
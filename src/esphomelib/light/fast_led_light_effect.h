@@ -0,0 +1,164 @@
+//
+//  fast_led_light_effect.h
+//  esphomelib
+//
+//  Copyright © 2018 Otto Winter. All rights reserved.
+//
+
+#ifndef ESPHOMELIB_LIGHT_FAST_LED_LIGHT_EFFECT_H
+#define ESPHOMELIB_LIGHT_FAST_LED_LIGHT_EFFECT_H
+
+#include "esphomelib/light/light_effect.h"
+#include "esphomelib/light/fast_led_light_output.h"
+#include "esphomelib/defines.h"
+
+#ifdef USE_FAST_LED_LIGHT
+
+ESPHOMELIB_NAMESPACE_BEGIN
+
+namespace light {
+
+/** Base class for all addressable light effects that render directly into the CRGB buffer of a FastLED light.
+ *
+ * Subclasses only need to implement render_(), which draws a single frame. This base class takes care of
+ * preventing the LightState from overwriting the LED buffer, limits rendering to one frame per update interval
+ * (so a 60 FPS effect doesn't re-render on every single loop() pass) and schedules the show on the output.
+ *
+ * Optionally, a frame-time budget can be set. If rendering a frame takes longer than the budget, the effect
+ * automatically drops frames so that on average it never uses more than budget µs of CPU time per update
+ * interval - this keeps very long strips from starving the main loop. Subclasses should therefore base their
+ * animation on the `now` timestamp passed to render_() where possible.
+ */
+class BaseFastLEDLightEffect : public LightEffect {
+ public:
+  void initialize(LightState *state) override;
+
+  void stop(LightState *state) override;
+
+  void apply_effect(LightState *state) override;
+
+  /// Set the interval in ms between two rendered frames, defaults to 16ms (~60 FPS).
+  void set_update_interval(uint32_t update_interval);
+  uint32_t get_update_interval() const;
+
+  /// Set the maximum time in µs a single frame should take to render, 0 for no limit (the default).
+  void set_frame_time_budget(uint32_t frame_time_budget);
+  uint32_t get_frame_time_budget() const;
+
+ protected:
+  /** Render a single frame into the LED buffer of the output.
+   *
+   * @param output The FastLED output, use get_leds() and get_num_leds() to access the LED buffer.
+   * @param state The LightState this effect is running on.
+   * @param now The current time in ms.
+   */
+  virtual void render_(BaseFastLEDLightOutput *output, LightState *state, uint32_t now) = 0;
+
+  /// Return the color the user has set for the light as a CRGB (without any effects applied).
+  CRGB get_color_(LightState *state) const;
+
+  uint32_t update_interval_{16};
+  uint32_t frame_time_budget_{0};
+  /// The interval the next frame will be rendered in, can be longer than update_interval_ if over budget.
+  uint32_t frame_interval_{0};
+  uint32_t last_frame_{0};
+};
+
+/// Rainbow effect for FastLED
+class FastLEDRainbowLightEffect : public BaseFastLEDLightEffect {
+ public:
+  static std::unique_ptr<LightEffect> create();
+
+  std::string get_name() const override;
+
+ protected:
+  void render_(BaseFastLEDLightOutput *output, LightState *state, uint32_t now) override;
+};
+
+/// Color wipe effect. Fills the strip LED by LED with a random color, then wipes again with the next color.
+class FastLEDColorWipeLightEffect : public BaseFastLEDLightEffect {
+ public:
+  FastLEDColorWipeLightEffect();
+
+  static std::unique_ptr<LightEffect> create();
+
+  std::string get_name() const override;
+
+ protected:
+  void render_(BaseFastLEDLightOutput *output, LightState *state, uint32_t now) override;
+
+  int position_{0};
+  CRGB color_;
+};
+
+/// Twinkle effect. Randomly lights up LEDs in the current color that then slowly fade out.
+class FastLEDTwinkleLightEffect : public BaseFastLEDLightEffect {
+ public:
+  FastLEDTwinkleLightEffect();
+
+  static std::unique_ptr<LightEffect> create();
+
+  std::string get_name() const override;
+
+  /// Set the probability (0 to 1) with which an LED starts twinkling per frame, defaults to 0.05.
+  void set_twinkle_probability(float twinkle_probability);
+
+  /// Set how much each LED fades out per frame (0-255), defaults to 16.
+  void set_fade_out_rate(uint8_t fade_out_rate);
+
+ protected:
+  void render_(BaseFastLEDLightOutput *output, LightState *state, uint32_t now) override;
+
+  float twinkle_probability_{0.05f};
+  uint8_t fade_out_rate_{16};
+};
+
+/// Scan effect. A single dot in the current color moves back and forth across the strip, leaving a fading tail.
+class FastLEDScanLightEffect : public BaseFastLEDLightEffect {
+ public:
+  FastLEDScanLightEffect();
+
+  static std::unique_ptr<LightEffect> create();
+
+  std::string get_name() const override;
+
+  /// Set how much the tail fades out per frame (0-255), defaults to 64.
+  void set_tail_fade_rate(uint8_t tail_fade_rate);
+
+ protected:
+  void render_(BaseFastLEDLightOutput *output, LightState *state, uint32_t now) override;
+
+  int position_{0};
+  bool reverse_{false};
+  uint8_t tail_fade_rate_{64};
+};
+
+/// Fireworks effect. Sparks with random colors explode at random positions, spread out and fade.
+class FastLEDFireworksLightEffect : public BaseFastLEDLightEffect {
+ public:
+  FastLEDFireworksLightEffect();
+
+  static std::unique_ptr<LightEffect> create();
+
+  std::string get_name() const override;
+
+  /// Set the probability (0 to 1) with which a new spark is launched per frame, defaults to 0.10.
+  void set_spark_probability(float spark_probability);
+
+  /// Set how much the sparks fade out per frame (0-255), defaults to 20.
+  void set_fade_out_rate(uint8_t fade_out_rate);
+
+ protected:
+  void render_(BaseFastLEDLightOutput *output, LightState *state, uint32_t now) override;
+
+  float spark_probability_{0.10f};
+  uint8_t fade_out_rate_{20};
+};
+
+} // namespace light
+
+ESPHOMELIB_NAMESPACE_END
+
+#endif //USE_FAST_LED_LIGHT
+
+#endif //ESPHOMELIB_LIGHT_FAST_LED_LIGHT_EFFECT_H
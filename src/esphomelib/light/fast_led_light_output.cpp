@@ -7,6 +7,11 @@
 //
 
 #include "esphomelib/light/fast_led_light_output.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "esphomelib/light/light_dithering.h"
 #include "esphomelib/log.h"
 
 #ifdef USE_FAST_LED_LIGHT
@@ -17,34 +22,84 @@ namespace light {
 
 static const char *TAG = "light.fast_led";
 
-LightTraits FastLEDLightOutputComponent::get_traits() {
+LightTraits BaseFastLEDLightOutput::get_traits() {
   return {true, true, false, true};
 }
-void FastLEDLightOutputComponent::write_state(LightState *state) {
+void BaseFastLEDLightOutput::write_state(LightState *state) {
+  uint16_t red, green, blue;
+  state->current_values_as_rgb_raw(&red, &green, &blue);
+  // scale 0-65535 to 8.8 fixed-point 0-65280 (255.0)
+  this->red_ = red - (red >> 8);
+  this->green_ = green - (green >> 8);
+  this->blue_ = blue - (blue >> 8);
+
+  // Still remember the color while an effect is running, it's restored from it once the effect stops.
   if (this->prevent_writing_leds_)
     return;
 
-  float red, green, blue;
-  state->current_values_as_rgb(&red, &green, &blue);
-  CRGB crgb = CRGB(red * 255, green * 255, blue * 255);
-
-  for (int i = 0; i < this->num_leds_; i++)
-    this->leds_[i] = crgb;
-
+  this->fill_leds();
   this->schedule_show();
 }
+void BaseFastLEDLightOutput::fill_leds() {
+  this->fill_leds_(0, this->get_num_leds());
+}
+void BaseFastLEDLightOutput::fill_leds_(int start, int end) {
+  uint16_t *high_res = this->get_high_res_leds();
+  if (high_res != nullptr) {
+    // dithering enabled, the parent will quantize this buffer to CRGB values on the next show.
+    for (int i = start; i < end; i++) {
+      high_res[i * 3 + 0] = this->red_;
+      high_res[i * 3 + 1] = this->green_;
+      high_res[i * 3 + 2] = this->blue_;
+    }
+  } else {
+    const CRGB crgb = CRGB(this->red_ >> 8, this->green_ >> 8, this->blue_ >> 8);
+    CRGB *leds = this->get_leds();
+    for (int i = start; i < end; i++)
+      leds[i] = crgb;
+  }
+}
+void BaseFastLEDLightOutput::unprevent_writing_leds() {
+  this->prevent_writing_leds_ = false;
+}
+void BaseFastLEDLightOutput::prevent_writing_leds() {
+  this->prevent_writing_leds_ = true;
+}
+bool BaseFastLEDLightOutput::is_writing_leds_prevented() const {
+  return this->prevent_writing_leds_;
+}
+
 void FastLEDLightOutputComponent::setup() {
   ESP_LOGCONFIG(TAG, "Setting up FastLED light...");
-  assert(this->controller_ != nullptr && "You need to add LEDs to this controller!");
-  this->controller_->init();
-  this->controller_->setLeds(this->leds_, this->num_leds_);
+  assert(!this->controllers_.empty() && "You need to add LEDs to this controller!");
+  uint32_t max_refresh_rate = 0;
+  for (auto &c : this->controllers_) {
+    ESP_LOGCONFIG(TAG, "    Controller: LEDs %d to %d", c.offset, c.offset + c.num_leds - 1);
+    c.controller->init();
+    c.controller->setLeds(this->leds_ + c.offset, c.num_leds);
+    max_refresh_rate = std::max(max_refresh_rate, uint32_t(c.controller->getMaxRefreshRate()));
+  }
   if (!this->max_refresh_rate_.has_value()) {
-    this->set_max_refresh_rate(this->controller_->getMaxRefreshRate());
+    this->set_max_refresh_rate(max_refresh_rate);
   }
   ESP_LOGCONFIG(TAG, "    Max refresh rate: %u", *this->max_refresh_rate_);
+  this->shown_leds_ = new CRGB[this->num_leds_];
+
+  if (this->dithering_) {
+    ESP_LOGCONFIG(TAG, "    Dithering: ON");
+    const int size = this->num_leds_ * 3;
+    const auto *raw = reinterpret_cast<const uint8_t *>(this->leds_);
+    this->high_res_leds_ = new uint16_t[size];
+    this->dither_error_ = new uint8_t[size];
+    for (int i = 0; i < size; i++) {
+      this->high_res_leds_[i] = raw[i] << 8;
+      // Seed the error with a spread-out pattern so that neighboring LEDs don't flip in lockstep.
+      this->dither_error_[i] = uint8_t(i * 167);
+    }
+  }
 }
 void FastLEDLightOutputComponent::loop() {
-  if (!this->next_show_)
+  if (!this->next_show_ && !this->dither_pending_)
     return;
 
   uint32_t now = micros();
@@ -52,21 +107,41 @@ void FastLEDLightOutputComponent::loop() {
   if (*this->max_refresh_rate_ != 0 && (now - this->last_refresh_) < *this->max_refresh_rate_) {
     return;
   }
-  this->last_refresh_ = now;
   this->next_show_ = false;
+  if (this->prevent_writing_leds_) {
+    // The effect of this light draws over the whole strip, give segments without an effect their LEDs back.
+    for (auto *segment : this->segments_) {
+      if (!segment->is_writing_leds_prevented())
+        segment->fill_leds();
+    }
+  }
+  if (this->dithering_)
+    this->dither_pending_ = this->dither_();
+
+  // Effects schedule a show after every frame they render, even if it didn't change anything.
+  const size_t size = this->num_leds_ * sizeof(CRGB);
+  if (this->has_shown_ && memcmp(this->leds_, this->shown_leds_, size) == 0)
+    return;
+  // Only look at the LEDs that changed to keep the number of LEDs that are on up to date.
+  for (int i = 0; i < this->num_leds_; i++) {
+    const CRGB &led = this->leds_[i];
+    CRGB &shown = this->shown_leds_[i];
+    if (this->has_shown_ && led == shown)
+      continue;
+    const bool was_on = this->has_shown_ && (shown.r | shown.g | shown.b) != 0;
+    const bool is_on = (led.r | led.g | led.b) != 0;
+    this->num_on_leds_ += int(is_on) - int(was_on);
+    shown = led;
+  }
+  this->has_shown_ = true;
+  this->last_refresh_ = now;
 
   ESP_LOGVV(TAG, "Writing RGB values to bus...");
 
 #ifdef USE_OUTPUT
   if (this->power_supply_ != nullptr) {
-    bool is_on = false;
-    for (int i = 0; i < this->num_leds_; i++) {
-      if (bool(this->leds_[i])) {
-        is_on = true;
-        break;
-      }
-    }
-
+    // While dithering very dark colors, some frames may be all-black. Keep the power supply on for those.
+    const bool is_on = this->num_on_leds_ != 0 || this->dither_pending_;
     if (is_on && !this->has_requested_high_power_) {
       this->power_supply_->request_high_power();
       this->has_requested_high_power_ = true;
@@ -78,40 +153,95 @@ void FastLEDLightOutputComponent::loop() {
   }
 #endif
 
-  this->controller_->showLeds();
+  // Flush all strips back-to-back in the same frame.
+  for (auto &c : this->controllers_)
+    c.controller->showLeds();
+}
+bool FastLEDLightOutputComponent::dither_() {
+  auto *dst = reinterpret_cast<uint8_t *>(this->leds_);
+  bool pending = false;
+  // Skip only the LEDs that are currently drawn by an effect, either of this light or of a segment.
+  this->for_each_range_([&](int start, int end, BaseFastLEDLightOutput *owner) {
+    if (owner->is_writing_leds_prevented())
+      return;
+    pending |= dither_range(this->high_res_leds_ + start * 3, this->dither_error_ + start * 3, dst + start * 3,
+                            (end - start) * 3);
+  });
+  return pending;
 }
 void FastLEDLightOutputComponent::schedule_show() {
   this->next_show_ = true;
 }
 CLEDController &FastLEDLightOutputComponent::add_leds(CLEDController *controller, int num_leds) {
-  assert(this->controller_ == nullptr && "FastLEDLightOutputComponent only supports one controller at a time.");
+  assert_construction_state(this);
+  // Grow the shared frame buffer, the LEDs of the new controller are appended to the end.
+  const int offset = this->num_leds_;
+  auto *leds = new CRGB[offset + num_leds];
+  for (int i = 0; i < offset; i++)
+    leds[i] = this->leds_[i];
+  for (int i = offset; i < offset + num_leds; i++)
+    leds[i] = CRGB::Black;
+  delete[] this->leds_;
+  this->leds_ = leds;
+  this->num_leds_ = offset + num_leds;
 
-  this->controller_ = controller;
-  this->num_leds_ = num_leds;
-  this->leds_ = new CRGB[num_leds];
-
-  for (int i = 0; i < this->num_leds_; i++)
-    this->leds_[i] = CRGB::Black;
-
-  return *this->controller_;
+  this->controllers_.push_back(Controller{
+      .controller = controller,
+      .offset = offset,
+      .num_leds = num_leds,
+  });
+  return *controller;
 }
 CRGB *FastLEDLightOutputComponent::get_leds() const {
   return this->leds_;
 }
-CLEDController *FastLEDLightOutputComponent::get_controller() const {
-  return this->controller_;
+CLEDController *FastLEDLightOutputComponent::get_controller(size_t index) const {
+  if (index >= this->controllers_.size())
+    return nullptr;
+  return this->controllers_[index].controller;
 }
 void FastLEDLightOutputComponent::set_max_refresh_rate(uint32_t interval_us) {
   this->max_refresh_rate_ = interval_us;
 }
-int FastLEDLightOutputComponent::get_num_leds() const {
-  return this->num_leds_;
+void FastLEDLightOutputComponent::set_dithering(bool dithering) {
+  assert_construction_state(this);
+  this->dithering_ = dithering;
 }
-void FastLEDLightOutputComponent::unprevent_writing_leds() {
-  this->prevent_writing_leds_ = false;
+uint16_t *FastLEDLightOutputComponent::get_high_res_leds() const {
+  return this->high_res_leds_;
 }
-void FastLEDLightOutputComponent::prevent_writing_leds() {
-  this->prevent_writing_leds_ = true;
+void FastLEDLightOutputComponent::fill_leds() {
+  this->for_each_range_([this](int start, int end, BaseFastLEDLightOutput *owner) {
+    if (owner == this)
+      this->fill_leds_(start, end);
+  });
+}
+template<typename F>
+void FastLEDLightOutputComponent::for_each_range_(F &&f) {
+  // segments_ is sorted by offset
+  int start = 0;
+  for (auto *segment : this->segments_) {
+    const int offset = std::min(segment->get_offset(), this->num_leds_);
+    if (offset > start)
+      f(start, offset, this);
+    const int end = offset + segment->get_num_leds();
+    if (end > start) {
+      f(std::max(start, offset), end, segment);
+      start = end;
+    }
+  }
+  if (this->num_leds_ > start)
+    f(start, this->num_leds_, this);
+}
+void FastLEDLightOutputComponent::register_segment(FastLEDLightSegment *segment) {
+  auto it = std::upper_bound(this->segments_.begin(), this->segments_.end(), segment,
+                             [](FastLEDLightSegment *a, FastLEDLightSegment *b) {
+    return a->get_offset() < b->get_offset();
+  });
+  this->segments_.insert(it, segment);
+}
+int FastLEDLightOutputComponent::get_num_leds() const {
+  return this->num_leds_;
 }
 float FastLEDLightOutputComponent::get_setup_priority() const {
   return setup_priority::HARDWARE;
@@ -122,6 +252,32 @@ void FastLEDLightOutputComponent::set_power_supply(PowerSupplyComponent *power_s
 }
 #endif
 
+FastLEDLightSegment::FastLEDLightSegment(FastLEDLightOutputComponent *parent, int offset, int num_leds)
+    : parent_(parent), offset_(offset), num_leds_(num_leds) {
+  this->parent_->register_segment(this);
+}
+void FastLEDLightSegment::schedule_show() {
+  this->parent_->schedule_show();
+}
+CRGB *FastLEDLightSegment::get_leds() const {
+  return this->parent_->get_leds() + this->offset_;
+}
+uint16_t *FastLEDLightSegment::get_high_res_leds() const {
+  uint16_t *high_res = this->parent_->get_high_res_leds();
+  if (high_res == nullptr)
+    return nullptr;
+  return high_res + this->offset_ * 3;
+}
+int FastLEDLightSegment::get_num_leds() const {
+  return clamp(0, this->parent_->get_num_leds() - this->offset_, this->num_leds_);
+}
+FastLEDLightOutputComponent *FastLEDLightSegment::get_parent() const {
+  return this->parent_;
+}
+int FastLEDLightSegment::get_offset() const {
+  return this->offset_;
+}
+
 } // namespace light
 
 ESPHOMELIB_NAMESPACE_END
@@ -29,6 +29,61 @@ ESPHOMELIB_NAMESPACE_BEGIN
 
 namespace light {
 
+class FastLEDLightSegment;
+
+/** Base class for all light outputs that expose a range of individually addressable FastLED LEDs.
+ *
+ * Addressable light effects (see BaseFastLEDLightEffect) only work with this interface, so they can be used
+ * both on a whole FastLEDLightOutputComponent and on a single FastLEDLightSegment of it.
+ *
+ * The LEDs of a segment belong to the segment: the color of the parent light only fills the LEDs that
+ * aren't part of any segment. Effects of the parent light draw over the whole strip, but segments that
+ * aren't running an effect themselves get their LEDs back before every show.
+ */
+class BaseFastLEDLightOutput : public LightOutput {
+ public:
+  /// Only for custom effects: Tell the output to write the new color values on the next loop() iteration.
+  virtual void schedule_show() = 0;
+
+  /// Only for custom effects: Get a pointer to the first CRGB color value of this output.
+  virtual CRGB *get_leds() const = 0;
+
+  /// Only for custom effects: Get the number of LEDs managed by this output.
+  virtual int get_num_leds() const = 0;
+
+  /// Only for custom effects: Prevent the LightState from writing over all color values in CRGB.
+  void prevent_writing_leds();
+
+  /// Only for custom effects: Stop prevent_writing_leds. Call this when your effect terminates.
+  void unprevent_writing_leds();
+
+  bool is_writing_leds_prevented() const;
+
+  // ========== INTERNAL METHODS ==========
+  // (In most use cases you won't need these)
+  LightTraits get_traits() override;
+  void write_state(LightState *state) override;
+
+  /// Write the color of the last write_state() call to all LEDs owned by this output.
+  virtual void fill_leds();
+
+  /** Get a pointer to the first high-resolution color value of this output or nullptr if dithering is disabled.
+   *
+   * The buffer stores 3 channels (R, G, B) per LED in 8.8 fixed-point format (0 to 65280).
+   */
+  virtual uint16_t *get_high_res_leds() const = 0;
+
+ protected:
+  /// Write the color of the last write_state() call to the LEDs [start, end) of this output.
+  void fill_leds_(int start, int end);
+
+  bool prevent_writing_leds_{false};
+  /// The color of the last write_state() call in 8.8 fixed-point (0 to 65280).
+  uint16_t red_{0};
+  uint16_t green_{0};
+  uint16_t blue_{0};
+};
+
 /** This component implements support for many types of addressable LED lights.
  *
  * To do this, it uses the FastLED library. The API for setting up the different
@@ -36,36 +91,44 @@ namespace light {
  * as possible. To use FastLED lights with esphomelib, first set up the component using
  * the helper in Application, then add the LEDs using the `add_leds` helper functions.
  *
- * These add_leds helpers can, however, only be called once on a FastLEDLightOutput. Also,
- * with this component you cannot pass in the CRGB array and offset values as you would be
- * able to do with FastLED as the component manage the lights itself.
+ * The add_leds helpers can be called several times to drive multiple strips (controllers)
+ * from one component. All strips share one frame buffer (the LEDs of each new controller are
+ * appended to the end) and are flushed together in a single show per frame. Use
+ * FastLEDLightSegment (see Application::make_fast_led_light_segment) to expose parts of this
+ * buffer as separate lights, the light of this component then covers the remaining LEDs.
+ * With this component you cannot pass in the CRGB array and offset
+ * values as you would be able to do with FastLED as the component manage the lights itself.
  */
-class FastLEDLightOutputComponent : public LightOutput, public Component {
+class FastLEDLightOutputComponent : public BaseFastLEDLightOutput, public Component {
  public:
   /// Only for custom effects: Tell this component to write the new color values on the next loop() iteration.
-  void schedule_show();
+  void schedule_show() override;
 
   /// Only for custom effects: Get a pointer to the internal array of CRGB color values.
-  CRGB *get_leds() const;
+  CRGB *get_leds() const override;
 
-  /// Only for custom effects: Get the number of LEDs managed by this component.
-  int get_num_leds() const;
+  /// Only for custom effects: Get the number of LEDs managed by this component (across all controllers).
+  int get_num_leds() const override;
 
-  /// Only for custom effects: Get the internal controller.
-  CLEDController *get_controller() const;
+  /// Only for custom effects: Get the internal controller with the given index (in the order they were added).
+  CLEDController *get_controller(size_t index = 0) const;
 
   /// Set a maximum refresh rate in µs as some lights do not like being updated too often.
   void set_max_refresh_rate(uint32_t interval_us);
 
-  /// Only for custom effects: Prevent the LightState from writing over all color values in CRGB.
-  void prevent_writing_leds();
-
-  /// Only for custom effects: Stop prevent_writing_leds. Call this when your effect terminates.
-  void unprevent_writing_leds();
-
   void set_power_supply(PowerSupplyComponent *power_supply);
 
-  /// Add some LEDS, can only be called once.
+  /** Enable temporal dithering, defaults to false. Must be called before setup().
+   *
+   * With dithering, the light state is kept in a 16-bit buffer and the fractional part that
+   * doesn't fit into 8 bits is carried over to the next frames. This makes slow fades near black
+   * look smooth at the cost of 4 bytes of RAM per LED and pushing frames continuously while a color
+   * doesn't map to an exact 8-bit value. Only applies to colors set by the light state, effects still
+   * write the 8-bit CRGB buffer directly.
+   */
+  void set_dithering(bool dithering);
+
+  /// Add some LEDS driven by controller, they are appended to the end of the frame buffer.
   CLEDController &add_leds(CLEDController *controller, int num_leds);
 
   template<ESPIChipsets CHIPSET, uint8_t DATA_PIN, uint8_t CLOCK_PIN, EOrder RGB_ORDER, uint8_t SPI_DATA_RATE>
@@ -335,26 +398,89 @@ class FastLEDLightOutputComponent : public LightOutput, public Component {
 
   // ========== INTERNAL METHODS ==========
   // (In most use cases you won't need these)
-  LightTraits get_traits() override;
-  void write_state(LightState *state) override;
   void setup() override;
   void loop() override;
   float get_setup_priority() const override;
+  uint16_t *get_high_res_leds() const override;
+  /// Write the color of the last write_state() call to all LEDs that aren't part of a segment.
+  void fill_leds() override;
+  /// Register a segment, its LEDs are excluded from the color of this light.
+  void register_segment(FastLEDLightSegment *segment);
 
  protected:
-  CLEDController *controller_{nullptr};
+  /** Call f(start, end, owner) for consecutive ranges covering the whole frame buffer.
+   *
+   * owner is the segment the LEDs [start, end) belong to, or this component for LEDs outside of all segments.
+   * If segments overlap, the LEDs belong to the segment with the lower offset.
+   */
+  template<typename F>
+  void for_each_range_(F &&f);
+
+  /// Dither the high-resolution buffer into the CRGB buffer. Returns true if another frame is needed.
+  bool dither_();
+
+  /// Internal struct to store which part of the frame buffer a controller drives.
+  struct Controller {
+    CLEDController *controller;
+    int offset;
+    int num_leds;
+  };
+
+  std::vector<Controller> controllers_;
   CRGB *leds_{nullptr};
   int num_leds_{0};
   uint32_t last_refresh_{0};
   optional<uint32_t> max_refresh_rate_{};
-  bool prevent_writing_leds_{false};
+  /// Set by all writers through schedule_show(), nothing is compared or pushed while this is false.
   bool next_show_{true};
+  /// Copy of the frame that's currently on the strips, used to skip identical frames (3 bytes of RAM per LED).
+  CRGB *shown_leds_{nullptr};
+  /// Whether shown_leds_ is valid, the first frame after boot is always pushed.
+  bool has_shown_{false};
+  /// Number of LEDs in shown_leds_ that are not black, updated only for LEDs that changed.
+  int num_on_leds_{0};
+  bool dithering_{false};
+  /// 8.8 fixed-point color values (3 per LED), only allocated if dithering is enabled.
+  uint16_t *high_res_leds_{nullptr};
+  /// The accumulated quantization error (3 per LED) that is carried over to the next frame.
+  uint8_t *dither_error_{nullptr};
+  /// Whether the last dithered frame still had fractional values that need more frames.
+  bool dither_pending_{false};
+  std::vector<FastLEDLightSegment *> segments_;
 #ifdef USE_OUTPUT
   PowerSupplyComponent *power_supply_{nullptr};
   bool has_requested_high_power_{false};
 #endif
 };
 
+/** A logical segment of a FastLEDLightOutputComponent that can be used as a separate light.
+ *
+ * A segment doesn't have its own frame buffer, it only writes to the LEDs [offset, offset + num_leds)
+ * of its parent. The parent then flushes all strips together in one synchronized show.
+ */
+class FastLEDLightSegment : public BaseFastLEDLightOutput {
+ public:
+  FastLEDLightSegment(FastLEDLightOutputComponent *parent, int offset, int num_leds);
+
+  void schedule_show() override;
+
+  CRGB *get_leds() const override;
+
+  uint16_t *get_high_res_leds() const override;
+
+  /// Get the number of LEDs in this segment, clipped to the LEDs that are actually available in the parent.
+  int get_num_leds() const override;
+
+  FastLEDLightOutputComponent *get_parent() const;
+
+  int get_offset() const;
+
+ protected:
+  FastLEDLightOutputComponent *parent_;
+  int offset_;
+  int num_leds_;
+};
+
 } // namespace light
 
 ESPHOMELIB_NAMESPACE_END
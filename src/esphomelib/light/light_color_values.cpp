@@ -22,67 +22,98 @@ namespace light {
 static const char *TAG = "light.light_color_values";
 
 float LightColorValues::get_state() const {
-  return this->state_;
+  return raw_to_float(this->state_);
 }
 
 void LightColorValues::set_state(float state) {
-  this->state_ = clamp(0.0f, 1.0f, state);
+  this->state_ = float_to_raw(state);
 }
 
 float LightColorValues::get_brightness() const {
-  return this->brightness_;
+  return raw_to_float(this->brightness_);
 }
 
 void LightColorValues::set_brightness(float brightness) {
-  this->brightness_ = clamp(0.0f, 1.0f, brightness);
+  this->brightness_ = float_to_raw(brightness);
 }
 
 float LightColorValues::get_red() const {
-  return this->red_;
+  return raw_to_float(this->red_);
 }
 
 void LightColorValues::set_red(float red) {
-  this->red_ = clamp(0.0f, 1.0f, red);
+  this->red_ = float_to_raw(red);
 }
 
 float LightColorValues::get_green() const {
-  return this->green_;
+  return raw_to_float(this->green_);
 }
 
 void LightColorValues::set_green(float green) {
-  this->green_ = clamp(0.0f, 1.0f, green);
+  this->green_ = float_to_raw(green);
 }
 
 float LightColorValues::get_blue() const {
-  return this->blue_;
+  return raw_to_float(this->blue_);
 }
 
 void LightColorValues::set_blue(float blue) {
-  this->blue_ = clamp(0.0f, 1.0f, blue);
+  this->blue_ = float_to_raw(blue);
 }
 
 float LightColorValues::get_white() const {
-  return white_;
+  return raw_to_float(this->white_);
 }
 
 void LightColorValues::set_white(float white) {
-  this->white_ = clamp(0.0f, 1.0f, white);
+  this->white_ = float_to_raw(white);
 }
 
 LightColorValues::LightColorValues()
-    : state_(0.0f), brightness_(1.0f), red_(1.0f), green_(1.0f), blue_(1.0f), white_(1.0f) {
+    : state_(0), brightness_(0xFFFF), red_(0xFFFF), green_(0xFFFF), blue_(0xFFFF), white_(0xFFFF) {
 
 }
 
+uint16_t LightColorValues::float_to_raw(float value) {
+  if (!(value > 0.0f)) // also catches NaN
+    return 0;
+  if (value >= 1.0f)
+    return 0xFFFF;
+  return uint16_t(value * 65535.0f + 0.5f);
+}
+
+float LightColorValues::raw_to_float(uint16_t value) {
+  return value * (1.0f / 65535.0f);
+}
+
+/// Calculate round(a * b / 65535) without any division.
+static uint16_t mul_raw_value(uint16_t a, uint16_t b) {
+  // Rounded division by 65535, (x + (x >> 16) + 1) >> 16 is exact for all possible x here.
+  const uint32_t x = uint32_t(a) * b + 32767u;
+  return uint16_t((x + (x >> 16) + 1u) >> 16);
+}
+
+/// Calculate round(start + (end - start) * completion / 65535) without any division.
+static uint16_t lerp_raw_value(uint16_t start, uint16_t end, uint16_t completion) {
+  if (end < start)
+    return start - mul_raw_value(start - end, completion);
+  return start + mul_raw_value(end - start, completion);
+}
+
 LightColorValues LightColorValues::lerp(const LightColorValues &start, const LightColorValues &end,
                                         float completion) {
+  return LightColorValues::lerp_raw(start, end, float_to_raw(completion));
+}
+
+LightColorValues LightColorValues::lerp_raw(const LightColorValues &start, const LightColorValues &end,
+                                            uint16_t completion) {
   LightColorValues v;
-  v.set_state(esphomelib::lerp(start.get_state(), end.get_state(), completion));
-  v.set_brightness(esphomelib::lerp(start.get_brightness(), end.get_brightness(), completion));
-  v.set_red(esphomelib::lerp(start.get_red(), end.get_red(), completion));
-  v.set_green(esphomelib::lerp(start.get_green(), end.get_green(), completion));
-  v.set_blue(esphomelib::lerp(start.get_blue(), end.get_blue(), completion));
-  v.set_white(esphomelib::lerp(start.get_white(), end.get_white(), completion));
+  v.state_ = lerp_raw_value(start.state_, end.state_, completion);
+  v.brightness_ = lerp_raw_value(start.brightness_, end.brightness_, completion);
+  v.red_ = lerp_raw_value(start.red_, end.red_, completion);
+  v.green_ = lerp_raw_value(start.green_, end.green_, completion);
+  v.blue_ = lerp_raw_value(start.blue_, end.blue_, completion);
+  v.white_ = lerp_raw_value(start.white_, end.white_, completion);
 
   return v;
 }
@@ -141,7 +172,7 @@ void LightColorValues::parse_json(const JsonObject &root) {
   }
 
   if (root.containsKey("white_value")) {
-    this->white_ = float(root["white_value"]) / 255.0f;
+    this->set_white(float(root["white_value"]) / 255.0f);
     ESP_LOGV(TAG, "    white_value=%.2f", this->get_white());
   }
 }
@@ -187,18 +218,52 @@ bool LightColorValues::operator!=(const LightColorValues &rhs) const {
 }
 void LightColorValues::as_rgbw(float *red, float *green, float *blue, float *white) const {
   this->as_rgb(red, green, blue);
-  *white = this->state_ * this->brightness_ * this->white_;
+  *white = this->get_state() * this->get_brightness() * this->get_white();
 }
 void LightColorValues::as_rgb(float *red, float *green, float *blue) const {
-  *red = this->state_ * this->brightness_ * this->red_;
-  *green = this->state_ * this->brightness_ * this->green_;
-  *blue = this->state_ * this->brightness_ * this->blue_;
+  const float brightness = this->get_state() * this->get_brightness();
+  *red = brightness * this->get_red();
+  *green = brightness * this->get_green();
+  *blue = brightness * this->get_blue();
 }
 void LightColorValues::as_brightness(float *brightness) const {
-  *brightness = this->state_ * this->brightness_;
+  *brightness = this->get_state() * this->get_brightness();
+}
+void LightColorValues::as_brightness_raw(uint16_t *brightness) const {
+  *brightness = mul_raw_value(this->state_, this->brightness_);
+}
+void LightColorValues::as_rgb_raw(uint16_t *red, uint16_t *green, uint16_t *blue) const {
+  uint16_t brightness;
+  this->as_brightness_raw(&brightness);
+  *red = mul_raw_value(brightness, this->red_);
+  *green = mul_raw_value(brightness, this->green_);
+  *blue = mul_raw_value(brightness, this->blue_);
+}
+void LightColorValues::as_rgbw_raw(uint16_t *red, uint16_t *green, uint16_t *blue, uint16_t *white) const {
+  this->as_rgb_raw(red, green, blue);
+  uint16_t brightness;
+  this->as_brightness_raw(&brightness);
+  *white = mul_raw_value(brightness, this->white_);
 }
 void LightColorValues::as_binary(bool *binary) const {
-  *binary = this->state_ == 1.0f;
+  *binary = this->state_ == 0xFFFF;
+}
+
+void LightGammaTable::compute(float gamma) {
+  this->table_.resize(257);
+  for (size_t i = 0; i < this->table_.size(); i++)
+    this->table_[i] = LightColorValues::float_to_raw(gamma_correct(i / 256.0f, gamma));
+}
+uint16_t LightGammaTable::correct(uint16_t value) const {
+  // Map [0, 65535] onto [0, 65536] (rounded) so that full brightness hits the last table entry exactly.
+  const uint32_t pos = uint32_t(value) + (value >> 15);
+  const uint32_t index = pos >> 8;
+  if (index >= 256)
+    return this->table_[256];
+  const uint32_t frac = pos & 0xFF;
+  const int32_t a = this->table_[index];
+  const int32_t b = this->table_[index + 1];
+  return uint16_t(a + (((b - a) * int32_t(frac)) >> 8));
 }
 
 } // namespace light
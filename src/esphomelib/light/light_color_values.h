@@ -7,6 +7,7 @@
 
 #include <ArduinoJson.h>
 #include <string>
+#include <vector>
 
 #include "esphomelib/light/light_traits.h"
 #include "esphomelib/defines.h"
@@ -25,6 +26,10 @@ namespace light {
  *
  * PLease note all float values are automatically clamped.
  *
+ * Internally, all values are stored as 16-bit fixed-point numbers (0 -> 0.0, 65535 -> 1.0) so that
+ * transitions, which are calculated every loop() cycle, don't need any floating point math. This is
+ * important on the ESP8266 which doesn't have an FPU.
+ *
  * state - Whether the light should be on/off. Represented as a float for transitions.
  * brightness - The brightness of the light.
  * red, green, blue - RGB values.
@@ -49,6 +54,21 @@ class LightColorValues {
    */
   static LightColorValues lerp(const LightColorValues &start, const LightColorValues &end, float completion);
 
+  /** Linearly interpolate between the values in start to the values in end using only integer math.
+   *
+   * @param start The interpolation start values.
+   * @param end The interpolation end values.
+   * @param completion The 16-bit fixed-point completion value. 0 -> start, 65535 -> end.
+   * @return The linearly interpolated LightColorValues.
+   */
+  static LightColorValues lerp_raw(const LightColorValues &start, const LightColorValues &end, uint16_t completion);
+
+  /// Convert a float in the range from 0.0 to 1.0 to the internal 16-bit fixed-point representation.
+  static uint16_t float_to_raw(float value);
+
+  /// Convert a 16-bit fixed-point value back to a float in the range from 0.0 to 1.0.
+  static float raw_to_float(uint16_t value);
+
   /** Load the color values from the non-volatile storage container preferences into the this object.
    *
    * @param friendly_name The friendly name of the component that's calling this.
@@ -95,6 +115,15 @@ class LightColorValues {
 
   void as_rgbw(float *red, float *green, float *blue, float *white) const;
 
+  /// Like as_brightness(), but return the value in the 16-bit fixed-point representation.
+  void as_brightness_raw(uint16_t *brightness) const;
+
+  /// Like as_rgb(), but return the values in the 16-bit fixed-point representation.
+  void as_rgb_raw(uint16_t *red, uint16_t *green, uint16_t *blue) const;
+
+  /// Like as_rgbw(), but return the values in the 16-bit fixed-point representation.
+  void as_rgbw_raw(uint16_t *red, uint16_t *green, uint16_t *blue, uint16_t *white) const;
+
   /// Compare this LightColorValues to rhs, return true iff all attributes match.
   bool operator==(const LightColorValues &rhs) const;
   bool operator!=(const LightColorValues &rhs) const;
@@ -118,12 +147,31 @@ class LightColorValues {
   void set_white(float white);
 
  protected:
-  float state_; ///< ON / OFF, float for transition
-  float brightness_;
-  float red_;
-  float green_;
-  float blue_;
-  float white_;
+  uint16_t state_; ///< ON / OFF, not binary for transition
+  uint16_t brightness_;
+  uint16_t red_;
+  uint16_t green_;
+  uint16_t blue_;
+  uint16_t white_;
+};
+
+/** Gamma correction lookup table with 256 segments (+1 end point) spanning 0.0 to 1.0.
+ *
+ * Applying gamma correction with powf for every channel on every output write is quite expensive,
+ * especially on the ESP8266 which has no FPU. Instead, the curve is sampled once when the gamma value
+ * changes and values are corrected by linearly interpolating the table. For gamma values >= 1 this
+ * stays within 1/40 of an 8-bit output step of powf.
+ */
+class LightGammaTable {
+ public:
+  /// Fill the table with the curve for the given gamma value.
+  void compute(float gamma);
+
+  /// Gamma-correct a 16-bit fixed-point value, compute() must have been called before.
+  uint16_t correct(uint16_t value) const;
+
+ protected:
+  std::vector<uint16_t> table_;
 };
 
 } // namespace light
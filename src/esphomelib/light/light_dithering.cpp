@@ -0,0 +1,32 @@
+//
+//  light_dithering.cpp
+//  esphomelib
+//
+//  Copyright © 2018 Otto Winter. All rights reserved.
+//
+
+#include "esphomelib/light/light_dithering.h"
+
+#ifdef USE_LIGHT
+
+ESPHOMELIB_NAMESPACE_BEGIN
+
+namespace light {
+
+bool dither_range(const uint16_t *src, uint8_t *error, uint8_t *dst, size_t len) {
+  uint16_t fraction = 0;
+  for (size_t i = 0; i < len; i++) {
+    // src is at most 65280 (255.0), so this can't overflow
+    const uint16_t value = src[i] + error[i];
+    dst[i] = value >> 8;
+    error[i] = value & 0xFF;
+    fraction |= src[i];
+  }
+  return (fraction & 0xFF) != 0;
+}
+
+} // namespace light
+
+ESPHOMELIB_NAMESPACE_END
+
+#endif //USE_LIGHT
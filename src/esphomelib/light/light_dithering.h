@@ -0,0 +1,42 @@
+//
+//  light_dithering.h
+//  esphomelib
+//
+//  Copyright © 2018 Otto Winter. All rights reserved.
+//
+
+#ifndef ESPHOMELIB_LIGHT_LIGHT_DITHERING_H
+#define ESPHOMELIB_LIGHT_LIGHT_DITHERING_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esphomelib/defines.h"
+
+#ifdef USE_LIGHT
+
+ESPHOMELIB_NAMESPACE_BEGIN
+
+namespace light {
+
+/** Temporal dithering kernel over len 8.8 fixed-point channel values.
+ *
+ * Adds the error carried over from the last frame to each value, outputs the integer part and keeps the
+ * fractional part as the new error. Over 256 frames, the 8-bit outputs of a channel add up to exactly
+ * 256 times its 8.8 value. Kept branch-free so the compiler can vectorize it.
+ *
+ * @param src The 8.8 fixed-point values, at most 65280 (255.0).
+ * @param error The error of each value, carried over from frame to frame.
+ * @param dst The 8-bit output values.
+ * @param len The number of values.
+ * @return Whether any value has a fractional part, i.e. whether the next frame will differ.
+ */
+bool dither_range(const uint16_t *src, uint8_t *error, uint8_t *dst, size_t len);
+
+} // namespace light
+
+ESPHOMELIB_NAMESPACE_END
+
+#endif //USE_LIGHT
+
+#endif //ESPHOMELIB_LIGHT_LIGHT_DITHERING_H
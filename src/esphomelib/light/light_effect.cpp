@@ -6,7 +6,7 @@
 
 #include "esphomelib/helpers.h"
 #include "esphomelib/esphal.h"
-#include "esphomelib/light/fast_led_light_output.h"
+#include "esphomelib/light/fast_led_light_effect.h"
 
 #ifdef USE_LIGHT
 
@@ -32,6 +32,26 @@ std::vector<LightEffect::Entry> light_effect_entries = { // NOLINT
         .requirements = LightTraits(true, true, false, true),
         .constructor = FastLEDRainbowLightEffect::create
     },
+    LightEffect::Entry{
+        .name = "Color Wipe Effect",
+        .requirements = LightTraits(true, true, false, true),
+        .constructor = FastLEDColorWipeLightEffect::create
+    },
+    LightEffect::Entry{
+        .name = "Twinkle Effect",
+        .requirements = LightTraits(true, true, false, true),
+        .constructor = FastLEDTwinkleLightEffect::create
+    },
+    LightEffect::Entry{
+        .name = "Scan Effect",
+        .requirements = LightTraits(true, true, false, true),
+        .constructor = FastLEDScanLightEffect::create
+    },
+    LightEffect::Entry{
+        .name = "Fireworks Effect",
+        .requirements = LightTraits(true, true, false, true),
+        .constructor = FastLEDFireworksLightEffect::create
+    },
 #endif
 };
 
@@ -84,40 +104,6 @@ std::unique_ptr<LightEffect> RandomLightEffect::create() {
 RandomLightEffect::RandomLightEffect()
     : last_color_change_(millis() - 10000) {}
 
-#ifdef USE_FAST_LED_LIGHT
-std::unique_ptr<light::LightEffect> FastLEDRainbowLightEffect::create() {
-  return make_unique<FastLEDRainbowLightEffect>();
-}
-
-std::string FastLEDRainbowLightEffect::get_name() const {
-  return "Rainbow Effect";
-}
-
-void FastLEDRainbowLightEffect::apply_effect(light::LightState *state) {
-  auto *output = (light::FastLEDLightOutputComponent *) state->get_output();
-  uint8_t hue = millis() / 75;
-  fill_rainbow(output->get_leds(), output->get_num_leds(), hue, 14);
-
-  // make the output show the effect
-  output->schedule_show();
-}
-void FastLEDRainbowLightEffect::initialize(light::LightState *state) {
-  // Prevent any normal light set calls (like setting color manually) affecting our LED array
-  // while this effect is active. Otherwise, when choosing a color from the front-end while
-  // this effect is active, all LEDS would briefly go to the new color but then right back due
-  // to this effect
-
-  auto *output = (FastLEDLightOutputComponent *) state->get_output();
-  output->prevent_writing_leds();
-}
-void FastLEDRainbowLightEffect::stop(light::LightState *state) {
-  // Tell the light output to respond to normal requests again.
-
-  auto *output = (FastLEDLightOutputComponent *) state->get_output();
-  output->unprevent_writing_leds();
-}
-#endif
-
 } // namespace light
 
 ESPHOMELIB_NAMESPACE_END
@@ -7,6 +7,7 @@
 #include "esphomelib/helpers.h"
 #include "esphomelib/log.h"
 #include "esphomelib/esphal.h"
+#include "esphomelib/rtc_memory.h"
 #include "esphomelib/light/light_transformer.h"
 #include "esphomelib/light/light_effect.h"
 
@@ -54,6 +55,7 @@ void LightState::start_flash(const LightColorValues &target, uint32_t length) {
 LightState::LightState(const std::string &name, LightOutput *output)
   : Nameable(name), output_(output) {
   this->effect_ = std::move(NoneLightEffect::create());
+  this->gamma_table_.compute(this->gamma_correct_);
 }
 
 void LightState::set_immediately_without_sending(const LightColorValues &target) {
@@ -85,6 +87,25 @@ LightColorValues LightState::get_current_values() {
 void LightState::send_values() {
   this->remote_values_callback_.call();
   this->next_write_ = true;
+  this->schedule_save_();
+}
+void LightState::schedule_save_() {
+  // (Re-)start the save timer, the values are only written once they've been stable for save_delay_.
+  this->set_timeout("save", this->save_delay_, [this]() {
+    this->save_values_();
+  });
+}
+void LightState::save_values_() {
+  // Effects change the values every few seconds for as long as they run, writing each of those would
+  // wear out the flash. The values are saved again once the effect is stopped.
+  if (this->get_effect_name() != "None")
+    return;
+  LightColorValues remote_values = this->get_remote_values();
+  if (remote_values == this->saved_values_)
+    return;
+  ESP_LOGV(TAG, "Saving light state of '%s' to preferences.", this->get_name().c_str());
+  remote_values.save_to_preferences(this->get_name());
+  this->saved_values_ = remote_values;
 }
 
 LightColorValues LightState::get_remote_values() {
@@ -141,6 +162,7 @@ void LightState::set_transformer(std::unique_ptr<LightTransformer> transformer)
 void LightState::stop_effect() {
   this->effect_->stop(this);
   this->effect_ = std::move(NoneLightEffect::create());
+  this->schedule_save_();
 }
 void LightState::parse_json(const JsonObject &root) {
   ESP_LOGV(TAG, "Interpreting light JSON.");
@@ -179,8 +201,23 @@ void LightState::start_default_transition(const LightColorValues &target) {
 void LightState::setup() {
   ESP_LOGCONFIG(TAG, "Setting up light '%s'...", this->get_name().c_str());
   LightColorValues recovered_values;
-  recovered_values.load_from_preferences(this->get_name());
+  // Pending saves are flushed by the safe shutdown hook before deep sleep, so the state
+  // in RTC memory always matches the one in the preferences.
+  if (!global_rtc_memory.restore(this->get_name(), "light", &recovered_values))
+    recovered_values.load_from_preferences(this->get_name());
+  this->saved_values_ = recovered_values;
   this->set_immediately(recovered_values);
+
+  if (global_rtc_memory.are_snapshots_enabled()) {
+    global_rtc_memory.add_on_snapshot_callback([this]() {
+      global_rtc_memory.save(this->get_name(), "light", this->get_remote_values());
+    });
+  }
+
+  add_safe_shutdown_hook([this](const char *cause) {
+    if (this->cancel_timeout("save"))
+      this->save_values_();
+  });
 }
 float LightState::get_setup_priority() const {
   return setup_priority::HARDWARE - 1.0f;
@@ -193,26 +230,42 @@ float LightState::get_gamma_correct() const {
 }
 void LightState::set_gamma_correct(float gamma_correct) {
   this->gamma_correct_ = gamma_correct;
+  this->gamma_table_.compute(this->gamma_correct_);
+}
+uint32_t LightState::get_save_delay() const {
+  return this->save_delay_;
+}
+void LightState::set_save_delay(uint32_t save_delay) {
+  this->save_delay_ = save_delay;
 }
 void LightState::current_values_as_binary(bool *binary) {
   this->get_current_values().as_binary(binary);
 }
 void LightState::current_values_as_brightness(float *brightness) {
-  this->get_current_values().as_brightness(brightness);
-  *brightness = gamma_correct(*brightness, this->gamma_correct_);
+  uint16_t raw;
+  this->get_current_values().as_brightness_raw(&raw);
+  *brightness = LightColorValues::raw_to_float(this->gamma_table_.correct(raw));
 }
 void LightState::current_values_as_rgb(float *red, float *green, float *blue) {
-  this->get_current_values().as_rgb(red, green, blue);
-  *red = gamma_correct(*red, this->gamma_correct_);
-  *green = gamma_correct(*green, this->gamma_correct_);
-  *blue = gamma_correct(*blue, this->gamma_correct_);
+  uint16_t raw_red, raw_green, raw_blue;
+  this->current_values_as_rgb_raw(&raw_red, &raw_green, &raw_blue);
+  *red = LightColorValues::raw_to_float(raw_red);
+  *green = LightColorValues::raw_to_float(raw_green);
+  *blue = LightColorValues::raw_to_float(raw_blue);
+}
+void LightState::current_values_as_rgb_raw(uint16_t *red, uint16_t *green, uint16_t *blue) {
+  this->get_current_values().as_rgb_raw(red, green, blue);
+  *red = this->gamma_table_.correct(*red);
+  *green = this->gamma_table_.correct(*green);
+  *blue = this->gamma_table_.correct(*blue);
 }
 void LightState::current_values_as_rgbw(float *red, float *green, float *blue, float *white) {
-  this->get_current_values().as_rgbw(red, green, blue, white);
-  *red = gamma_correct(*red, this->gamma_correct_);
-  *green = gamma_correct(*green, this->gamma_correct_);
-  *blue = gamma_correct(*blue, this->gamma_correct_);
-  *white = gamma_correct(*white, this->gamma_correct_);
+  uint16_t raw_red, raw_green, raw_blue, raw_white;
+  this->get_current_values().as_rgbw_raw(&raw_red, &raw_green, &raw_blue, &raw_white);
+  *red = LightColorValues::raw_to_float(this->gamma_table_.correct(raw_red));
+  *green = LightColorValues::raw_to_float(this->gamma_table_.correct(raw_green));
+  *blue = LightColorValues::raw_to_float(this->gamma_table_.correct(raw_blue));
+  *white = LightColorValues::raw_to_float(this->gamma_table_.correct(raw_white));
 }
 void LightState::loop() {
   this->effect_->apply_effect(this);
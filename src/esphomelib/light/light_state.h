@@ -23,7 +23,7 @@ ESPHOMELIB_NAMESPACE_BEGIN
 
 namespace light {
 
-using light_send_callback_t = std::function<void()>;
+using light_send_callback_t = InlineFunction<void()>;
 
 class LightEffect;
 class LightOutput;
@@ -84,6 +84,9 @@ class LightState : public Nameable, public Component {
 
   void current_values_as_rgb(float *red, float *green, float *blue);
 
+  /// Like current_values_as_rgb(), but returns gamma-corrected 16-bit fixed-point values (0 to 65535).
+  void current_values_as_rgb_raw(uint16_t *red, uint16_t *green, uint16_t *blue);
+
   void current_values_as_rgbw(float *red, float *green, float *blue, float *white);
 
   LightTraits get_traits();
@@ -153,10 +156,24 @@ class LightState : public Nameable, public Component {
   void set_default_transition_length(uint32_t default_transition_length);
 
   float get_gamma_correct() const;
-  /// Set the gamma correction factor
+  /// Set the gamma correction factor, this also re-computes the gamma correction lookup table.
   void set_gamma_correct(float gamma_correct);
 
+  uint32_t get_save_delay() const;
+  /** Set how long the light state has to be stable before it's written to flash, defaults to 5 seconds (5000 ms).
+   *
+   * Every new state restarts this timer, so quick successive changes (like from automations)
+   * only cause a single write. On a safe shutdown (OTA, shutdown switch, deep sleep) pending values are
+   * written immediately. Values are never written while an effect is running, only once it's stopped.
+   */
+  void set_save_delay(uint32_t save_delay);
+
  protected:
+  /// (Re-)start the timer that saves the values once they've been stable for the save delay.
+  void schedule_save_();
+  /// Write the current remote values to the preferences if they differ from the last saved values.
+  void save_values_();
+
   uint32_t default_transition_length_{1000};
   std::unique_ptr<LightEffect> effect_{nullptr};
   std::unique_ptr<LightTransformer> transformer_{nullptr};
@@ -164,7 +181,12 @@ class LightState : public Nameable, public Component {
   CallbackManager<void()> remote_values_callback_{};
   LightOutput *output_; ///< Store the output to allow effects to have more access.
   bool next_write_{true};
+  uint32_t save_delay_{5000};
+  /// The values that are currently stored in the preferences.
+  LightColorValues saved_values_{};
   float gamma_correct_{2.8f};
+  /// The gamma correction curve for gamma_correct_, only re-computed when the gamma value changes.
+  LightGammaTable gamma_table_;
 };
 
 /// Interface to write LightStates to hardware.
@@ -184,7 +206,7 @@ class ToggleAction : public Action<T> {
   void set_transition_length(std::function<uint32_t(T)> transition_length);
   void set_transition_length(uint32_t transition_length);
 
-  void play(T x) override;
+  bool play(T x) override;
 
  protected:
   LightState *state_;
@@ -199,7 +221,7 @@ class TurnOffAction : public Action<T> {
   void set_transition_length(std::function<uint32_t(T)> transition_length);
   void set_transition_length(uint32_t transition_length);
 
-  void play(T x) override;
+  bool play(T x) override;
 
  protected:
   LightState *state_;
@@ -228,7 +250,7 @@ class TurnOnAction : public Action<T> {
   void set_effect(std::function<std::string(T)> &&effect);
   void set_effect(std::string effect);
 
-  void play(T x) override;
+  bool play(T x) override;
 
  protected:
   LightState *state_;
@@ -260,7 +282,7 @@ template<typename T>
 ToggleAction<T>::ToggleAction(LightState *state) : state_(state) {}
 
 template<typename T>
-void ToggleAction<T>::play(T x) {
+bool ToggleAction<T>::play(T x) {
   auto v = this->state_->get_remote_values();
   if (v.get_state() > 0.0f)
     v.set_state(0.0f);
@@ -271,7 +293,7 @@ void ToggleAction<T>::play(T x) {
   } else {
     this->state_->start_default_transition(v);
   }
-  this->play_next(x);
+  return true;
 }
 template<typename T>
 void ToggleAction<T>::set_transition_length(std::function<uint32_t(T)> transition_length) {
@@ -284,7 +306,7 @@ void ToggleAction<T>::set_transition_length(uint32_t transition_length) {
 template<typename T>
 TurnOffAction<T>::TurnOffAction(LightState *state) : state_(state) {}
 template<typename T>
-void TurnOffAction<T>::play(T x) {
+bool TurnOffAction<T>::play(T x) {
   auto v = this->state_->get_remote_values();
   v.set_state(0.0f);
   if (this->transition_length_.has_value()) {
@@ -292,7 +314,7 @@ void TurnOffAction<T>::play(T x) {
   } else {
     this->state_->start_default_transition(v);
   }
-  this->play_next(x);
+  return true;
 }
 template<typename T>
 void TurnOffAction<T>::set_transition_length(std::function<uint32_t(T)> transition_length) {
@@ -303,7 +325,7 @@ void TurnOffAction<T>::set_transition_length(uint32_t transition_length) {
   this->transition_length_ = transition_length;
 }
 template<typename T>
-void TurnOnAction<T>::play(T x) {
+bool TurnOnAction<T>::play(T x) {
   auto v = this->state_->get_remote_values();
   v.set_state(1.0f);
   if (this->brightness_.has_value()) {
@@ -330,7 +352,7 @@ void TurnOnAction<T>::play(T x) {
   } else {
     this->state_->start_default_transition(v);
   }
-  this->play_next(x);
+  return true;
 }
 template<typename T>
 void TurnOnAction<T>::set_transition_length(std::function<uint32_t(T)> &&transition_length) {
@@ -4,6 +4,8 @@
 
 #include "esphomelib/light/light_transformer.h"
 
+#include <algorithm>
+
 #include "esphomelib/helpers.h"
 #include "esphomelib/component.h"
 #include "esphomelib/log.h"
@@ -29,11 +31,24 @@ LightTransformer::LightTransformer(uint32_t start_time, uint32_t length,
     start_time), length_(length), start_values_(start_values), target_values_(target_values) {}
 
 bool LightTransformer::is_finished() {
-  return this->get_progress() >= 1.0f;
+  return millis() - this->start_time_ >= this->length_;
 }
 
 float LightTransformer::get_progress() {
-  return clamp(0.0f, 1.0f, (millis() - this->start_time_) / float(this->length_));
+  return LightColorValues::raw_to_float(this->get_progress_raw());
+}
+
+uint16_t LightTransformer::get_progress_raw() {
+  uint32_t elapsed = millis() - this->start_time_;
+  uint32_t length = this->length_;
+  if (elapsed >= length)
+    return 0xFFFF;
+  // Reduce the time resolution for long transformers so that the product fits into 32 bits.
+  while (length > 0xFFFF) {
+    length >>= 1;
+    elapsed >>= 1;
+  }
+  return uint16_t((elapsed * 0xFFFF) / length);
 }
 
 LightColorValues LightTransformer::get_remote_values() {
@@ -45,9 +60,13 @@ LightColorValues LightTransformer::get_end_values() {
 }
 
 LightColorValues LightTransitionTransformer::get_values() {
-  float x = this->get_progress();
-  float v = x * x * x * (x * (x * 6.0f - 15.0f) + 10.0f);
-  return LightColorValues::lerp(this->get_start_values(), this->get_target_values(), v);
+  // smootherstep x^3 * (6x^2 - 15x + 10) in 16-bit fixed-point
+  const uint32_t x = this->get_progress_raw();
+  const uint32_t x2 = (x * x) >> 16;
+  const uint32_t x3 = (x2 * x) >> 16;
+  const uint32_t poly = 6 * x2 - 15 * x + 10 * 65536;
+  const uint32_t v = std::min(uint32_t((uint64_t(x3) * poly) >> 16), uint32_t(0xFFFF));
+  return LightColorValues::lerp_raw(this->get_start_values(), this->get_target_values(), uint16_t(v));
 }
 LightTransitionTransformer::LightTransitionTransformer(uint32_t start_time,
                                                        uint32_t length,
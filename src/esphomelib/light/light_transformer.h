@@ -41,6 +41,9 @@ class LightTransformer {
   /// Get the completion of this transformer, 0 to 1.
   float get_progress();
 
+  /// Get the completion of this transformer as a 16-bit fixed-point value, 0 to 65535.
+  uint16_t get_progress_raw();
+
   const LightColorValues &get_start_values() const;
 
   const LightColorValues &get_target_values() const;
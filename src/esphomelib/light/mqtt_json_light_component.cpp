@@ -40,8 +40,6 @@ MQTTJSONLightComponent::MQTTJSONLightComponent(LightState *state)
 }
 
 void MQTTJSONLightComponent::send_light_values() {
-  LightColorValues remote_values = this->state_->get_remote_values();
-  remote_values.save_to_preferences(this->state_->get_name());
   this->send_json_message(this->get_state_topic(), [&](JsonBuffer &buffer, JsonObject &root) {
     this->state_->dump_json(buffer, root);
   });
@@ -73,7 +73,7 @@ size_t LogComponent::get_tx_buffer_size() const {
 void LogComponent::set_tx_buffer_size(size_t tx_buffer_size) {
   this->tx_buffer_.reserve(tx_buffer_size);
 }
-void LogComponent::add_on_log_callback(std::function<void(int, const char *)> &&callback) {
+void LogComponent::add_on_log_callback(InlineFunction<void(int, const char *)> &&callback) {
   this->log_callback_.add(std::move(callback));
 }
 
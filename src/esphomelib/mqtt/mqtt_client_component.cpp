@@ -97,7 +97,7 @@ void MQTTClientComponent::subscribe(const std::string &topic, mqtt_callback_t ca
       .qos = qos,
       .callback = std::move(callback),
   };
-  this->subscriptions_.push_back(subscription);
+  this->subscriptions_.push_back(std::move(subscription));
 
   if (this->is_connected())
     this->mqtt_client_.subscribe(topic.c_str(), qos);
@@ -112,7 +112,7 @@ void MQTTClientComponent::subscribe_json(const std::string &topic, json_parse_t
         parse_json(payload, callback);
       },
   };
-  this->subscriptions_.push_back(subscription);
+  this->subscriptions_.push_back(std::move(subscription));
 
   if (this->is_connected())
     this->mqtt_client_.subscribe(topic.c_str(), qos);
@@ -125,13 +125,17 @@ bool MQTTClientComponent::is_connected() {
 void MQTTClientComponent::reconnect() {
   if (this->is_connected())
     return;
+  // WiFiComponent reconnects in the background, don't block the loop until it's done.
+  if (!global_wifi_component->is_connected())
+    return;
 
   ESP_LOGI(TAG, "Reconnecting to MQTT...");
   uint32_t start = millis();
   do {
     // Force disconnect first
     this->mqtt_client_.disconnect(true);
-    global_wifi_component->loop();
+    if (!global_wifi_component->is_connected())
+      return;
 
     ESP_LOGD(TAG, "    Attempting MQTT connection...");
     if (millis() - start > 30000) {
@@ -192,6 +196,11 @@ void MQTTClientComponent::publish(const std::string &topic, const std::string &p
   }
 
   this->reconnect();
+  if (!this->is_connected()) {
+    if (!logging_topic)
+      ESP_LOGV(TAG, "Not connected, dropping message.");
+    return;
+  }
   uint16_t ret = this->mqtt_client_.publish(topic.c_str(), qos, retain, payload.data(), payload.length());
   if (ret == 0 && !logging_topic)
     ESP_LOGW(TAG, "Publish failed!");
@@ -284,7 +293,7 @@ void MQTTClientComponent::publish_json(const std::string &topic, const json_buil
 void MQTTClientComponent::set_log_message_template(MQTTMessage &&message) {
   this->log_message_ = std::move(message);
 }
-void MQTTClientComponent::add_on_connect_callback(std::function<void()> &&callback) {
+void MQTTClientComponent::add_on_connect_callback(InlineFunction<void()> &&callback) {
   this->on_connect_.add(std::move(callback));
 }
 
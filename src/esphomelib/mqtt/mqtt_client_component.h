@@ -25,7 +25,7 @@ namespace mqtt {
  *
  * First parameter is the topic, the second one is the payload.
  */
-using mqtt_callback_t = std::function<void(const std::string &)>;
+using mqtt_callback_t = InlineFunction<void(const std::string &)>;
 
 /// internal struct for MQTT messages.
 struct MQTTMessage {
@@ -185,7 +185,7 @@ class MQTTClientComponent : public Component {
   bool is_connected();
 
   /// Add a callback that will be called every time the MQTT client reconnects.
-  void add_on_connect_callback(std::function<void()> &&callback);
+  void add_on_connect_callback(InlineFunction<void()> &&callback);
 
   /// Setup the MQTT client, registering a bunch of callbacks and attempting to connect.
   void setup() override;
@@ -250,7 +250,7 @@ class MQTTPublishAction : public Action<T> {
   void set_retain(std::function<bool(T)> retain);
   void set_retain(bool retain);
 
-  void play(T x) override;
+  bool play(T x) override;
 
  protected:
   TemplatableValue<std::string, T> topic_;
@@ -264,10 +264,10 @@ extern MQTTClientComponent *global_mqtt_client;
 // =============== TEMPLATE DEFINITIONS ===============
 
 template<typename T>
-void MQTTPublishAction<T>::play(T x) {
+bool MQTTPublishAction<T>::play(T x) {
   global_mqtt_client->publish(this->topic_.value(x), this->payload_.value(x),
                               this->qos_.value(x), this->retain_.value(x));
-  this->play_next(x);
+  return true;
 }
 template<typename T>
 MQTTPublishAction<T>::MQTTPublishAction() {
@@ -191,6 +191,8 @@ void OTAComponent::write_rtc_(uint8_t val) {
 #endif
 #ifdef ARDUINO_ARCH_ESP32
   global_preferences.put_uint8(PREF_TAG, PREF_SAFE_MODE_COUNTER_KEY, static_cast<uint8_t>(val));
+  // The boot counter has to survive a crash shortly after boot, don't wait for the commit delay.
+  global_preferences.commit();
 #endif
 }
 uint8_t OTAComponent::read_rtc_() {
@@ -37,12 +37,27 @@ static const uint16_t PCA9685_PWM_FULL = 4096;
 
 static const uint8_t PCA9685_ADDRESS = 0x40;
 
+// Each channel takes 4 bytes, plus the register byte at the start of the transmission.
+#ifdef I2C_BUFFER_LENGTH
+static const uint8_t PCA9685_MAX_CHANNELS_PER_WRITE = (I2C_BUFFER_LENGTH - 1) / 4;
+#else
+static const uint8_t PCA9685_MAX_CHANNELS_PER_WRITE = (BUFFER_LENGTH - 1) / 4;
+#endif
+/** Unchanged channels in between two changed ones are re-sent if there are at most this many of them.
+ *
+ * Rewriting a channel costs 4 bytes on the bus while starting a new transmission costs the address and
+ * register bytes, start/stop conditions and the software overhead of a separate endTransmission().
+ */
+static const uint8_t PCA9685_MAX_MERGE_GAP = 1;
+
 PCA9685OutputComponent::PCA9685OutputComponent(I2CComponent *parent, float frequency,
                                                uint8_t mode)
     : I2CDevice(parent, PCA9685_ADDRESS), frequency_(frequency),
-      mode_(mode), min_channel_(0xFF), max_channel_(0x00), update_(true) {
+      mode_(mode), min_channel_(0xFF), max_channel_(0x00), dirty_(0) {
   for (uint16_t &pwm_amount : this->pwm_amounts_)
     pwm_amount = 0;
+  for (uint16_t &phase_begin : this->phase_begins_)
+    phase_begin = 0;
 }
 
 void PCA9685OutputComponent::setup() {
@@ -77,14 +92,38 @@ void PCA9685OutputComponent::setup() {
 }
 
 void PCA9685OutputComponent::loop() {
-  if (this->min_channel_ == 0xFF || !this->update_)
+  if (this->dirty_ == 0)
     return;
 
-  uint8_t data[16*4];
+  uint8_t channel = this->min_channel_;
+  while (channel <= this->max_channel_) {
+    if ((this->dirty_ & (1 << channel)) == 0) {
+      channel++;
+      continue;
+    }
+
+    // Extend the span up to the last changed channel that's close enough, re-sending short gaps of unchanged ones.
+    uint8_t end = channel;
+    for (uint8_t next = channel + 1; next <= this->max_channel_; next++) {
+      if (next - channel >= PCA9685_MAX_CHANNELS_PER_WRITE)
+        break;
+      if (this->dirty_ & (1 << next))
+        end = next;
+      else if (next - end > PCA9685_MAX_MERGE_GAP)
+        break;
+    }
+
+    this->write_channels_(channel, end);
+    channel = end + 1;
+  }
+  this->dirty_ = 0;
+}
+
+bool PCA9685OutputComponent::write_channels_(uint8_t first, uint8_t last) {
+  uint8_t data[16 * 4];
   uint8_t len = 0;
-  const uint16_t num_channels = this->max_channel_ - this->min_channel_ + 1;
-  for (uint8_t channel = this->min_channel_; channel <= this->max_channel_; channel++) {
-    uint16_t phase_begin = uint16_t(channel - this->min_channel_) / num_channels * 4096 ;
+  for (uint8_t channel = first; channel <= last; channel++) {
+    uint16_t phase_begin = this->phase_begins_[channel];
     uint16_t phase_end;
     uint16_t amount = this->pwm_amounts_[channel];
     if (amount == 0) {
@@ -105,9 +144,16 @@ void PCA9685OutputComponent::loop() {
     data[len++] = phase_end & 0xFF;
     data[len++] = (phase_end >> 8) & 0xFF;
   }
-  this->write_bytes(PCA9685_REGISTER_LED0 + 4 * this->min_channel_, data, len);
+  return this->write_bytes(PCA9685_REGISTER_LED0 + 4 * first, data, len);
+}
 
-  this->update_ = false;
+void PCA9685OutputComponent::update_phases_() {
+  // Spread the rising edges of all channels evenly over the PWM period to balance the load on the supply.
+  const uint16_t num_channels = this->max_channel_ - this->min_channel_ + 1;
+  for (uint8_t channel = this->min_channel_; channel <= this->max_channel_; channel++) {
+    this->phase_begins_[channel] = uint16_t(channel - this->min_channel_) * 4096 / num_channels;
+    this->dirty_ |= 1 << channel;
+  }
 }
 
 float PCA9685OutputComponent::get_setup_priority() const {
@@ -116,7 +162,7 @@ float PCA9685OutputComponent::get_setup_priority() const {
 
 void PCA9685OutputComponent::set_channel_value(uint8_t channel, uint16_t value) {
   if (this->pwm_amounts_[channel] != value)
-    this->update_ = true;
+    this->dirty_ |= 1 << channel;
   this->pwm_amounts_[channel] = value;
 }
 
@@ -126,6 +172,7 @@ PCA9685OutputComponent::Channel *PCA9685OutputComponent::create_channel(uint8_t
   ESP_LOGV(TAG, "Getting channel %d...", channel);
   this->min_channel_ = std::min(this->min_channel_, channel);
   this->max_channel_ = std::max(this->max_channel_, channel);
+  this->update_phases_();
   auto *c = new Channel(this, channel);
   c->set_power_supply(power_supply);
   c->set_max_power(max_power);
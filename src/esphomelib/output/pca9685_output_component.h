@@ -57,7 +57,7 @@ class PCA9685OutputComponent : public Component, public I2CDevice {
   void setup() override;
   /// HARDWARE setup_priority
   float get_setup_priority() const override;
-  /// Send new values if they were updated.
+  /// Send the channels whose values were updated, in as few contiguous register writes as possible.
   void loop() override;
 
   class Channel : public FloatOutput {
@@ -73,6 +73,10 @@ class PCA9685OutputComponent : public Component, public I2CDevice {
 
  protected:
   void set_channel_value(uint8_t channel, uint16_t value);
+  /// Write the channels first to last (inclusive) with a single auto-increment write.
+  bool write_channels_(uint8_t first, uint8_t last);
+  /// Recalculate the phase offsets of all channels after the channel range changed.
+  void update_phases_();
 
   float frequency_;
   uint8_t mode_;
@@ -80,7 +84,10 @@ class PCA9685OutputComponent : public Component, public I2CDevice {
   uint8_t min_channel_;
   uint8_t max_channel_;
   uint16_t pwm_amounts_[16];
-  bool update_;
+  /// The rising edge of each channel within the PWM period, precomputed by update_phases_().
+  uint16_t phase_begins_[16];
+  /// Bit n is set if channel n has to be sent to the PCA9685.
+  uint16_t dirty_;
 };
 
 } // namespace output
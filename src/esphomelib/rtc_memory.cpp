@@ -0,0 +1,197 @@
+//
+//  rtc_memory.cpp
+//  esphomelib
+//
+//  Copyright © 2018 Otto Winter. All rights reserved.
+//
+
+#include "esphomelib/rtc_memory.h"
+
+#include <cstring>
+#include <algorithm>
+
+#include "esphomelib/crc.h"
+#include "esphomelib/esphal.h"
+#include "esphomelib/log.h"
+
+#ifdef ARDUINO_ARCH_ESP32
+#include <rom/rtc.h>
+#include <esp_attr.h>
+#endif
+#ifdef ARDUINO_ARCH_ESP8266
+#include <Esp.h>
+extern "C" {
+#include <user_interface.h>
+}
+#endif
+
+ESPHOMELIB_NAMESPACE_BEGIN
+
+static const char *TAG = "rtc_memory";
+
+static const uint32_t RTC_MEMORY_MAGIC = 0x31435452UL; // "RTC1"
+/// magic, number of data words, CRC-32 of the data words
+static const size_t RTC_MEMORY_HEADER_WORDS = 3;
+
+#ifdef ARDUINO_ARCH_ESP32
+RTC_DATA_ATTR static uint32_t rtc_memory_data[ESPHOMELIB_RTC_MEMORY_WORDS];
+#endif
+#ifdef ARDUINO_ARCH_ESP8266
+/// The first user RTC memory block is used by the OTA safe mode counter.
+static const uint32_t RTC_MEMORY_OFFSET = 1;
+#endif
+#ifndef ARDUINO
+/// Plain memory for the host tests, which never wake up from deep sleep.
+static uint32_t rtc_memory_data[ESPHOMELIB_RTC_MEMORY_WORDS];
+#endif
+
+static bool read_rtc_memory(size_t offset, uint32_t *data, size_t words) {
+#if defined(ARDUINO_ARCH_ESP32) || !defined(ARDUINO)
+  memcpy(data, rtc_memory_data + offset, words * 4);
+  return true;
+#endif
+#ifdef ARDUINO_ARCH_ESP8266
+  return ESP.rtcUserMemoryRead(RTC_MEMORY_OFFSET + offset, data, words * 4);
+#endif
+}
+static bool write_rtc_memory(size_t offset, uint32_t *data, size_t words) {
+#if defined(ARDUINO_ARCH_ESP32) || !defined(ARDUINO)
+  memcpy(rtc_memory_data + offset, data, words * 4);
+  return true;
+#endif
+#ifdef ARDUINO_ARCH_ESP8266
+  return ESP.rtcUserMemoryWrite(RTC_MEMORY_OFFSET + offset, data, words * 4);
+#endif
+}
+
+bool RTCMemory::is_deep_sleep_wakeup() {
+  if (!this->deep_sleep_wakeup_.has_value()) {
+#ifdef ARDUINO_ARCH_ESP32
+    this->deep_sleep_wakeup_ = rtc_get_reset_reason(0) == DEEPSLEEP_RESET;
+#endif
+#ifdef ARDUINO_ARCH_ESP8266
+    this->deep_sleep_wakeup_ = ESP.getResetInfoPtr()->reason == REASON_DEEP_SLEEP_AWAKE;
+#endif
+#ifndef ARDUINO
+    this->deep_sleep_wakeup_ = false;
+#endif
+  }
+  return *this->deep_sleep_wakeup_;
+}
+void RTCMemory::add_on_snapshot_callback(InlineFunction<void()> &&callback) {
+  this->snapshot_callbacks_.add(std::move(callback));
+}
+void RTCMemory::enable_snapshots() {
+  this->snapshots_enabled_ = true;
+}
+bool RTCMemory::are_snapshots_enabled() const {
+  return this->snapshots_enabled_;
+}
+bool RTCMemory::save(const std::string &friendly_name, const std::string &key, const void *data, size_t length) {
+  const uint32_t hash = make_key_(friendly_name, key);
+  int index = find_(this->saved_, hash);
+  if (index >= 0) {
+    const size_t words = 2 + (this->saved_[index + 1] + 3) / 4;
+    this->saved_.erase(this->saved_.begin() + index, this->saved_.begin() + index + words);
+  }
+
+  const size_t words = (length + 3) / 4;
+  if (RTC_MEMORY_HEADER_WORDS + this->saved_.size() + 2 + words > ESPHOMELIB_RTC_MEMORY_WORDS) {
+    ESP_LOGW(TAG, "Not enough RTC memory to save '%s/%s' (%u bytes)!", friendly_name.c_str(), key.c_str(),
+             unsigned(length));
+    return false;
+  }
+  this->saved_.push_back(hash);
+  this->saved_.push_back(length);
+  const size_t start = this->saved_.size();
+  this->saved_.resize(start + words, 0);
+  memcpy(this->saved_.data() + start, data, length);
+  return true;
+}
+size_t RTCMemory::restore(const std::string &friendly_name, const std::string &key, void *data, size_t max_length) {
+  this->load_();
+  int index = find_(this->restored_, make_key_(friendly_name, key));
+  if (index < 0)
+    return 0;
+  const size_t length = this->restored_[index + 1];
+  memcpy(data, this->restored_.data() + index + 2, std::min(length, max_length));
+  return length;
+}
+bool RTCMemory::get_clock(uint64_t *clock) {
+  // The clock at the wake-up is saved by the snapshot, it starts at 0 on any other boot.
+  uint64_t wakeup = 0;
+  if (this->is_deep_sleep_wakeup() && !this->restore("rtc_memory", "clock", &wakeup))
+    return false;
+  *clock = wakeup + millis();
+  return true;
+}
+void RTCMemory::set_sleep_duration(uint32_t sleep_duration) {
+  this->sleep_duration_ = sleep_duration;
+}
+void RTCMemory::snapshot() {
+  this->snapshot_callbacks_.call();
+
+  // Without a sleep duration, the time of the wake-up is unknown and so is the clock after it.
+  uint64_t clock;
+  if (this->sleep_duration_.has_value() && this->get_clock(&clock))
+    this->save("rtc_memory", "clock", clock + *this->sleep_duration_);
+
+  std::vector<uint32_t> data(RTC_MEMORY_HEADER_WORDS);
+  data[0] = RTC_MEMORY_MAGIC;
+  data[1] = this->saved_.size();
+  data[2] = crc32(reinterpret_cast<const uint8_t *>(this->saved_.data()), this->saved_.size() * 4);
+  data.insert(data.end(), this->saved_.begin(), this->saved_.end());
+  ESP_LOGD(TAG, "Writing %u bytes of state to RTC memory.", unsigned(data.size() * 4));
+  if (!write_rtc_memory(0, data.data(), data.size()))
+    ESP_LOGW(TAG, "Writing RTC memory failed!");
+}
+void RTCMemory::load_() {
+  if (this->loaded_)
+    return;
+  this->loaded_ = true;
+  if (!this->is_deep_sleep_wakeup())
+    return;
+
+  uint32_t header[RTC_MEMORY_HEADER_WORDS];
+  if (!read_rtc_memory(0, header, RTC_MEMORY_HEADER_WORDS) || header[0] != RTC_MEMORY_MAGIC ||
+      header[1] > ESPHOMELIB_RTC_MEMORY_WORDS - RTC_MEMORY_HEADER_WORDS) {
+    ESP_LOGD(TAG, "No state snapshot in RTC memory.");
+    return;
+  }
+  std::vector<uint32_t> data(header[1]);
+  if (!read_rtc_memory(RTC_MEMORY_HEADER_WORDS, data.data(), data.size()) ||
+      crc32(reinterpret_cast<const uint8_t *>(data.data()), data.size() * 4) != header[2]) {
+    ESP_LOGW(TAG, "State snapshot in RTC memory is corrupted, ignoring it.");
+    return;
+  }
+
+  // Make sure all entries are within bounds so that find_ doesn't have to check again.
+  size_t i = 0;
+  while (i + 2 <= data.size() && data[i + 1] <= (data.size() - i - 2) * 4)
+    i += 2 + (data[i + 1] + 3) / 4;
+  if (i != data.size()) {
+    ESP_LOGW(TAG, "State snapshot in RTC memory is malformed, ignoring it.");
+    return;
+  }
+  ESP_LOGD(TAG, "Restored %u bytes of state from RTC memory.", unsigned(data.size() * 4));
+  this->restored_ = std::move(data);
+}
+int RTCMemory::find_(const std::vector<uint32_t> &entries, uint32_t key) {
+  size_t i = 0;
+  while (i + 2 <= entries.size()) {
+    if (entries[i] == key)
+      return i;
+    i += 2 + (entries[i + 1] + 3) / 4;
+  }
+  return -1;
+}
+uint32_t RTCMemory::make_key_(const std::string &friendly_name, const std::string &key) {
+  std::string name = friendly_name;
+  name += '\0';
+  name += key;
+  return fnv1a_hash(name);
+}
+
+RTCMemory global_rtc_memory;
+
+ESPHOMELIB_NAMESPACE_END
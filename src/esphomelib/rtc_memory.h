@@ -0,0 +1,125 @@
+//
+//  rtc_memory.h
+//  esphomelib
+//
+//  Copyright © 2018 Otto Winter. All rights reserved.
+//
+
+#ifndef ESPHOMELIB_RTC_MEMORY_H
+#define ESPHOMELIB_RTC_MEMORY_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+#include "esphomelib/helpers.h"
+#include "esphomelib/defines.h"
+
+ESPHOMELIB_NAMESPACE_BEGIN
+
+#ifndef ESPHOMELIB_RTC_MEMORY_WORDS
+  #ifdef ARDUINO_ARCH_ESP32
+    #define ESPHOMELIB_RTC_MEMORY_WORDS 256
+  #else
+    // The ESP8266 only has 128 words of user RTC memory and the first one is used by OTA safe mode.
+    #define ESPHOMELIB_RTC_MEMORY_WORDS 120
+  #endif
+#endif
+
+/** Snapshot of component state in RTC memory that survives deep sleep.
+ *
+ * A cold boot from flash has to set everything up from scratch: light states are loaded from
+ * the preferences, sensor filters start with empty averaging windows and so on. Right before
+ * entering deep sleep, DeepSleepComponent calls snapshot(), which lets all components save() their
+ * state into RTC memory (protected by a CRC). After waking up, components can restore() that state
+ * cheaply. Snapshots are only restored if the node actually woke up from deep sleep, never after a
+ * power-on or reset.
+ *
+ * Values are addressed like preferences: by friendly name and key. Stored types must be trivially copyable.
+ */
+class RTCMemory {
+ public:
+  /// Return whether this boot was a wake-up from deep sleep.
+  bool is_deep_sleep_wakeup();
+
+  /// Add a callback that is called right before entering deep sleep, use it to save() state.
+  void add_on_snapshot_callback(InlineFunction<void()> &&callback);
+
+  /// Internal: Allow snapshots, called by DeepSleepComponent.
+  void enable_snapshots();
+
+  /** Return whether a snapshot can be taken at all, i.e. whether deep sleep is configured.
+   *
+   * Components should only add snapshot callbacks if this is true. Only valid once all components are
+   * constructed, so check it in setup() or later.
+   */
+  bool are_snapshots_enabled() const;
+
+  /// Save length bytes of data for the next wake-up, returns false if RTC memory is full.
+  bool save(const std::string &friendly_name, const std::string &key, const void *data, size_t length);
+
+  template<typename T>
+  bool save(const std::string &friendly_name, const std::string &key, const T &value);
+
+  /** Restore data saved before the last deep sleep.
+   *
+   * Copies at most max_length bytes into data.
+   *
+   * @return The length of the saved value in bytes, or 0 if no value exists.
+   */
+  size_t restore(const std::string &friendly_name, const std::string &key, void *data, size_t max_length);
+
+  template<typename T>
+  bool restore(const std::string &friendly_name, const std::string &key, T *value);
+
+  /** Get the time in ms since the last power-on or reset, including the time spent in deep sleep.
+   *
+   * Use it to measure time spans across deep sleep cycles, for example by saving it in a snapshot.
+   *
+   * @return false if the time is unknown, i.e. after a wake-up without timer (from a pin) or without snapshot.
+   */
+  bool get_clock(uint64_t *clock);
+  /// Internal: Set how long (in ms) the next deep sleep lasts, to keep get_clock() running. Called by DeepSleepComponent.
+  void set_sleep_duration(uint32_t sleep_duration);
+  /// Internal: Call all snapshot callbacks and write the saved values to RTC memory. Called by DeepSleepComponent.
+  void snapshot();
+
+ protected:
+  /// Load and validate the snapshot from RTC memory on first use.
+  void load_();
+
+  /// Find the entry with the given key in entries, returns the index of its first word or -1.
+  static int find_(const std::vector<uint32_t> &entries, uint32_t key);
+
+  static uint32_t make_key_(const std::string &friendly_name, const std::string &key);
+
+  bool loaded_{false};
+  bool snapshots_enabled_{false};
+  optional<bool> deep_sleep_wakeup_{};
+  optional<uint32_t> sleep_duration_{};
+  /// The entries restored from RTC memory: key word, length word, then the data padded to whole words.
+  std::vector<uint32_t> restored_;
+  /// The entries saved for the next wake-up, same format as restored_.
+  std::vector<uint32_t> saved_;
+  CallbackManager<void()> snapshot_callbacks_{};
+};
+
+extern RTCMemory global_rtc_memory;
+
+template<typename T>
+bool RTCMemory::save(const std::string &friendly_name, const std::string &key, const T &value) {
+  return this->save(friendly_name, key, &value, sizeof(T));
+}
+template<typename T>
+bool RTCMemory::restore(const std::string &friendly_name, const std::string &key, T *value) {
+  T tmp;
+  if (this->restore(friendly_name, key, &tmp, sizeof(T)) != sizeof(T))
+    return false;
+  *value = tmp;
+  return true;
+}
+
+ESPHOMELIB_NAMESPACE_END
+
+#endif //ESPHOMELIB_RTC_MEMORY_H
@@ -66,6 +66,7 @@ void ADS1115Component::setup() {
   config |= 0b0000000000000011;
 
   this->write_byte_16(ADS1115_REGISTER_CONFIG, config);
+  this->prev_config_ = config;
   for (auto *sensor : this->sensors_) {
     ESP_LOGCONFIG(TAG, "  Sensor %s", sensor->get_name().c_str());
     ESP_LOGCONFIG(TAG, "    Multiplexer: %u", sensor->get_multiplexer());
@@ -79,10 +80,8 @@ void ADS1115Component::setup() {
 float ADS1115Component::get_setup_priority() const {
   return setup_priority::HARDWARE_LATE;
 }
-void ADS1115Component::request_measurement_(ADS1115Sensor *sensor) {
-  uint16_t config;
-  if (!this->read_byte_16(ADS1115_REGISTER_CONFIG, &config))
-    return;
+void ADS1115Component::request_measurement_(ADS1115Sensor *sensor, uint8_t attempt) {
+  uint16_t config = this->prev_config_;
   // Multiplexer
   //        0bxBBBxxxxxxxxxxxx
   config &= 0b1000111111111111;
@@ -95,24 +94,31 @@ void ADS1115Component::request_measurement_(ADS1115Sensor *sensor) {
   // Start conversion
   config |= 0b1000000000000000;
 
-  if (!this->write_byte_16(ADS1115_REGISTER_CONFIG, config))
-    return;
-
-  // about 1.6 ms with 860 samples per second
-  delay(2);
-
-  uint32_t start = millis();
-  while (this->read_byte_16(ADS1115_REGISTER_CONFIG, &config) && (config >> 15) == 0) {
-    if (millis() - start > 100) {
-      ESP_LOGW(TAG, "Reading ADS1115 timed out");
-      return;
-    }
-    yield();
-  }
-
-  uint16_t raw_conversion;
-  if (!this->read_byte_16(ADS1115_REGISTER_CONVERSION, &raw_conversion))
-    return;
+  // The whole measurement is a single transaction so that measurements of multiple sensors
+  // on this ADS1115 can't interleave. The conversion takes up to 1.3ms with 860 samples per second (±10%),
+  // a wait only ends once millis() has advanced by its length, which may be just over 2ms after 3ms.
+  this->enqueue(I2CTransaction()
+      .write_byte_16(ADS1115_REGISTER_CONFIG, config).wait(3)
+      .write(ADS1115_REGISTER_CONFIG).read(2)
+      .write(ADS1115_REGISTER_CONVERSION).read(2)
+      .then([this, sensor, attempt](bool success, const std::vector<uint8_t> &data) {
+        if (!success)
+          return;
+        if ((data[0] & 0x80) == 0) {
+          // Measure again instead of dropping the value, starting a new conversion so that
+          // measurements of other sensors that were enqueued meanwhile don't mix with this one.
+          if (attempt < 2) {
+            ESP_LOGD(TAG, "'%s': Conversion not finished, retrying", sensor->get_name().c_str());
+            this->request_measurement_(sensor, attempt + 1);
+            return;
+          }
+          ESP_LOGW(TAG, "'%s': Conversion not finished", sensor->get_name().c_str());
+          return;
+        }
+        this->publish_measurement_(sensor, (uint16_t(data[2]) << 8) | data[3]);
+      }));
+}
+void ADS1115Component::publish_measurement_(ADS1115Sensor *sensor, uint16_t raw_conversion) {
   auto signed_conversion = static_cast<int16_t>(raw_conversion);
 
   float millivolts;
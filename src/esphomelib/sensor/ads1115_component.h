@@ -87,10 +87,14 @@ class ADS1115Component : public Component, public I2CDevice {
   float get_setup_priority() const override;
 
  protected:
-  /// Helper method to request a measurement from a sensor.
-  void request_measurement_(ADS1115Sensor *sensor);
+  /// Helper method to request a measurement from a sensor, attempt counts the retries of unfinished conversions.
+  void request_measurement_(ADS1115Sensor *sensor, uint8_t attempt = 0);
+  /// Convert the raw value to volts and publish it.
+  void publish_measurement_(ADS1115Sensor *sensor, uint16_t raw_conversion);
 
   std::vector<ADS1115Sensor *> sensors_;
+  /// The config register as written in setup(), measurements only change multiplexer and gain.
+  uint16_t prev_config_{0};
 };
 
 /// Internal holder class that is in instance of Sensor so that the hub can create individual sensors.
@@ -6,6 +6,9 @@
 
 #include "esphomelib/sensor/dallas_component.h"
 
+#include <algorithm>
+
+#include "esphomelib/crc.h"
 #include "esphomelib/helpers.h"
 #include "esphomelib/log.h"
 
@@ -36,34 +39,43 @@ uint16_t DallasTemperatureSensor::millis_to_wait_for_conversion_() const {
 }
 
 void DallasComponent::set_one_wire(ESPOneWire *one_wire) {
-  this->one_wire_ = one_wire;
+  if (this->one_wires_.empty())
+    this->one_wires_.push_back(one_wire);
+  else
+    this->one_wires_[0] = one_wire;
+}
+void DallasComponent::add_one_wire(ESPOneWire *one_wire) {
+  this->one_wires_.push_back(one_wire);
 }
 void DallasComponent::setup() {
   ESP_LOGCONFIG(TAG, "Setting up DallasComponent...");
   ESP_LOGCONFIG(TAG, "    Want device count: %u", this->sensors_.size());
-
-  yield();
-  disable_interrupts();
-  std::vector<uint64_t> raw_sensors = this->one_wire_->search_vec();
-  enable_interrupts();
+  ESP_LOGCONFIG(TAG, "    Bus count: %u", this->one_wires_.size());
 
   ESP_LOGD(TAG, "Found sensors:");
   std::vector<uint64_t> out;
-  for (auto &address : raw_sensors) {
-    std::string s = uint64_to_string(address);
-    auto *address8 = reinterpret_cast<uint8_t *>(&address);
-    if (crc8(address8, 7) != address8[7]) {
-      ESP_LOGW(TAG, "Dallas device 0x%s has invalid CRC.", s.c_str());
-      continue;
-    }
-    if (address8[0] != DALLAS_MODEL_DS18S20 && address8[0] != DALLAS_MODEL_DS1822 &&
-        address8[0] != DALLAS_MODEL_DS18B20 && address8[0] != DALLAS_MODEL_DS1825 &&
-        address8[0] != DALLAS_MODEL_DS28EA00) {
-      ESP_LOGW(TAG, "Unknown device type 0x%02X.", address8[0]);
-      continue;
+  std::vector<ESPOneWire *> out_wires;
+  for (auto *one_wire : this->one_wires_) {
+    yield();
+    std::vector<uint64_t> raw_sensors = one_wire->search_vec();
+
+    for (auto &address : raw_sensors) {
+      std::string s = uint64_to_string(address);
+      auto *address8 = reinterpret_cast<uint8_t *>(&address);
+      if (crc8_dallas(address8, 7) != address8[7]) {
+        ESP_LOGW(TAG, "Dallas device 0x%s has invalid CRC.", s.c_str());
+        continue;
+      }
+      if (address8[0] != DALLAS_MODEL_DS18S20 && address8[0] != DALLAS_MODEL_DS1822 &&
+          address8[0] != DALLAS_MODEL_DS18B20 && address8[0] != DALLAS_MODEL_DS1825 &&
+          address8[0] != DALLAS_MODEL_DS28EA00) {
+        ESP_LOGW(TAG, "Unknown device type 0x%02X.", address8[0]);
+        continue;
+      }
+      ESP_LOGD(TAG, "    0x%s", s.c_str());
+      out.push_back(address);
+      out_wires.push_back(one_wire);
     }
-    ESP_LOGD(TAG, "    0x%s", s.c_str());
-    out.push_back(address);
   }
   for (auto sensor : this->sensors_) {
     ESP_LOGCONFIG(TAG, "Device '%s':", sensor->get_name().c_str());
@@ -80,8 +92,21 @@ void DallasComponent::setup() {
     }
     ESP_LOGCONFIG(TAG, "    Resolution: %u", sensor->get_resolution());
 
+    auto it = std::find(out.begin(), out.end(), sensor->get_address());
+    if (it == out.end()) {
+      ESP_LOGE(TAG, "Couldn't find sensor by address - not connected. Proceeding without it.");
+      continue;
+    }
+    sensor->set_one_wire_(out_wires[it - out.begin()]);
     sensor->setup_sensor_();
   }
+
+  // Read sensors with short conversion times first.
+  std::stable_sort(this->sensors_.begin(), this->sensors_.end(),
+                   [](DallasTemperatureSensor *a, DallasTemperatureSensor *b) {
+    return a->millis_to_wait_for_conversion_() < b->millis_to_wait_for_conversion_();
+  });
+  this->read_index_ = this->sensors_.size();
 }
 
 DallasTemperatureSensor *DallasComponent::get_sensor_by_address(const std::string &name,
@@ -100,45 +125,55 @@ DallasTemperatureSensor *DallasComponent::get_sensor_by_index(const std::string
   return s;
 }
 void DallasComponent::update() {
-  disable_interrupts();
-  bool result;
-  if (!this->one_wire_->reset()) {
-    result = false;
-  } else {
+  if (this->read_index_ < this->sensors_.size())
+    ESP_LOGW(TAG, "Not all sensors were read before the next update, consider a longer update interval.");
+
+  bool result = false;
+  for (auto *one_wire : this->one_wires_) {
+    if (!one_wire->reset()) {
+      ESP_LOGE(TAG, "Requesting conversion failed");
+      continue;
+    }
     result = true;
-    this->one_wire_->skip();
-    this->one_wire_->write8(DALLAS_COMMAND_START_CONVERSION);
+    one_wire->skip();
+    one_wire->write8(DALLAS_COMMAND_START_CONVERSION);
   }
-  enable_interrupts();
 
-  if (!result) {
-    ESP_LOGE(TAG, "Requesting conversion failed");
-    return;
-  }
+  this->conversion_start_ = millis();
+  this->read_index_ = result ? 0 : this->sensors_.size();
+}
+void DallasComponent::loop() {
+  // Sensors are sorted by conversion time, so if this one isn't ready yet, none of the next ones are.
+  while (this->read_index_ < this->sensors_.size()) {
+    DallasTemperatureSensor *sensor = this->sensors_[this->read_index_];
+    if (sensor->get_one_wire_() == nullptr) {
+      this->read_index_++;
+      continue;
+    }
+    if (millis() - this->conversion_start_ < sensor->millis_to_wait_for_conversion_())
+      return;
+    this->read_index_++;
+
+    if (!sensor->read_scratch_pad_()) {
+      ESP_LOGW(TAG, "'%s': Reading scratch pad failed: reset", sensor->get_name().c_str());
+      return;
+    }
+    if (!sensor->check_scratch_pad_())
+      return;
 
-  for (auto *sensor : this->sensors_) {
-    this->set_timeout(sensor->get_address_name(), sensor->millis_to_wait_for_conversion_(), [sensor] {
-      disable_interrupts();
-      bool res = sensor->read_scratch_pad_();
-      enable_interrupts();
-
-      if (!res)
-        return;
-      if (!sensor->check_scratch_pad_())
-        return;
-
-      float tempc = sensor->get_temp_c();
-      ESP_LOGD(TAG, "'%s': Got Temperature=%.1f°C", sensor->get_name().c_str(), tempc);
-      sensor->push_new_value(tempc);
-    });
+    float tempc = sensor->get_temp_c();
+    ESP_LOGD(TAG, "'%s': Got Temperature=%.1f°C", sensor->get_name().c_str(), tempc);
+    sensor->push_new_value(tempc);
+    // Only read one sensor per loop iteration.
+    return;
   }
 }
 DallasComponent::DallasComponent(ESPOneWire *one_wire, uint32_t update_interval)
-    : PollingComponent(update_interval), one_wire_(one_wire) {
+    : PollingComponent(update_interval), one_wires_({one_wire}) {
 
 }
 ESPOneWire *DallasComponent::get_one_wire() const {
-  return this->one_wire_;
+  return this->one_wires_.empty() ? nullptr : this->one_wires_[0];
 }
 
 DallasTemperatureSensor::DallasTemperatureSensor(const std::string &name,
@@ -177,8 +212,14 @@ const std::string &DallasTemperatureSensor::get_address_name() {
 
   return this->address_name_;
 }
+ESPOneWire *DallasTemperatureSensor::get_one_wire_() const {
+  return this->one_wire_;
+}
+void DallasTemperatureSensor::set_one_wire_(ESPOneWire *one_wire) {
+  this->one_wire_ = one_wire;
+}
 bool DallasTemperatureSensor::read_scratch_pad_() {
-  ESPOneWire *wire = this->parent_->get_one_wire();
+  ESPOneWire *wire = this->one_wire_;
   if (!wire->reset()) {
     return false;
   }
@@ -192,11 +233,7 @@ bool DallasTemperatureSensor::read_scratch_pad_() {
   return true;
 }
 void DallasTemperatureSensor::setup_sensor_() {
-  disable_interrupts();
-  bool r = this->read_scratch_pad_();
-  enable_interrupts();
-
-  if (!r) {
+  if (!this->read_scratch_pad_()) {
     ESP_LOGE(TAG, "Reading scratchpad failed: reset");
     return;
   }
@@ -224,8 +261,7 @@ void DallasTemperatureSensor::setup_sensor_() {
       break;
   }
 
-  ESPOneWire *wire = this->parent_->get_one_wire();
-  disable_interrupts();
+  ESPOneWire *wire = this->one_wire_;
   if (wire->reset()) {
     wire->select(this->address_);
     wire->write8(DALLAS_COMMAND_WRITE_SCRATCH_PAD);
@@ -238,7 +274,6 @@ void DallasTemperatureSensor::setup_sensor_() {
     wire->select(this->address_);
     wire->write8(0x48);
   }
-  enable_interrupts();
 
   delay(20);  // allow it to finish operation
   wire->reset();
@@ -249,9 +284,9 @@ bool DallasTemperatureSensor::check_scratch_pad_() {
               this->scratch_pad_[0], this->scratch_pad_[1], this->scratch_pad_[2],
               this->scratch_pad_[3], this->scratch_pad_[4], this->scratch_pad_[5],
               this->scratch_pad_[6], this->scratch_pad_[7], this->scratch_pad_[8],
-              crc8(this->scratch_pad_, 8));
+              crc8_dallas(this->scratch_pad_, 8));
   }
-  if (crc8(this->scratch_pad_, 8) != this->scratch_pad_[8]) {
+  if (crc8_dallas(this->scratch_pad_, 8) != this->scratch_pad_[8]) {
     ESP_LOGE(TAG, "Reading scratch pad from Dallas Sensor failed");
     return false;
   }
@@ -17,9 +17,12 @@ namespace sensor {
 
 class DallasTemperatureSensor;
 
-/** Hub for dealing with dallas temperature sensor. Uses a OneWire interface.
+/** Hub for dealing with dallas temperature sensor. Uses one or more OneWire interfaces.
  *
  * Get the individual sensors with `get_sensor_by_address` or `get_sensor_by_index`.
+ *
+ * Each update starts the conversion on all buses at once, then the sensors are read in loop(),
+ * at most one per loop iteration, as soon as their conversion time has passed.
  */
 class DallasComponent : public PollingComponent {
  public:
@@ -46,10 +49,16 @@ class DallasComponent : public PollingComponent {
   DallasTemperatureSensor *get_sensor_by_index(const std::string &name, uint8_t index,
                                                uint8_t resolution = 12);
 
+  /** Add another OneWire bus to this hub.
+   *
+   * Conversions on all buses run in parallel. Sensors are assigned to the bus they're found on
+   * and indices count across all buses in the order they were added.
+   */
+  void add_one_wire(ESPOneWire *one_wire);
+
   // ========== INTERNAL METHODS ==========
   // (In most use cases you won't need these)
-  /// Get the ESPOneWire instance used for this hub.
-  /// Manually set the ESPOneWire instance used for this hub.
+  /// Manually set the (first) ESPOneWire instance used for this hub.
   void set_one_wire(ESPOneWire *one_wire);
 
   /// Set up individual sensors and update intervals.
@@ -57,13 +66,21 @@ class DallasComponent : public PollingComponent {
   /// HARDWARE_LATE setup priority.
   float get_setup_priority() const override;
 
+  /// Start the conversion on all buses.
   void update() override;
+  /// Read the next sensor whose conversion has finished.
+  void loop() override;
 
+  /// Get the (first) ESPOneWire instance used for this hub.
   ESPOneWire *get_one_wire() const;
 
  protected:
-  ESPOneWire *one_wire_;
+  std::vector<ESPOneWire *> one_wires_;
+  /// All sensors, sorted by conversion time after setup.
   std::vector<DallasTemperatureSensor *> sensors_;
+  uint32_t conversion_start_{0};
+  /// Index of the next sensor to read in sensors_, size of sensors_ if there's no pending read.
+  size_t read_index_{0};
 };
 
 /// Internal class that helps us create multiple sensors for one Dallas hub.
@@ -97,6 +114,10 @@ class DallasTemperatureSensor : public EmptyPollingParentSensor<1, ICON_EMPTY, U
   /// Get the number of milliseconds we have to wait for the conversion phase.
   uint16_t millis_to_wait_for_conversion_() const;
 
+  /// Get the bus this sensor was found on, nullptr if it wasn't found.
+  ESPOneWire *get_one_wire_() const;
+  void set_one_wire_(ESPOneWire *one_wire);
+
   void setup_sensor_();
   bool read_scratch_pad_();
 
@@ -110,6 +131,7 @@ class DallasTemperatureSensor : public EmptyPollingParentSensor<1, ICON_EMPTY, U
   uint8_t index_;
 
   uint8_t resolution_;
+  ESPOneWire *one_wire_{nullptr};
   std::string address_name_;
   uint8_t scratch_pad_[9] = {0,};
 };
@@ -36,19 +36,62 @@ void DHTComponent::setup() {
   this->pin_->setup();
   this->pin_->digital_write(true);
 
-  if (this->model_ == DHT_MODEL_AUTO_DETECT) {
-    this->model_ = DHT_MODEL_DHT22;
-    float temp1, temp2;
-    if (this->read_sensor_safe_(&temp1, &temp2) == DHT_ERROR_TIMEOUT)
-      this->model_ = DHT_MODEL_DHT11;
-  }
-
   ESP_LOGCONFIG(TAG, "    Model: %u", this->model_);
 }
 
 void DHTComponent::update() {
+  if (capturing_ != nullptr) {
+    // Another DHT sensor is being read right now, try again shortly.
+    this->set_timeout("update", 20, [this]() {
+      this->update();
+    });
+    return;
+  }
+  capturing_ = this;
+
+  this->pin_->digital_write(false);
+  this->pin_->pin_mode(OUTPUT);
+
+  if (this->model_ == DHT_MODEL_DHT11) {
+    this->set_timeout("capture", 18, [this]() {
+      this->start_capture_();
+    });
+  } else {
+    delayMicroseconds(800);
+    this->start_capture_();
+  }
+}
+void DHTComponent::start_capture_() {
+  this->num_edges_ = 0;
+  this->pin_->pin_mode(INPUT_PULLUP);
+  this->pin_->digital_write(true);
+  // Attach after changing the pin mode, on the ESP32 pinMode() resets the interrupt configuration.
+  attachInterrupt(digitalPinToInterrupt(this->pin_->get_pin()), DHTComponent::gpio_intr_, CHANGE);
+
+  // The whole answer takes about 5ms.
+  this->set_timeout("capture", 10, [this]() {
+    this->finish_capture_();
+  });
+}
+void DHTComponent::finish_capture_() {
+  detachInterrupt(digitalPinToInterrupt(this->pin_->get_pin()));
+  capturing_ = nullptr;
+
   float temperature, humidity;
-  uint8_t error = this->read_sensor_safe_(&temperature, &humidity);
+  uint8_t error = this->decode_(&temperature, &humidity);
+
+  if (this->model_ == DHT_MODEL_AUTO_DETECT) {
+    if (error == DHT_ERROR_TIMEOUT) {
+      // The DHT11 needs a much longer start pulse, so it doesn't answer at all to the DHT22 one.
+      this->model_ = DHT_MODEL_DHT11;
+      ESP_LOGCONFIG(TAG, "No answer from DHT22, assuming DHT11.");
+      this->set_timeout("update", 2000, [this]() {
+        this->update();
+      });
+      return;
+    }
+    this->model_ = DHT_MODEL_DHT22;
+  }
 
   if (!isnan(temperature) && !isnan(humidity)) {
     ESP_LOGD(TAG, "Got Temperature=%.1f°C Humidity=%.1f%%", temperature, humidity);
@@ -79,57 +122,31 @@ DHTTemperatureSensor *DHTComponent::get_temperature_sensor() const {
 DHTHumiditySensor *DHTComponent::get_humidity_sensor() const {
   return this->humidity_sensor_;
 }
-uint8_t DHTComponent::read_sensor_(float *temperature, float *humidity) {
+uint8_t DHTComponent::decode_(float *temperature, float *humidity) {
   *humidity = NAN;
   *temperature = NAN;
 
-  this->pin_->digital_write(false);
-  this->pin_->pin_mode(OUTPUT);
-
-  if (this->model_ == DHT_MODEL_DHT11)
-    delay(18);
-  else
-    delayMicroseconds(800);
-
-  this->pin_->pin_mode(INPUT_PULLUP);
-  this->pin_->digital_write(true);
-
-  uint16_t raw_humidity = 0;
-  uint16_t raw_temperature = 0;
-  uint16_t data = 0;
-
-  for (int8_t i = -3; i < 80; i++) {
-    uint8_t age;
-    uint32_t start_time = micros();
-
-    do {
-      age = micros() - start_time;
-      if (age > 90)
-        return DHT_ERROR_TIMEOUT;
-    } while (this->pin_->digital_read() == ((i & 1) == 1));
-
-    if (i >= 0 && (i & 1) == 1) {
-      data <<= 1;
-
-      if (age > 30)
-        data |= 1;
-    }
-
-    switch (i) {
-      case 31:
-        raw_humidity = data;
-        break;
-      case 63:
-        raw_temperature = data;
-        data = 0;
-        break;
-      default:break;
-    }
+  // Each bit is a ~50µs low pulse followed by a ~27µs (0) or ~70µs (1) high pulse. Walk backwards
+  // through the edges so that the response pulses (and a possibly missed first edge) don't matter.
+  uint8_t data[5] = {0};
+  int8_t bit = 39;
+  for (int i = int(this->num_edges_) - 2; i >= 0 && bit >= 0; i--) {
+    const uint32_t rise = this->edges_[i];
+    const uint32_t fall = this->edges_[i + 1];
+    if ((rise & 1) != 1 || (fall & 1) != 0)
+      continue;
+    const uint32_t width = (fall & ~1u) - (rise & ~1u);
+    if (width > 40)
+      data[bit / 8] |= 0x80 >> (bit % 8);
+    bit--;
   }
+  if (bit >= 0)
+    return DHT_ERROR_TIMEOUT;
 
-  uint8_t checksum = (raw_humidity & 0xFF) + (raw_humidity >> 8)
-      + (raw_temperature & 0xFF) + (raw_temperature >> 8);
-  if (checksum != data)
+  uint16_t raw_humidity = (uint16_t(data[0]) << 8) | data[1];
+  uint16_t raw_temperature = (uint16_t(data[2]) << 8) | data[3];
+  uint8_t checksum = data[0] + data[1] + data[2] + data[3];
+  if (checksum != data[4])
     return DHT_ERROR_CHECKSUM;
 
   if (this->model_ == DHT_MODEL_DHT11) {
@@ -151,13 +168,17 @@ uint8_t DHTComponent::read_sensor_(float *temperature, float *humidity) {
 
   return 0;
 }
-uint8_t DHTComponent::read_sensor_safe_(float *temperature, float *humidity) {
-  disable_interrupts();
-  uint8_t ret = this->read_sensor_(temperature, humidity);
-  enable_interrupts();
-  return ret;
+void ICACHE_RAM_ATTR DHTComponent::gpio_intr_() {
+  DHTComponent *dht = capturing_;
+  if (dht == nullptr || dht->num_edges_ >= DHT_MAX_EDGES)
+    return;
+  const uint32_t now = micros();
+  dht->edges_[dht->num_edges_] = (now & ~1u) | uint32_t(dht->pin_->digital_read());
+  dht->num_edges_ = dht->num_edges_ + 1;
 }
 
+DHTComponent *DHTComponent::capturing_ = nullptr;
+
 } // namespace sensor
 
 ESPHOMELIB_NAMESPACE_END
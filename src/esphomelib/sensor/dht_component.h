@@ -17,6 +17,9 @@ namespace sensor {
 using DHTTemperatureSensor = EmptyPollingParentSensor<1, ICON_EMPTY, UNIT_C>;
 using DHTHumiditySensor = EmptyPollingParentSensor<0, ICON_WATER_PERCENT, UNIT_PERCENT>;
 
+/// Maximum number of edges recorded per read, the sensor sends 84.
+static const uint8_t DHT_MAX_EDGES = 96;
+
 enum DHTModel {
   DHT_MODEL_AUTO_DETECT = 0,
   DHT_MODEL_DHT11,
@@ -25,7 +28,11 @@ enum DHTModel {
   DHT_MODEL_RHT03,
 };
 
-/// Component for reading temperature/humidity measurements from DHT11/DHT22 sensors.
+/** Component for reading temperature/humidity measurements from DHT11/DHT22 sensors.
+ *
+ * Reads don't block: after the start pulse, a GPIO interrupt records the timestamp of every edge
+ * the sensor sends and the pulse widths are decoded afterwards. Interrupts stay enabled all the time.
+ */
 class DHTComponent : public PollingComponent {
  public:
   /** Construct a DHTComponent.
@@ -55,18 +62,31 @@ class DHTComponent : public PollingComponent {
   DHTTemperatureSensor *get_temperature_sensor() const;
   DHTHumiditySensor *get_humidity_sensor() const;
 
-  /// Set up the pins and check connection.
+  /// Set up the pins.
   void setup() override;
-  /// Update sensor values and push them to the frontend.
+  /// Start a read, the values are pushed to the frontend once it's decoded.
   void update() override;
   /// HARDWARE_LATE setup priority.
   float get_setup_priority() const override;
 
  protected:
-  uint8_t read_sensor_(float *temperature, float *humidity);
-  uint8_t read_sensor_safe_(float *temperature, float *humidity);
+  /// Release the bus after the start pulse and capture the answer of the sensor.
+  void start_capture_();
+  /// Stop capturing and decode + publish the result.
+  void finish_capture_();
+  /// Decode the captured edges.
+  uint8_t decode_(float *temperature, float *humidity);
+
+  /// Record the time and new level of an edge on the pin of the capturing component.
+  static void gpio_intr_();
+
+  /// The component that is currently capturing, only one sensor can be read at a time.
+  static DHTComponent *capturing_;
 
   GPIOPin *pin_;
+  /// The edges of the current capture: micros() with the new pin level in the lowest bit.
+  volatile uint32_t edges_[DHT_MAX_EDGES];
+  volatile uint8_t num_edges_{0};
   DHTModel model_{DHT_MODEL_AUTO_DETECT};
   DHTTemperatureSensor *temperature_sensor_;
   DHTHumiditySensor *humidity_sensor_;
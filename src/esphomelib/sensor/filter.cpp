@@ -5,8 +5,11 @@
 #include "esphomelib/sensor/filter.h"
 #include "esphomelib/sensor/sensor.h"
 
+#include <cstring>
+
 #include "esphomelib/log.h"
 #include "esphomelib/espmath.h"
+#include "esphomelib/rtc_memory.h"
 
 #ifdef USE_SENSOR
 
@@ -43,6 +46,26 @@ optional<float> SlidingWindowMovingAverageFilter::new_value(float value) {
 uint32_t SlidingWindowMovingAverageFilter::expected_interval(uint32_t input) {
   return input * this->send_every_;
 }
+void SlidingWindowMovingAverageFilter::save_rtc_state(const std::string &friendly_name, const std::string &key) {
+  // send_at_ followed by the values in the window
+  std::vector<float> values = this->value_average_.get_values();
+  std::vector<uint32_t> data(1 + values.size());
+  data[0] = this->send_at_;
+  memcpy(data.data() + 1, values.data(), values.size() * sizeof(float));
+  global_rtc_memory.save(friendly_name, key, data.data(), data.size() * sizeof(uint32_t));
+}
+void SlidingWindowMovingAverageFilter::restore_rtc_state(const std::string &friendly_name, const std::string &key) {
+  std::vector<uint32_t> data(1 + this->value_average_.get_max_size());
+  const size_t length = global_rtc_memory.restore(friendly_name, key, data.data(), data.size() * sizeof(uint32_t));
+  if (length < sizeof(uint32_t) || length > data.size() * sizeof(uint32_t))
+    return;
+  this->send_at_ = data[0];
+  for (size_t i = 1; i < length / sizeof(uint32_t); i++) {
+    float value;
+    memcpy(&value, &data[i], sizeof(float));
+    this->value_average_.next_value(value);
+  }
+}
 
 ExponentialMovingAverageFilter::ExponentialMovingAverageFilter(float alpha, size_t send_every)
     : send_every_(send_every), send_at_(send_every - 1),
@@ -74,6 +97,26 @@ void ExponentialMovingAverageFilter::set_alpha(float alpha) {
 uint32_t ExponentialMovingAverageFilter::expected_interval(uint32_t input) {
   return input * this->send_every_;
 }
+void ExponentialMovingAverageFilter::save_rtc_state(const std::string &friendly_name, const std::string &key) {
+  if (!this->value_average_.has_value())
+    return;
+  struct {
+    float accumulator;
+    uint32_t send_at;
+  } state{this->value_average_.calculate_average(), uint32_t(this->send_at_)};
+  global_rtc_memory.save(friendly_name, key, state);
+}
+void ExponentialMovingAverageFilter::restore_rtc_state(const std::string &friendly_name, const std::string &key) {
+  struct {
+    float accumulator;
+    uint32_t send_at;
+  } state{};
+  if (!global_rtc_memory.restore(friendly_name, key, &state))
+    return;
+  // The first value of an exponential moving average initializes the accumulator.
+  this->value_average_.next_value(state.accumulator);
+  this->send_at_ = state.send_at;
+}
 LambdaFilter::LambdaFilter(lambda_filter_t lambda_filter)
     : lambda_filter_(std::move(lambda_filter)) {
 
@@ -120,13 +163,19 @@ optional<float> FilterOutNANFilter::new_value(float value) {
 
 uint32_t Filter::expected_interval(uint32_t input) {
   return input;
+}
+void Filter::save_rtc_state(const std::string &friendly_name, const std::string &key) {
+
+}
+void Filter::restore_rtc_state(const std::string &friendly_name, const std::string &key) {
+
 }
 void Filter::input(float value) {
   optional<float> out = this->new_value(value);
   if (out.has_value())
     this->output_(*out);
 }
-void Filter::initialize(std::function<void(float)> &&output) {
+void Filter::initialize(InlineFunction<void(float)> &&output) {
   this->output_ = std::move(output);
 }
 
@@ -162,6 +211,13 @@ optional<float> DeltaFilter::new_value(float value) {
   }
   return {};
 }
+void DeltaFilter::save_rtc_state(const std::string &friendly_name, const std::string &key) {
+  if (!isnan(this->last_value_))
+    global_rtc_memory.save(friendly_name, key, this->last_value_);
+}
+void DeltaFilter::restore_rtc_state(const std::string &friendly_name, const std::string &key) {
+  global_rtc_memory.restore(friendly_name, key, &this->last_value_);
+}
 OrFilter::OrFilter(std::list<Filter *> filters)
     : filters_(std::move(filters)) {
 
@@ -179,7 +235,7 @@ OrFilter::~OrFilter() {
   }
 }
 
-void OrFilter::initialize(std::function<void(float)> &&output) {
+void OrFilter::initialize(InlineFunction<void(float)> &&output) {
   Filter::initialize(std::move(output));
   for (Filter *filter : this->filters_) {
     filter->initialize([this](float value) {
@@ -204,6 +260,13 @@ optional<float> UniqueFilter::new_value(float value) {
 
   return {};
 }
+void UniqueFilter::save_rtc_state(const std::string &friendly_name, const std::string &key) {
+  if (!isnan(this->last_value_))
+    global_rtc_memory.save(friendly_name, key, this->last_value_);
+}
+void UniqueFilter::restore_rtc_state(const std::string &friendly_name, const std::string &key) {
+  global_rtc_memory.restore(friendly_name, key, &this->last_value_);
+}
 
 optional<float> DebounceFilter::new_value(float value) {
   this->set_timeout("debounce", this->time_period_, [this, value](){
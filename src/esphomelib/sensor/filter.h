@@ -41,18 +41,24 @@ class Filter {
 
   virtual ~Filter();
 
-  virtual void initialize(std::function<void(float)> &&output);
+  virtual void initialize(InlineFunction<void(float)> &&output);
 
   void input(float value);
 
   /// Return the amount of time that this filter is expected to take based on the input time interval.
   virtual uint32_t expected_interval(uint32_t input);
 
+  /// Save the internal state of this filter (like averaging windows) to RTC memory before deep sleep.
+  virtual void save_rtc_state(const std::string &friendly_name, const std::string &key);
+
+  /// Restore the state saved by save_rtc_state() after waking up from deep sleep.
+  virtual void restore_rtc_state(const std::string &friendly_name, const std::string &key);
+
  protected:
   friend Sensor;
   friend MQTTSensorComponent;
 
-  std::function<void(float)> output_;
+  InlineFunction<void(float)> output_;
   Filter *next_{nullptr};
 };
 
@@ -79,6 +85,9 @@ class SlidingWindowMovingAverageFilter : public Filter {
 
   uint32_t expected_interval(uint32_t input) override;
 
+  void save_rtc_state(const std::string &friendly_name, const std::string &key) override;
+  void restore_rtc_state(const std::string &friendly_name, const std::string &key) override;
+
  protected:
   SlidingWindowMovingAverage value_average_;
   size_t send_every_;
@@ -103,6 +112,9 @@ class ExponentialMovingAverageFilter : public Filter {
 
   uint32_t expected_interval(uint32_t input) override;
 
+  void save_rtc_state(const std::string &friendly_name, const std::string &key) override;
+  void restore_rtc_state(const std::string &friendly_name, const std::string &key) override;
+
  protected:
   ExponentialMovingAverage value_average_;
   ExponentialMovingAverage accuracy_average_;
@@ -212,6 +224,9 @@ class DeltaFilter : public Filter {
 
   optional<float> new_value(float value) override;
 
+  void save_rtc_state(const std::string &friendly_name, const std::string &key) override;
+  void restore_rtc_state(const std::string &friendly_name, const std::string &key) override;
+
  protected:
   float min_delta_;
   float last_value_{NAN};
@@ -222,7 +237,7 @@ class OrFilter : public Filter {
   explicit OrFilter(std::list<Filter *> filters);
 
   ~OrFilter() override;
-  void initialize(std::function<void(float)> &&output) override;
+  void initialize(InlineFunction<void(float)> &&output) override;
   uint32_t expected_interval(uint32_t input) override;
 
   optional<float> new_value(float value) override;
@@ -235,6 +250,9 @@ class UniqueFilter : public Filter {
  public:
   optional<float> new_value(float value) override;
 
+  void save_rtc_state(const std::string &friendly_name, const std::string &key) override;
+  void restore_rtc_state(const std::string &friendly_name, const std::string &key) override;
+
  protected:
   float last_value_{NAN};
 };
@@ -48,19 +48,25 @@ void HDC1080Component::setup() {
   }
 }
 void HDC1080Component::update() {
-  uint16_t raw_temp;
-  if (!this->read_byte_16(HDC1080_CMD_TEMPERATURE, &raw_temp, 9))
-    return;
-  float temp = raw_temp * 0.0025177f - 40.0f; // raw * 2^-16 * 165 - 40
-  this->temperature_->push_new_value(temp);
+  // Both conversions take about 9ms, queue them so that the loop doesn't block.
+  this->enqueue(I2CTransaction()
+      .write(HDC1080_CMD_TEMPERATURE).wait(9).read(2)
+      .write(HDC1080_CMD_HUMIDITY).wait(9).read(2)
+      .then([this](bool success, const std::vector<uint8_t> &data) {
+        if (!success) {
+          ESP_LOGW(TAG, "Reading HDC1080 failed!");
+          return;
+        }
+        uint16_t raw_temp = (uint16_t(data[0]) << 8) | data[1];
+        float temp = raw_temp * 0.0025177f - 40.0f; // raw * 2^-16 * 165 - 40
+        this->temperature_->push_new_value(temp);
 
-  uint16_t raw_humidity;
-  if (!this->read_byte_16(HDC1080_CMD_HUMIDITY, &raw_humidity, 9))
-    return;
-  float humidity = raw_humidity * 0.001525879f; // raw * 2^-16 * 100
-  this->humidity_->push_new_value(humidity);
+        uint16_t raw_humidity = (uint16_t(data[2]) << 8) | data[3];
+        float humidity = raw_humidity * 0.001525879f; // raw * 2^-16 * 100
+        this->humidity_->push_new_value(humidity);
 
-  ESP_LOGD(TAG, "Got temperature=%.1f°C humidity=%.1f%%", temp, humidity);
+        ESP_LOGD(TAG, "Got temperature=%.1f°C humidity=%.1f%%", temp, humidity);
+      }));
 }
 HDC1080TemperatureSensor *HDC1080Component::get_temperature_sensor() const {
   return this->temperature_;
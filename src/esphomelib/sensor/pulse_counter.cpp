@@ -10,6 +10,7 @@
 
 #include "esphomelib/log.h"
 #include "esphomelib/esphal.h"
+#include "esphomelib/rtc_memory.h"
 
 #ifdef USE_PULSE_COUNTER_SENSOR
 
@@ -19,6 +20,12 @@ namespace sensor {
 
 static const char *TAG = "sensor.pulse_counter";
 
+/// The pulses counted since the last update before deep sleep, and over how long they were counted.
+struct PulseCounterSnapshot {
+  int16_t pending;
+  uint32_t elapsed;
+};
+
 PulseCounterSensorComponent::PulseCounterSensorComponent(const std::string &name, uint8_t pin, uint32_t update_interval)
   : PollingSensorComponent(name, update_interval) {
   this->set_pin(pin);
@@ -94,6 +101,25 @@ void PulseCounterSensorComponent::setup() {
   pcnt_counter_pause(this->pcnt_unit_);
   pcnt_counter_clear(this->pcnt_unit_);
   pcnt_counter_resume(this->pcnt_unit_);
+
+  // Pulses counted between the last update and deep sleep are added to the first update after waking up,
+  // together with the time they were counted over so that they don't inflate the rate.
+  this->last_update_ = millis();
+  PulseCounterSnapshot snapshot{};
+  if (global_rtc_memory.restore(this->get_name(), "pending", &snapshot)) {
+    this->last_value_ = -snapshot.pending;
+    this->pending_elapsed_ = snapshot.elapsed;
+  }
+  if (global_rtc_memory.are_snapshots_enabled()) {
+    global_rtc_memory.add_on_snapshot_callback([this]() {
+      int16_t counter;
+      pcnt_get_counter_value(this->pcnt_unit_, &counter);
+      PulseCounterSnapshot snapshot{};
+      snapshot.pending = counter - this->last_value_;
+      snapshot.elapsed = millis() - this->last_update_ + this->pending_elapsed_;
+      global_rtc_memory.save(this->get_name(), "pending", snapshot);
+    });
+  }
 }
 float PulseCounterSensorComponent::get_setup_priority() const {
   return setup_priority::HARDWARE_LATE;
@@ -115,7 +141,13 @@ void PulseCounterSensorComponent::update() {
   pcnt_get_counter_value(this->pcnt_unit_, &counter);
   int16_t delta = counter - this->last_value_;
   this->last_value_ = counter;
-  float value = (60000.0f * delta) / float(this->get_update_interval()); // per minute
+  const uint32_t now = millis();
+  uint32_t elapsed = now - this->last_update_ + this->pending_elapsed_;
+  this->last_update_ = now;
+  this->pending_elapsed_ = 0;
+  if (elapsed == 0)
+    elapsed = this->get_update_interval();
+  float value = (60000.0f * delta) / float(elapsed); // per minute
 
   ESP_LOGD(TAG, "'%s': Retrieved counter (raw=%d): %0.2f pulses/min",
            this->get_name().c_str(), counter, value);
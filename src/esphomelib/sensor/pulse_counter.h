@@ -101,6 +101,10 @@ class PulseCounterSensorComponent : public PollingSensorComponent {
   pcnt_count_mode_t falling_edge_mode_{PCNT_COUNT_DIS};
   uint16_t filter_{1023};
   int16_t last_value_{0};
+  /// The time (millis()) of the last update.
+  uint32_t last_update_{0};
+  /// How long pulses were counted before deep sleep for the first update after waking up, in ms.
+  uint32_t pending_elapsed_{0};
 };
 
 extern pcnt_unit_t next_pcnt_unit;
@@ -6,6 +6,7 @@
 #include "esphomelib/sensor/sensor.h"
 
 #include "esphomelib/log.h"
+#include "esphomelib/rtc_memory.h"
 
 #ifdef USE_SENSOR
 
@@ -16,6 +17,9 @@ namespace sensor {
 static const char *TAG = "sensor.sensor";
 
 void Sensor::push_new_value(float value) {
+  if (!this->rtc_state_restored_)
+    this->restore_rtc_state_();
+
   this->raw_value = value;
   this->raw_callback_.call(value);
 
@@ -44,6 +48,27 @@ Sensor::Sensor(const std::string &name)
   // By default, apply a smoothing over the last 15 values
   this->add_sliding_window_average_filter(15, 15);
 }
+void Sensor::save_rtc_state_() {
+  if (!isnan(this->value))
+    global_rtc_memory.save(this->get_name(), "value", this->value);
+  uint32_t i = 0;
+  for (Filter *filter = this->filter_list_; filter != nullptr; filter = filter->next_)
+    filter->save_rtc_state(this->get_name(), "filter_" + uint32_to_string(i++));
+}
+void Sensor::restore_rtc_state_() {
+  this->rtc_state_restored_ = true;
+  if (global_rtc_memory.are_snapshots_enabled()) {
+    global_rtc_memory.add_on_snapshot_callback([this]() {
+      this->save_rtc_state_();
+    });
+  }
+  if (!global_rtc_memory.is_deep_sleep_wakeup())
+    return;
+  global_rtc_memory.restore(this->get_name(), "value", &this->value);
+  uint32_t i = 0;
+  for (Filter *filter = this->filter_list_; filter != nullptr; filter = filter->next_)
+    filter->restore_rtc_state(this->get_name(), "filter_" + uint32_to_string(i++));
+}
 
 void Sensor::set_unit_of_measurement(const std::string &unit_of_measurement) {
   this->unit_of_measurement_ = unit_of_measurement;
@@ -20,7 +20,7 @@ ESPHOMELIB_NAMESPACE_BEGIN
 
 namespace sensor {
 
-using sensor_callback_t = std::function<void(float)>;
+using sensor_callback_t = InlineFunction<void(float)>;
 
 class MQTTSensorComponent;
 class SensorValueTrigger;
@@ -192,12 +192,22 @@ class Sensor : public Nameable {
 
   void send_value_to_frontend(float value);
 
+  /// Save the last value and the state of all filters to RTC memory before deep sleep.
+  void save_rtc_state_();
+
+  /** Restore the state saved by save_rtc_state_() and register the snapshot callback if deep sleep is used.
+   *
+   * Done lazily on the first value so that all filters and the DeepSleepComponent are set up.
+   */
+  void restore_rtc_state_();
+
   CallbackManager<void(float)> raw_callback_; ///< Storage for raw value callbacks.
   CallbackManager<void(float)> callback_; ///< Storage for filtered value callbacks.
   optional<std::string> unit_of_measurement_; ///< Override the unit of measurement
   optional<std::string> icon_; /// Override the icon advertised to Home Assistant, otherwise sensor's icon will be used.
   optional<int8_t> accuracy_decimals_; ///< Override the accuracy in decimals, otherwise the sensor's values will be used.
   Filter *filter_list_{nullptr}; ///< Store all active filters.
+  bool rtc_state_restored_{false};
 };
 
 class PollingSensorComponent : public PollingComponent, public Sensor {
@@ -0,0 +1,62 @@
+//
+//  spsc_queue.h
+//  esphomelib
+//
+//  Copyright © 2018 Otto Winter. All rights reserved.
+//
+
+#ifndef ESPHOMELIB_SPSC_QUEUE_H
+#define ESPHOMELIB_SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "esphomelib/defines.h"
+
+ESPHOMELIB_NAMESPACE_BEGIN
+
+/** Lock-free queue for exactly one producer and one consumer task.
+ *
+ * push() must only be called from the producer and pop() only from the consumer. SIZE must be a power
+ * of two so that the ever-increasing indices stay consistent when they wrap around.
+ */
+template<typename T, uint32_t SIZE>
+class SPSCQueue {
+ public:
+  /// Add a copy of value to the queue, returns false if the queue is full.
+  bool push(const T &value);
+  /// Move the oldest value of the queue into value, returns false if the queue is empty.
+  bool pop(T *value);
+
+ protected:
+  static_assert((SIZE & (SIZE - 1)) == 0, "SPSCQueue size must be a power of two");
+
+  T buffer_[SIZE];
+  /// Number of values pushed so far, only written by the producer.
+  std::atomic<uint32_t> head_{0};
+  /// Number of values popped so far, only written by the consumer.
+  std::atomic<uint32_t> tail_{0};
+};
+
+template<typename T, uint32_t SIZE>
+bool SPSCQueue<T, SIZE>::push(const T &value) {
+  const uint32_t head = this->head_.load(std::memory_order_relaxed);
+  if (head - this->tail_.load(std::memory_order_acquire) == SIZE)
+    return false;
+  this->buffer_[head % SIZE] = value;
+  this->head_.store(head + 1, std::memory_order_release);
+  return true;
+}
+template<typename T, uint32_t SIZE>
+bool SPSCQueue<T, SIZE>::pop(T *value) {
+  const uint32_t tail = this->tail_.load(std::memory_order_relaxed);
+  if (this->head_.load(std::memory_order_acquire) == tail)
+    return false;
+  *value = this->buffer_[tail % SIZE];
+  this->tail_.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+ESPHOMELIB_NAMESPACE_END
+
+#endif //ESPHOMELIB_SPSC_QUEUE_H
@@ -8,6 +8,7 @@
 #include "esphomelib/switch_/ir_transmitter_component.h"
 
 #include <cstdlib>
+#include <algorithm>
 
 #include "esphomelib/log.h"
 #include "esphomelib/espmath.h"
@@ -81,7 +82,7 @@ SendData SendData::from_nec(uint16_t address, uint16_t command) {
 SendData SendData::from_lg(uint32_t data, uint8_t nbits) {
   SendData send_data{};
   send_data.carrier_frequency = lg::CARRIER_FREQUENCY_HZ;
-  send_data.data.reserve(static_cast<unsigned int>(2 + nbits * 2));
+  send_data.data.reserve(static_cast<unsigned int>(4 + nbits * 2));
 
   send_data.add_item(lg::HEADER_HIGH_US, lg::HEADER_LOW_US);
 
@@ -91,6 +92,9 @@ SendData SendData::from_lg(uint32_t data, uint8_t nbits) {
     else
       send_data.add_item(lg::BIT_HIGH_US, lg::BIT_ZERO_LOW_US);
   }
+
+  // The stop mark ends the space of the last bit, which would otherwise merge into the idle time.
+  send_data.add_item(lg::BIT_HIGH_US, 0);
   return send_data;
 }
 SendData SendData::from_sony(uint32_t data, uint8_t nbits) {
@@ -152,27 +156,41 @@ uint32_t SendData::total_length_ms() const {
 }
 
 #ifdef ARDUINO_ARCH_ESP32
-std::vector<rmt_item32_t> SendData::get_rmt_data(uint16_t ticks_for_10_us) {
-  std::vector<rmt_item32_t> rmt_data((this->data.size() + 1) / 2, rmt_item32_t {});
-
-  for (uint32_t i = 0; i < this->data.size(); i++) {
-    int16_t x = this->data[i];
-    bool level = x >= 0;
-    auto duration = uint16_t(fabsf(x) / 10 * ticks_for_10_us);
-
-    rmt_item32_t *item = &rmt_data[i / 2];
-    if (i % 2 == 0) {
-      item->level0 = static_cast<uint32_t>(level);
-      item->duration0 = duration;
-    } else {
-      item->level1 = static_cast<uint32_t>(level);
-      item->duration1 = duration;
+/// The RMT item durations are 15 bits wide.
+static const uint32_t RMT_MAX_DURATION_TICKS = 32767;
+
+/// Encode len timings as RMT items, get(i) returns timing i.
+template<typename F>
+static std::vector<rmt_item32_t> encode_rmt_items(uint16_t len, F get, uint16_t ticks_for_10_us) {
+  std::vector<rmt_item32_t> rmt_data;
+  rmt_data.reserve((len + 1) / 2);
+
+  uint32_t n = 0;
+  for (uint16_t i = 0; i < len; i++) {
+    const int16_t x = get(i);
+    const auto level = static_cast<uint32_t>(x >= 0);
+    uint32_t ticks = uint32_t(std::abs(int32_t(x))) * ticks_for_10_us / 10;
+    while (ticks > 0) {
+      const uint32_t duration = std::min(ticks, RMT_MAX_DURATION_TICKS);
+      if (n % 2 == 0) {
+        rmt_data.push_back(rmt_item32_t {});
+        rmt_data.back().level0 = level;
+        rmt_data.back().duration0 = duration;
+      } else {
+        rmt_data.back().level1 = level;
+        rmt_data.back().duration1 = duration;
+      }
+      ticks -= duration;
+      n++;
     }
   }
-  ESP_LOGV(TAG, "RMT Data Length: %u ms", this->total_length_ms());
-
   return rmt_data;
 }
+
+std::vector<rmt_item32_t> SendData::get_rmt_data(uint16_t ticks_for_10_us) const {
+  ESP_LOGV(TAG, "RMT Data Length: %u ms", this->total_length_ms());
+  return encode_rmt_items(this->data.size(), [this](uint16_t i) { return this->data[i]; }, ticks_for_10_us);
+}
 #endif
 
 
@@ -182,6 +200,13 @@ std::vector<rmt_item32_t> SendData::get_rmt_data(uint16_t ticks_for_10_us) {
 void IRTransmitterComponent::setup() {
   this->configure_rmt();
   rmt_driver_install(this->channel_, 0, 0);
+
+  // The clock divider is final now, encode all codes once instead of on every send.
+  const uint16_t ticks_for_10_us = this->get_ticks_for_10_us();
+  for (auto *transmitter : this->transmitters_) {
+    if (!transmitter->compact_code_.has_value())
+      transmitter->rmt_data_ = transmitter->send_data_.get_rmt_data(ticks_for_10_us);
+  }
 }
 void IRTransmitterComponent::configure_rmt() {
   rmt_config_t c{};
@@ -223,14 +248,25 @@ uint16_t IRTransmitterComponent::get_ticks_for_10_us() {
   return static_cast<uint16_t>(BASE_CLOCK_HZ / this->clock_divider_ / 100000);
 }
 void IRTransmitterComponent::send(ir::SendData &send_data) {
+  this->send_rmt_(send_data.get_rmt_data(this->get_ticks_for_10_us()), send_data);
+}
+void IRTransmitterComponent::send(const ir::CompactCode &code, uint16_t repeat_times, uint16_t repeat_wait_us) {
+  // Compact codes are only expanded for the duration of the send so that they don't occupy the heap.
+  SendData send_data{};
+  send_data.carrier_frequency = code.carrier_frequency;
+  send_data.repeat_times = repeat_times;
+  send_data.repeat_wait = repeat_wait_us;
+  auto get = [&code](uint16_t i) { return code.get(i); };
+  this->send_rmt_(encode_rmt_items(code.length, get, this->get_ticks_for_10_us()), send_data);
+}
+void IRTransmitterComponent::send_rmt_(const std::vector<rmt_item32_t> &rmt_data, const ir::SendData &send_data) {
   this->require_carrier_frequency(send_data.carrier_frequency);
 
-  std::vector<rmt_item32_t> v = send_data.get_rmt_data(this->get_ticks_for_10_us());
   for (uint16_t i = 0; i < send_data.repeat_times - 1; i++) {
-    rmt_write_items(this->channel_, v.data(), v.size(), true);
+    rmt_write_items(this->channel_, rmt_data.data(), rmt_data.size(), true);
     delayMicroseconds(send_data.repeat_wait);
   }
-  rmt_write_items(this->channel_, v.data(), v.size(), true);
+  rmt_write_items(this->channel_, rmt_data.data(), rmt_data.size(), true);
 }
 void IRTransmitterComponent::require_carrier_frequency(uint32_t carrier_frequency) {
   if (this->last_carrier_frequency_ == carrier_frequency)
@@ -246,8 +282,6 @@ void IRTransmitterComponent::set_channel(rmt_channel_t channel) {
 void IRTransmitterComponent::set_clock_divider(uint8_t clock_divider) {
   this->clock_divider_ = clock_divider;
 }
-
-rmt_channel_t next_rmt_channel = RMT_CHANNEL_0;
 #endif
 
 #ifdef ARDUINO_ARCH_ESP8266
@@ -288,14 +322,17 @@ void IRTransmitterComponent::delay_microseconds_accurate_(uint32_t usec) {
     delayMicroseconds(usec % 1000UL);
   }
 }
-void IRTransmitterComponent::send(ir::SendData &send_data) {
+template<typename F>
+void IRTransmitterComponent::send_timings_(uint32_t carrier_frequency, uint16_t len, F get, uint16_t repeat_times,
+                                           uint16_t repeat_wait) {
   // maintain timing across marks/spaces
-  for (uint16_t i = 0; i < send_data.repeat_times; i++) {
+  for (uint16_t i = 0; i < repeat_times; i++) {
     uint32_t on_time, off_time;
-    this->calculate_on_off_time_(send_data.carrier_frequency, &on_time, &off_time);
+    this->calculate_on_off_time_(carrier_frequency, &on_time, &off_time);
 
     enable_interrupts();
-    for (int16_t item : send_data.data) {
+    for (uint16_t j = 0; j < len; j++) {
+      const int16_t item = get(j);
       if (item > 0) {
         const auto length = static_cast<uint16_t>(item);
         this->mark_(on_time, off_time, length);
@@ -307,14 +344,23 @@ void IRTransmitterComponent::send(ir::SendData &send_data) {
     }
     disable_interrupts();
 
-    if (i + 1 < send_data.repeat_times) {
-      uint32_t wait_ms = send_data.repeat_wait / 1000UL;
+    if (i + 1 < repeat_times) {
+      uint32_t wait_ms = repeat_wait / 1000UL;
       if (wait_ms > 0)
         delay(wait_ms);
-      delayMicroseconds(send_data.repeat_wait % 1000UL);
+      delayMicroseconds(repeat_wait % 1000UL);
     }
   }
 }
+void IRTransmitterComponent::send(ir::SendData &send_data) {
+  auto get = [&send_data](uint16_t i) { return send_data.data[i]; };
+  this->send_timings_(send_data.carrier_frequency, send_data.data.size(), get, send_data.repeat_times,
+                      send_data.repeat_wait);
+}
+void IRTransmitterComponent::send(const ir::CompactCode &code, uint16_t repeat_times, uint16_t repeat_wait_us) {
+  auto get = [&code](uint16_t i) { return code.get(i); };
+  this->send_timings_(code.carrier_frequency, code.length, get, repeat_times, repeat_wait_us);
+}
 void IRTransmitterComponent::mark_(uint32_t on_time, uint32_t off_time, uint32_t usec) {
   if (this->carrier_duty_percent_ == 100) {
     this->pin_->digital_write(true);
@@ -354,16 +400,45 @@ void IRTransmitterComponent::set_carrier_duty_percent(uint8_t carrier_duty_perce
 }
 IRTransmitterComponent::DataTransmitter *IRTransmitterComponent::create_transmitter(const std::string &name,
                                                                                     const ir::SendData &send_data) {
-  return new DataTransmitter(name, send_data, this);
+  auto *transmitter = new DataTransmitter(name, send_data, this);
+#ifdef ARDUINO_ARCH_ESP32
+  this->transmitters_.push_back(transmitter);
+  if (this->get_component_state() != Component::CONSTRUCTION)
+    transmitter->rmt_data_ = send_data.get_rmt_data(this->get_ticks_for_10_us());
+#endif
+  return transmitter;
+}
+IRTransmitterComponent::DataTransmitter *IRTransmitterComponent::create_transmitter(const std::string &name,
+                                                                                    const ir::CompactCode &code,
+                                                                                    uint16_t repeat_times,
+                                                                                    uint16_t repeat_wait_us) {
+  SendData send_data{};
+  send_data.carrier_frequency = code.carrier_frequency;
+  send_data.repeat_times = repeat_times;
+  send_data.repeat_wait = repeat_wait_us;
+  return new DataTransmitter(name, code, send_data, this);
 }
 
 IRTransmitterComponent::DataTransmitter::DataTransmitter(const std::string &name,
                                                          const ir::SendData &send_data,
                                                          IRTransmitterComponent *parent)
     : Switch(name), send_data_(send_data), parent_(parent) {}
+IRTransmitterComponent::DataTransmitter::DataTransmitter(const std::string &name,
+                                                         const ir::CompactCode &code,
+                                                         const ir::SendData &send_data,
+                                                         IRTransmitterComponent *parent)
+    : Switch(name), compact_code_(code), send_data_(send_data), parent_(parent) {}
 
 void IRTransmitterComponent::DataTransmitter::turn_on() {
-  this->parent_->send(this->send_data_);
+  if (this->compact_code_.has_value()) {
+    this->parent_->send(*this->compact_code_, this->send_data_.repeat_times, this->send_data_.repeat_wait);
+  } else {
+#ifdef ARDUINO_ARCH_ESP32
+    this->parent_->send_rmt_(this->rmt_data_, this->send_data_);
+#else
+    this->parent_->send(this->send_data_);
+#endif
+  }
   this->publish_state(false);
 }
 void IRTransmitterComponent::DataTransmitter::turn_off() {
@@ -8,6 +8,7 @@
 #include "esphomelib/component.h"
 #include "esphomelib/switch_/switch.h"
 #include "esphomelib/esphal.h"
+#include "esphomelib/ir_protocol.h"
 #include "esphomelib/defines.h"
 
 #ifdef USE_IR_TRANSMITTER
@@ -23,49 +24,8 @@ namespace switch_ {
 /// Namespace storing constants for vendor IR formats
 namespace ir {
 
-namespace nec {
-
-const uint32_t CARRIER_FREQUENCY_HZ = 38000;
-const uint32_t HEADER_HIGH_US = 9000;
-const uint32_t HEADER_LOW_US = 4500;
-const uint32_t BIT_HIGH_US = 560;
-const uint32_t BIT_ONE_LOW_US = 1690;
-const uint32_t BIT_ZERO_LOW_US = 560;
-
-} // namespace nec
-
-namespace lg {
-
-const uint32_t CARRIER_FREQUENCY_HZ = 38000;
-const uint32_t HEADER_HIGH_US = 8000;
-const uint32_t HEADER_LOW_US = 4000;
-const uint32_t BIT_HIGH_US = 600;
-const uint32_t BIT_ONE_LOW_US = 1600;
-const uint32_t BIT_ZERO_LOW_US = 550;
-
-} // namespace lg
-
-namespace sony {
-
-const uint32_t CARRIER_FREQUENCY_HZ = 40000;
-const uint32_t HEADER_HIGH_US = 2400;
-const uint32_t HEADER_LOW_US = 600;
-const uint32_t BIT_ONE_HIGH_US = 1200;
-const uint32_t BIT_ZERO_HIGH_US = 600;
-const uint32_t BIT_LOW_US = 600;
-
-} // namespace sony
-
-namespace panasonic {
-
-const uint32_t CARRIER_FREQUENCY_HZ = 35000;
-const uint32_t HEADER_HIGH_US = 3502;
-const uint32_t HEADER_LOW_US = 1750;
-const uint32_t BIT_HIGH_US = 502;
-const uint32_t BIT_ZERO_LOW_US = 400;
-const uint32_t BIT_ONE_LOW_US = 1244;
-
-} // namespace panasonic
+// The protocol timings are shared with the IR receiver.
+using namespace esphomelib::ir;
 
 /** Struct that stores the raw data for sending out IR codes.
  *
@@ -79,8 +39,11 @@ struct SendData {
   uint16_t repeat_wait; ///< How long to wait between repeats.
 
 #ifdef ARDUINO_ARCH_ESP32
-  /// Return the internal data as an RMT interface-compatible vector.
-  std::vector<rmt_item32_t> get_rmt_data(uint16_t ticks_for_10_us);
+  /** Return the internal data as an RMT interface-compatible vector.
+   *
+   * Durations that don't fit into the 15 bits of an RMT item are split across multiple items.
+   */
+  std::vector<rmt_item32_t> get_rmt_data(uint16_t ticks_for_10_us) const;
 #endif
 
   /// Push back a high value for the specified duration to the data.
@@ -141,6 +104,16 @@ class IRTransmitterComponent : public Component {
    */
   DataTransmitter *create_transmitter(const std::string &name, const ir::SendData &send_data);
 
+  /** Create a DataTransmitter from a compact code, its arrays stay in flash and are read while sending.
+   *
+   * @param code The CompactCode, see ir::CompactCode.
+   * @param repeat_times How often to send the code.
+   * @param repeat_wait_us How long to wait between repeats.
+   * @return A DataTransmitter which can be used as a Switch.
+   */
+  DataTransmitter *create_transmitter(const std::string &name, const ir::CompactCode &code,
+                                      uint16_t repeat_times = 1, uint16_t repeat_wait_us = 30000);
+
   /// Set the carrier duty percentage (from 0-100).
   void set_carrier_duty_percent(uint8_t carrier_duty_percent);
 
@@ -151,12 +124,22 @@ class IRTransmitterComponent : public Component {
    public:
     DataTransmitter(const std::string &name, const ir::SendData &send_data,
                     IRTransmitterComponent *parent);
+    /// Create a transmitter for a compact code, send_data only provides the carrier frequency and repeats.
+    DataTransmitter(const std::string &name, const ir::CompactCode &code, const ir::SendData &send_data,
+                    IRTransmitterComponent *parent);
 
     void turn_on() override;
     void turn_off() override;
 
     std::string icon() override;
    protected:
+    friend class IRTransmitterComponent;
+
+#ifdef ARDUINO_ARCH_ESP32
+    /// The send data encoded as RMT items, precomputed once by the parent so that sending doesn't allocate.
+    std::vector<rmt_item32_t> rmt_data_;
+#endif
+    optional<ir::CompactCode> compact_code_{};
     ir::SendData send_data_;
     IRTransmitterComponent *parent_;
   };
@@ -168,6 +151,8 @@ class IRTransmitterComponent : public Component {
 
   /// Send an IR SendData object on this pin.
   void send(ir::SendData &send_data);
+  /// Send a compact code on this pin, reading it from flash while sending.
+  void send(const ir::CompactCode &code, uint16_t repeat_times = 1, uint16_t repeat_wait_us = 30000);
 
 #ifdef ARDUINO_ARCH_ESP32
   /// Set the clock divier for RMT.
@@ -182,6 +167,9 @@ class IRTransmitterComponent : public Component {
   /// Setup the RMT peripheral for the specified carrier frequency, if it's already the used frequency, does nothing.
   void require_carrier_frequency(uint32_t carrier_frequency);
 
+  /// Send already encoded RMT items.
+  void send_rmt_(const std::vector<rmt_item32_t> &rmt_data, const ir::SendData &send_data);
+
   /// Get the number of ticks (from the clock divider) for 10 µs.
   uint16_t get_ticks_for_10_us();
 
@@ -194,6 +182,10 @@ class IRTransmitterComponent : public Component {
 #endif
 
 #ifdef ARDUINO_ARCH_ESP8266
+  /// Send len timings, get(i) returns timing i.
+  template<typename F>
+  void send_timings_(uint32_t carrier_frequency, uint16_t len, F get, uint16_t repeat_times, uint16_t repeat_wait);
+
   void calculate_on_off_time_(uint32_t carrier_frequency, uint32_t *on_time_period, uint32_t *off_time_period);
 
   void delay_microseconds_accurate_(uint32_t usec);
@@ -205,10 +197,14 @@ class IRTransmitterComponent : public Component {
 
   GPIOPin *pin_;
   uint8_t carrier_duty_percent_;
+#ifdef ARDUINO_ARCH_ESP32
+  /// All transmitters created by create_transmitter(), their RMT items are encoded in setup().
+  std::vector<DataTransmitter *> transmitters_;
+#endif
 };
 
 #ifdef ARDUINO_ARCH_ESP32
-extern rmt_channel_t next_rmt_channel;
+using esphomelib::next_rmt_channel;
 #endif
 
 } // namespace switch_
@@ -82,7 +82,7 @@ class TurnOnAction : public Action<T> {
  public:
   explicit TurnOnAction(Switch *a_switch);
 
-  void play(T x) override;
+  bool play(T x) override;
 
  protected:
   Switch *switch_;
@@ -93,7 +93,7 @@ class TurnOffAction : public Action<T> {
  public:
   explicit TurnOffAction(Switch *a_switch);
 
-  void play(T x) override;
+  bool play(T x) override;
 
  protected:
   Switch *switch_;
@@ -104,7 +104,7 @@ class ToggleAction : public Action<T> {
  public:
   explicit ToggleAction(Switch *a_switch);
 
-  void play(T x) override;
+  bool play(T x) override;
 
  protected:
   Switch *switch_;
@@ -116,27 +116,27 @@ template<typename T>
 TurnOnAction<T>::TurnOnAction(Switch *a_switch) : switch_(a_switch) {}
 
 template<typename T>
-void TurnOnAction<T>::play(T x) {
+bool TurnOnAction<T>::play(T x) {
   this->switch_->write_state(true);
-  this->play_next(x);
+  return true;
 }
 
 template<typename T>
 TurnOffAction<T>::TurnOffAction(Switch *a_switch) : switch_(a_switch) {}
 
 template<typename T>
-void TurnOffAction<T>::play(T x) {
+bool TurnOffAction<T>::play(T x) {
   this->switch_->write_state(false);
-  this->play_next(x);
+  return true;
 }
 
 template<typename T>
 ToggleAction<T>::ToggleAction(Switch *a_switch) : switch_(a_switch) {}
 
 template<typename T>
-void ToggleAction<T>::play(T x) {
+bool ToggleAction<T>::play(T x) {
   this->switch_->write_state(!this->switch_->get_value());
-  this->play_next(x);
+  return true;
 }
 
 template<typename T>
@@ -14,15 +14,33 @@
 #endif
 
 #include <utility>
+#include <cstring>
 
 #include "esphomelib/helpers.h"
 #include "esphomelib/log.h"
 #include "esphomelib/esphal.h"
+#include "esphomelib/esppreferences.h"
+#include "esphomelib/rtc_memory.h"
 
 ESPHOMELIB_NAMESPACE_BEGIN
 
 static const char *TAG = "wifi";
 
+/// How long to wait for a fast connection before falling back to a full scan.
+static const uint32_t FAST_CONNECT_TIMEOUT = 5000;
+/// How long to wait for a regular connection attempt before starting a new one.
+static const uint32_t CONNECT_TIMEOUT = 10000;
+/// How long the STA may be disconnected before rebooting, if there's no AP to fall back to.
+static const uint32_t REBOOT_TIMEOUT = 30000;
+
+/// Pack BSSID and channel into a single preference value.
+static uint64_t encode_bssid_channel(const uint8_t *bssid, uint8_t channel) {
+  uint64_t value = channel;
+  for (int i = 0; i < 6; i++)
+    value = (value << 8) | bssid[i];
+  return value;
+}
+
 float WiFiComponent::get_setup_priority() const {
   return setup_priority::WIFI;
 }
@@ -43,12 +61,32 @@ void WiFiComponent::setup() {
 
   WiFi.persistent(false);
 
+  if (this->has_sta() && this->fast_connect_) {
+    // After deep sleep, RTC memory also has the DHCP lease. Otherwise fall back to the preferences.
+    WiFiFastConnectInfo info{};
+    uint64_t bssid_channel = global_preferences.get_uint64("wifi", "fast_connect", 0);
+    if (global_rtc_memory.restore("wifi", "fast_connect", &info)) {
+      this->fast_info_ = info;
+    } else if (bssid_channel != 0) {
+      for (int i = 5; i >= 0; i--, bssid_channel >>= 8)
+        info.bssid[i] = bssid_channel & 0xFF;
+      info.channel = bssid_channel & 0xFF;
+      this->fast_info_ = info;
+    }
+    if (global_rtc_memory.are_snapshots_enabled()) {
+      global_rtc_memory.add_on_snapshot_callback([this]() {
+        if (this->fast_info_.has_value())
+          global_rtc_memory.save("wifi", "fast_connect", *this->fast_info_);
+      });
+    }
+  }
+
   if (this->has_sta() && this->has_ap()) {
     this->setup_ap_config();
-    this->setup_sta_config();
+    this->setup_sta_config(true, true);
   } else if (this->has_sta()) {
     WiFi.enableAP(false);
-    this->setup_sta_config();
+    this->setup_sta_config(true, true);
     this->wait_for_sta();
   } else if (this->has_ap()) {
     WiFi.enableSTA(false);
@@ -59,35 +97,65 @@ void WiFiComponent::setup() {
 }
 
 void WiFiComponent::loop() {
+  if (this->has_sta())
+    this->loop_sta();
+
   if (this->has_sta() && this->has_ap()) {
-    if (this->sta_on_ && WiFi.status() == WL_CONNECTED && this->ap_on_) {
-      this->sta_connected();
+    if (this->is_connected() && this->ap_on_) {
       ESP_LOGI(TAG, "STA connected, disabling AP...");
       // Connected, disable AP
       WiFi.enableAP(false);
       this->ap_on_ = false;
-    } else if (this->sta_on_ && WiFi.status() != WL_CONNECTED && !this->ap_on_) {
+    } else if (!this->is_connected() && !this->ap_on_) {
       ESP_LOGI(TAG, "STA disconnected, re-enabling AP...");
-#ifdef ARDUINO_ARCH_ESP32
-      // Fix Arduino WiFi WL_CONNECTED issue
-      WiFi.enableSTA(false);
-      this->sta_on_ = false;
-#endif
-
-      // Re-enable AP
       this->setup_ap_config();
     }
-#ifdef ARDUINO_ARCH_ESP32
-    else if (!this->sta_on_) {
-      this->setup_sta_config(false);
-    }
-#endif
-  } else if (this->has_sta()) {
-    if (WiFi.status() != WL_CONNECTED) {
-      ESP_LOGI(TAG, "Reconnecting WiFi...");
-      this->setup_sta_config(false);
-      this->wait_for_sta();
+  }
+}
+
+void WiFiComponent::loop_sta() {
+  const uint32_t now = millis();
+  const wl_status_t status = WiFi.status();
+
+  switch (this->sta_state_) {
+    case WIFI_STA_CONNECTED:
+      if (this->sta_on_ && status == WL_CONNECTED)
+        return;
+      ESP_LOGW(TAG, "WiFi connection lost, reconnecting...");
+      this->sta_disconnected_since_ = now;
+      this->setup_sta_config(false, true);
+      return;
+    case WIFI_STA_CONNECTING_FAST:
+    case WIFI_STA_CONNECTING:
+      break;
+    default:
+      return;
+  }
+
+  // On the ESP32, sta_on_ is cleared by the STA disconnected event.
+  if (this->sta_on_ && status == WL_CONNECTED) {
+    this->sta_connected();
+    return;
+  }
+
+  if (!this->has_ap() && now - this->sta_disconnected_since_ > REBOOT_TIMEOUT) {
+    ESP_LOGE(TAG, "    Can't connect to WiFi network");
+    reboot("wifi");
+  }
+
+  const uint32_t elapsed = now - this->sta_attempt_start_;
+  const bool failed = !this->sta_on_ || status == WL_CONNECT_FAILED || status == WL_NO_SSID_AVAIL;
+  if (this->sta_state_ == WIFI_STA_CONNECTING_FAST) {
+    if (failed || elapsed > FAST_CONNECT_TIMEOUT) {
+      ESP_LOGD(TAG, "Fast connect failed (status=%d), falling back to a full scan...", status);
+      // The network might have changed, don't reuse the lease anymore.
+      if (this->fast_info_.has_value())
+        this->fast_info_->ip = 0;
+      this->setup_sta_config(false, false);
     }
+  } else if ((failed && elapsed > 1000) || elapsed > CONNECT_TIMEOUT) {
+    ESP_LOGV(TAG, "Retrying WiFi connection (status=%d)", status);
+    this->setup_sta_config(false, false);
   }
 }
 
@@ -144,28 +212,13 @@ void WiFiComponent::set_ap_manual_ip(ManualIP manual_ip) {
   this->ap_manual_ip_ = std::move(manual_ip);
 }
 void WiFiComponent::wait_for_sta() {
-  if (WiFi.status() == WL_CONNECTED)
+  if (this->is_connected())
     return;
   ESP_LOGI(TAG, "Waiting for WiFi connection");
-  uint32_t start = millis();
-  wl_status_t status;
-  while ((status = WiFi.status()) != WL_CONNECTED) {
-#ifdef ARDUINO_ARCH_ESP32
-    if (!this->sta_on_)
-      this->setup_sta_config(false);
-#endif
-
-    if (millis() - start > 30000) {
-      ESP_LOGE(TAG, "    Can't connect to WiFi network");
-      reboot("wifi");
-    }
-    if (status == WL_CONNECT_FAILED)
-      this->setup_sta_config(false);
-
-    delay(250);
-    ESP_LOGV(TAG, ". (status=%d)", status);
+  while (!this->is_connected()) {
+    this->loop_sta();
+    delay(10);
   }
-  this->sta_connected();
 }
 bool WiFiComponent::has_ap() const {
   return !this->ap_ssid_.empty();
@@ -173,7 +226,7 @@ bool WiFiComponent::has_ap() const {
 bool WiFiComponent::has_sta() const {
   return !this->sta_ssid_.empty();
 }
-void WiFiComponent::setup_sta_config(bool show_config) {
+void WiFiComponent::setup_sta_config(bool show_config, bool fast) {
   if (show_config) {
     ESP_LOGCONFIG(TAG, "Setting up STA...");
   }
@@ -182,12 +235,8 @@ void WiFiComponent::setup_sta_config(bool show_config) {
     ESP_LOGE(TAG, "WiFi.enableSTA() failed");
   }
   WiFi.setAutoConnect(false);
-#ifdef ARDUINO_ARCH_ESP32
+  // Reconnects are handled by loop_sta(), so that they can use the fast connect path.
   WiFi.setAutoReconnect(false);
-#endif
-#ifdef ARDUINO_ARCH_ESP8266
-  WiFi.setAutoReconnect(true);
-#endif
 
   if (show_config) {
     ESP_LOGCONFIG(TAG, "    STA SSID: '%s'", this->sta_ssid_.c_str());
@@ -212,6 +261,24 @@ void WiFiComponent::setup_sta_config(bool show_config) {
       ESP_LOGE(TAG, "WiFi.config() failed!");
   }
 
+  fast = fast && this->fast_info_.has_value();
+  // Only skip DHCP right after waking up from deep sleep, the lease might have expired since then otherwise.
+  const bool use_lease = fast && this->first_connect_ && global_rtc_memory.is_deep_sleep_wakeup() &&
+      !this->sta_manual_ip_ && this->fast_info_->ip != 0 && this->fast_info_->lease_uses < this->max_lease_reuses_ &&
+      this->is_lease_fresh_();
+  if (use_lease) {
+    ESP_LOGD(TAG, "Reusing DHCP lease for %s", IPAddress(this->fast_info_->ip).toString().c_str());
+    ret = WiFi.config(IPAddress(this->fast_info_->ip), IPAddress(this->fast_info_->gateway),
+                      IPAddress(this->fast_info_->subnet), IPAddress(this->fast_info_->dns1),
+                      IPAddress(this->fast_info_->dns2));
+    if (!ret)
+      ESP_LOGE(TAG, "WiFi.config() failed!");
+  } else if (this->using_lease_) {
+    // Switch back to DHCP.
+    WiFi.config(IPAddress(0u), IPAddress(0u), IPAddress(0u));
+  }
+  this->using_lease_ = use_lease;
+
   if (!this->hostname_.empty()) {
     if (show_config) {
       ESP_LOGCONFIG(TAG, "    STA Hostname: '%s'", this->hostname_.c_str());
@@ -226,11 +293,25 @@ void WiFiComponent::setup_sta_config(bool show_config) {
       ESP_LOGE(TAG, "WiFi.hostname() failed!");
   }
 
-  wl_status_t reti = WiFi.begin(this->sta_ssid_.c_str(), this->sta_password_.c_str());
+  wl_status_t reti;
+  if (fast) {
+    ESP_LOGD(TAG, "Fast connecting to %02X:%02X:%02X:%02X:%02X:%02X on channel %u...",
+             this->fast_info_->bssid[0], this->fast_info_->bssid[1], this->fast_info_->bssid[2],
+             this->fast_info_->bssid[3], this->fast_info_->bssid[4], this->fast_info_->bssid[5],
+             this->fast_info_->channel);
+    reti = WiFi.begin(this->sta_ssid_.c_str(), this->sta_password_.c_str(), this->fast_info_->channel,
+                      this->fast_info_->bssid);
+  } else {
+    reti = WiFi.begin(this->sta_ssid_.c_str(), this->sta_password_.c_str());
+  }
   if (reti == WL_CONNECT_FAILED) {
     ESP_LOGE(TAG, "WiFi.begin() failed: %d", reti);
   }
   this->sta_on_ = true;
+  if (this->sta_state_ == WIFI_STA_IDLE)
+    this->sta_disconnected_since_ = millis();
+  this->sta_state_ = fast ? WIFI_STA_CONNECTING_FAST : WIFI_STA_CONNECTING;
+  this->sta_attempt_start_ = millis();
 }
 void WiFiComponent::setup_ap_config() {
   ESP_LOGCONFIG(TAG, "Setting up AP...");
@@ -277,12 +358,43 @@ void WiFiComponent::setup_ap_config() {
 }
 
 void WiFiComponent::sta_connected() {
-  ESP_LOGI(TAG, "WiFi connected.");
+  ESP_LOGI(TAG, "WiFi connected in %ums.", unsigned(millis() - this->sta_disconnected_since_));
+  this->sta_state_ = WIFI_STA_CONNECTED;
+  this->first_connect_ = false;
   ESP_LOGCONFIG(TAG, "    IP Address: %s", WiFi.localIP().toString().c_str());
   ESP_LOGCONFIG(TAG, "    Subnet: %s", WiFi.subnetMask().toString().c_str());
   ESP_LOGCONFIG(TAG, "    Gateway: %s", WiFi.gatewayIP().toString().c_str());
   ESP_LOGCONFIG(TAG, "    DNS1: %s", WiFi.dnsIP(0).toString().c_str());
   ESP_LOGCONFIG(TAG, "    DNS2: %s", WiFi.dnsIP(1).toString().c_str());
+
+  if (!this->fast_connect_)
+    return;
+  WiFiFastConnectInfo info{};
+  if (this->fast_info_.has_value())
+    info = *this->fast_info_;
+  const uint8_t *bssid = WiFi.BSSID();
+  const uint8_t channel = WiFi.channel();
+  if (!this->fast_info_.has_value() || memcmp(info.bssid, bssid, 6) != 0 || info.channel != channel) {
+    memcpy(info.bssid, bssid, 6);
+    info.channel = channel;
+    global_preferences.put_uint64("wifi", "fast_connect", encode_bssid_channel(bssid, channel));
+  }
+  uint64_t clock;
+  if (this->using_lease_) {
+    info.lease_uses++;
+  } else if (!this->sta_manual_ip_ && !global_rtc_memory.get_clock(&clock)) {
+    // Without a clock, the age of the lease couldn't be told after the next wake-up.
+    info.ip = 0;
+  } else if (!this->sta_manual_ip_) {
+    info.lease_uses = 0;
+    info.lease_obtained = uint32_t(clock / 1000);
+    info.ip = uint32_t(WiFi.localIP());
+    info.gateway = uint32_t(WiFi.gatewayIP());
+    info.subnet = uint32_t(WiFi.subnetMask());
+    info.dns1 = uint32_t(WiFi.dnsIP(0));
+    info.dns2 = uint32_t(WiFi.dnsIP(1));
+  }
+  this->fast_info_ = info;
 }
 void WiFiComponent::set_sta(const std::string &ssid, const std::string &password) {
   this->sta_ssid_ = ssid;
@@ -299,6 +411,28 @@ void WiFiComponent::set_hostname(std::string &&hostname) {
 const std::string &WiFiComponent::get_hostname() {
   return this->hostname_;
 }
+void WiFiComponent::set_fast_connect(bool fast_connect) {
+  this->fast_connect_ = fast_connect;
+}
+void WiFiComponent::set_max_lease_reuses(uint8_t max_lease_reuses) {
+  this->max_lease_reuses_ = max_lease_reuses;
+}
+void WiFiComponent::set_lease_time(uint32_t lease_time) {
+  this->lease_time_ = lease_time;
+}
+bool WiFiComponent::is_lease_fresh_() {
+  uint64_t clock;
+  if (!global_rtc_memory.get_clock(&clock))
+    return false;
+  const uint64_t now = clock / 1000;
+  if (now < this->fast_info_->lease_obtained)
+    return false;
+  // Renew at half of the lease time like a DHCP client would (T1), the time in deep sleep counts too.
+  return (now - this->fast_info_->lease_obtained) * 1000 < this->lease_time_ / 2;
+}
+bool WiFiComponent::is_connected() {
+  return this->sta_state_ == WIFI_STA_CONNECTED && this->sta_on_ && WiFi.status() == WL_CONNECTED;
+}
 float WiFiComponent::get_loop_priority() const {
   return 10.0f; // before other loop components
 }
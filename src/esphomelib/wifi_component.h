@@ -31,6 +31,26 @@ struct ManualIP {
   IPAddress dns2; ///< The second DNS server. 0.0.0.0 for default.
 };
 
+enum WiFiSTAState {
+  WIFI_STA_IDLE = 0,
+  WIFI_STA_CONNECTING_FAST, ///< Connecting directly to the BSSID and channel of the last connection.
+  WIFI_STA_CONNECTING, ///< Connecting after a full scan.
+  WIFI_STA_CONNECTED,
+};
+
+/// The parameters of the last successful STA connection, used for fast reconnects.
+struct WiFiFastConnectInfo {
+  uint8_t bssid[6];
+  uint8_t channel;
+  uint8_t lease_uses; ///< How often the lease below has been reused without a DHCP handshake.
+  uint32_t lease_obtained; ///< The RTCMemory clock (in seconds) when the lease was obtained.
+  uint32_t ip; ///< The DHCP lease, 0 if there is none.
+  uint32_t gateway;
+  uint32_t subnet;
+  uint32_t dns1;
+  uint32_t dns2;
+};
+
 /// This component is responsible for managing the ESP WiFi interface.
 class WiFiComponent : public Component {
  public:
@@ -59,6 +79,34 @@ class WiFiComponent : public Component {
   void set_hostname(std::string &&hostname);
   const std::string &get_hostname();
 
+  /** Set whether to connect directly to the BSSID and channel of the last successful connection. Defaults to true.
+   *
+   * This skips the scan for the network and if it fails, a regular connection with a full scan is made.
+   * The BSSID and channel are stored in the preferences and are only written if they change.
+   */
+  void set_fast_connect(bool fast_connect);
+
+  /** Set how often the DHCP lease of the last connection may be reused after waking up from deep sleep. Defaults to 8.
+   *
+   * Reusing the lease skips the DHCP handshake, but the lease isn't renewed with the DHCP server then.
+   * So after this many wake-ups, a regular DHCP handshake is made again. 0 disables reusing leases.
+   * The lease is only reused for the first connection after waking up from deep sleep, reconnects after
+   * a lost connection always do DHCP. Has no effect when a manual IP is set. Leases are also never reused
+   * for more than half of the lease time, see set_lease_time().
+   */
+  void set_max_lease_reuses(uint8_t max_lease_reuses);
+
+  /** Set the lease time (in ms) of the DHCP server, defaults to 1 hour (the default of dnsmasq).
+   *
+   * A lease is only reused until half of this time (when a DHCP client would renew it) has passed since
+   * it was obtained, counting the time spent in deep sleep. The DHCP server could give the address to
+   * another device after the lease expired otherwise.
+   */
+  void set_lease_time(uint32_t lease_time);
+
+  /// Return whether the STA interface is connected.
+  bool is_connected();
+
   // ========== INTERNAL METHODS ==========
   // (In most use cases you won't need these)
   /// Setup WiFi interface.
@@ -74,7 +122,15 @@ class WiFiComponent : public Component {
   bool has_ap() const;
 
  protected:
-  void setup_sta_config(bool show_config = true);
+  /** Configure the STA interface and start connecting.
+   *
+   * @param show_config Whether to log the configuration.
+   * @param fast Whether to connect directly using the parameters of the last connection, if they exist.
+   */
+  void setup_sta_config(bool show_config = true, bool fast = false);
+
+  /// Advance the non-blocking STA connection state machine.
+  void loop_sta();
 
   void setup_ap_config();
 
@@ -83,17 +139,29 @@ class WiFiComponent : public Component {
   static void on_wifi_event(WiFiEvent_t event);
 #endif
 
-  /// Waits for the WiFi class to return a connected state.
+  /// Runs the STA state machine until the WiFi class returns a connected state.
   void wait_for_sta();
 
   void sta_connected();
 
+  /// Return whether the lease in fast_info_ was obtained less than half of the lease time ago.
+  bool is_lease_fresh_();
+
   std::string hostname_;
 
   bool sta_on_;
   std::string sta_ssid_;
   std::string sta_password_;
   optional<ManualIP> sta_manual_ip_;
+  WiFiSTAState sta_state_{WIFI_STA_IDLE};
+  uint32_t sta_attempt_start_{0}; ///< When the current connection attempt was started.
+  uint32_t sta_disconnected_since_{0}; ///< When the STA was last connected, or when connecting started.
+  bool fast_connect_{true};
+  uint8_t max_lease_reuses_{8};
+  uint32_t lease_time_{3600000};
+  bool using_lease_{false}; ///< Whether the current attempt uses the IP of a reused lease as static IP.
+  bool first_connect_{true}; ///< Whether the STA hasn't been connected since boot.
+  optional<WiFiFastConnectInfo> fast_info_{};
 
   bool ap_on_;
   std::string ap_ssid_;
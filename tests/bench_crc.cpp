@@ -0,0 +1,69 @@
+// Times the nibble-table CRCs against the bit-at-a-time loops they replaced, on 1 KB of data.
+#include "benchmark.h"
+#include "esphomelib/crc.h"
+
+using namespace esphomelib;
+
+static uint8_t bitwise_crc8_dallas(const uint8_t *data, size_t len, uint8_t crc) {
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++)
+      crc = (crc & 1) ? (crc >> 1) ^ 0x8C : crc >> 1;
+  }
+  return crc;
+}
+static uint8_t bitwise_crc8_sensirion(const uint8_t *data, size_t len, uint8_t crc) {
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++)
+      crc = (crc & 0x80) ? (crc << 1) ^ 0x31 : crc << 1;
+  }
+  return crc;
+}
+static uint16_t bitwise_crc16(const uint8_t *data, size_t len, uint16_t crc) {
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++)
+      crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+  }
+  return crc;
+}
+static uint32_t bitwise_crc32(const uint8_t *data, size_t len, uint32_t crc) {
+  crc = ~crc;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++)
+      crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320UL : crc >> 1;
+  }
+  return ~crc;
+}
+
+static uint8_t data[1024];
+
+template<typename Bitwise, typename Table>
+static bool compare(const char *name, Bitwise &&bitwise, Table &&table) {
+  const bool same = bitwise() == table();
+  const double bitwise_ns = benchmark_ns(2000, [&]() { benchmark_keep(bitwise()); });
+  const double table_ns = benchmark_ns(2000, [&]() { benchmark_keep(table()); });
+  printf("  %-15s bitwise %7.0f ns, table %7.0f ns (%.1fx)%s\n", name, bitwise_ns, table_ns,
+         bitwise_ns / table_ns, same ? "" : " MISMATCH");
+  return same;
+}
+
+int main() {
+  for (size_t i = 0; i < sizeof(data); i++)
+    data[i] = uint8_t(i * 131 + 7);
+  const size_t len = sizeof(data);
+
+  printf("CRC of 1 KB:\n");
+  bool same = true;
+  same &= compare("crc8_dallas", [&]() { return bitwise_crc8_dallas(data, len, 0x00); },
+                  [&]() { return crc8_dallas(data, len); });
+  same &= compare("crc8_sensirion", [&]() { return bitwise_crc8_sensirion(data, len, 0xFF); },
+                  [&]() { return crc8_sensirion(data, len); });
+  same &= compare("crc16", [&]() { return bitwise_crc16(data, len, 0xFFFF); },
+                  [&]() { return crc16(data, len); });
+  same &= compare("crc32", [&]() { return bitwise_crc32(data, len, 0); },
+                  [&]() { return crc32(data, len); });
+  return same ? 0 : 1;
+}
@@ -0,0 +1,33 @@
+// Times dithering a frame of a 1000-LED strip, against just truncating it to 8 bits like without dithering.
+#include <vector>
+
+#include "benchmark.h"
+#include "esphomelib/light/light_dithering.h"
+
+using namespace esphomelib::light;
+
+int main() {
+  const size_t num_values = 1000 * 3;
+  std::vector<uint16_t> src(num_values);
+  std::vector<uint8_t> error(num_values);
+  std::vector<uint8_t> dst(num_values);
+  for (size_t i = 0; i < num_values; i++) {
+    src[i] = uint16_t(i * 7919 % 65281);
+    error[i] = uint8_t(i * 167);
+  }
+
+  const double truncate_ns = benchmark_ns(2000, [&]() {
+    for (size_t i = 0; i < num_values; i++)
+      dst[i] = src[i] >> 8;
+    benchmark_keep(dst[num_values / 2]);
+  });
+  const double dither_ns = benchmark_ns(2000, [&]() {
+    benchmark_keep(dither_range(src.data(), error.data(), dst.data(), num_values));
+    benchmark_keep(dst[num_values / 2]);
+  });
+
+  printf("One frame of a 1000-LED strip:\n");
+  printf("  truncate: %8.0f ns\n", truncate_ns);
+  printf("  dither:   %8.0f ns (%.2f ns per LED)\n", dither_ns, dither_ns / 1000.0);
+  return 0;
+}
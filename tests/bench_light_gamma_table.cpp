@@ -0,0 +1,37 @@
+// Compares gamma correcting a channel with the lookup table against calling powf for it, like LightState used to.
+#include "benchmark.h"
+#include "esphomelib/helpers.h"
+#include "esphomelib/light/light_color_values.h"
+
+using namespace esphomelib;
+using namespace esphomelib::light;
+
+int main() {
+  const float gamma = 2.8f;
+  LightGammaTable table;
+  table.compute(gamma);
+
+  // Channel values all over the range, the same sequence for both.
+  uint16_t values[1024];
+  uint32_t seed = 1;
+  for (uint16_t &value : values) {
+    seed = seed * 1103515245 + 12345;
+    value = uint16_t(seed >> 16);
+  }
+
+  size_t i = 0;
+  const double powf_ns = benchmark_ns(1000000, [&]() {
+    const float value = gamma_correct(LightColorValues::raw_to_float(values[i++ & 1023]), gamma);
+    benchmark_keep(uint32_t(value * 65535.0f));
+  });
+  i = 0;
+  const double table_ns = benchmark_ns(1000000, [&]() {
+    const float value = LightColorValues::raw_to_float(table.correct(values[i++ & 1023]));
+    benchmark_keep(uint32_t(value * 65535.0f));
+  });
+
+  printf("Gamma correction of one channel (gamma %.1f):\n", gamma);
+  printf("  powf:         %6.2f ns\n", powf_ns);
+  printf("  lookup table: %6.2f ns (%.1fx)\n", table_ns, powf_ns / table_ns);
+  return 0;
+}
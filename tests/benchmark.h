@@ -0,0 +1,39 @@
+// A minimal timing helper for the host benchmarks, each benchmark is a plain executable like the tests.
+#ifndef ESPHOMELIB_TESTS_BENCHMARK_H
+#define ESPHOMELIB_TESTS_BENCHMARK_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+/// Results are folded into this so that the compiler can't optimize the benchmarked code away.
+inline volatile uint32_t &benchmark_sink() {
+  static volatile uint32_t sink = 0;
+  return sink;
+}
+
+/// Keep a result alive.
+inline void benchmark_keep(uint32_t value) {
+  benchmark_sink() = benchmark_sink() + value;
+}
+
+/** Measure the average time of one call of f in nanoseconds.
+ *
+ * f is called iterations times per run, the fastest of 5 runs is returned to filter out scheduling noise.
+ */
+template<typename F>
+double benchmark_ns(uint32_t iterations, F &&f) {
+  double best = 0;
+  for (int run = 0; run < 5; run++) {
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; i++)
+      f();
+    const auto end = std::chrono::steady_clock::now();
+    const double ns = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+    if (run == 0 || ns < best)
+      best = ns;
+  }
+  return best;
+}
+
+#endif //ESPHOMELIB_TESTS_BENCHMARK_H
@@ -0,0 +1,53 @@
+// Minimal stand-in for the Arduino core so that esphomelib sources can be compiled on the host.
+// Time is simulated, see host_time_advance_us() in host.cpp.
+#ifndef ESPHOMELIB_TESTS_HOST_ARDUINO_H
+#define ESPHOMELIB_TESTS_HOST_ARDUINO_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#define ICACHE_RAM_ATTR
+#define PROGMEM
+#define pgm_read_byte(addr) (*reinterpret_cast<const uint8_t *>(addr))
+#define pgm_read_word(addr) (*reinterpret_cast<const uint16_t *>(addr))
+#define pgm_read_dword(addr) (*reinterpret_cast<const uint32_t *>(addr))
+
+#define LOW 0x0
+#define HIGH 0x1
+#define INPUT 0x00
+#define OUTPUT 0x01
+#define INPUT_PULLUP 0x02
+#define OUTPUT_OPEN_DRAIN 0x03
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+typedef bool boolean;
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int digitalPinToInterrupt(uint8_t pin);
+void attachInterrupt(uint8_t interrupt, void (*handler)(), int mode);
+void detachInterrupt(uint8_t interrupt);
+void interrupts();
+void noInterrupts();
+long random(long max); // NOLINT
+uint32_t os_random();
+char *dtostrf(double value, signed char width, unsigned char precision, char *buffer);
+inline double pow10(double x) { return pow(10.0, x); }
+
+/// Advance the simulated clock returned by millis() and micros().
+void host_time_advance_us(uint32_t us);
+
+#endif //ESPHOMELIB_TESTS_HOST_ARDUINO_H
@@ -0,0 +1,16 @@
+// Minimal stand-in for the ESP Arduino core's EspClass.
+#ifndef ESPHOMELIB_TESTS_HOST_ESP_H
+#define ESPHOMELIB_TESTS_HOST_ESP_H
+
+#include <cstdint>
+
+class EspClass {
+ public:
+  void restart();
+  void deepSleep(uint64_t time_us);
+  uint32_t getFreeHeap();
+};
+
+extern EspClass ESP;
+
+#endif //ESPHOMELIB_TESTS_HOST_ESP_H
@@ -0,0 +1,18 @@
+// Minimal stand-in for the Arduino IPAddress class.
+#ifndef ESPHOMELIB_TESTS_HOST_IP_ADDRESS_H
+#define ESPHOMELIB_TESTS_HOST_IP_ADDRESS_H
+
+#include <cstdint>
+
+class IPAddress {
+ public:
+  IPAddress(uint32_t address = 0) : address_(address) {} // NOLINT
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+      : address_(uint32_t(a) | uint32_t(b) << 8 | uint32_t(c) << 16 | uint32_t(d) << 24) {}
+  operator uint32_t() const { return this->address_; } // NOLINT
+
+ protected:
+  uint32_t address_;
+};
+
+#endif //ESPHOMELIB_TESTS_HOST_IP_ADDRESS_H
@@ -0,0 +1,57 @@
+#include "Wire.h"
+
+TwoWire Wire;
+
+void TwoWire::begin(int sda, int scl) {}
+void TwoWire::setClock(uint32_t frequency) {}
+void TwoWire::beginTransmission(uint8_t address) {
+  this->tx_address_ = address;
+  this->tx_buffer_.clear();
+}
+uint8_t TwoWire::endTransmission(bool send_stop) {
+  Device *device = this->find_device_(this->tx_address_);
+  if (device == nullptr)
+    return 2; // NACK on address
+  if (this->tx_buffer_.size() > BUFFER_LENGTH)
+    return 1; // too much data
+  for (size_t i = 0; i < this->tx_buffer_.size(); i++) {
+    if (i == 0)
+      device->pointer = this->tx_buffer_[0];
+    else
+      device->registers[device->pointer++] = this->tx_buffer_[i];
+  }
+  return 0;
+}
+size_t TwoWire::write(uint8_t data) {
+  this->tx_buffer_.push_back(data);
+  return 1;
+}
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t len) {
+  this->num_requests_++;
+  this->rx_buffer_.clear();
+  this->rx_pos_ = 0;
+  Device *device = this->find_device_(address);
+  if (device == nullptr || len > BUFFER_LENGTH)
+    return 0;
+  for (uint8_t i = 0; i < len; i++)
+    this->rx_buffer_.push_back(device->registers[device->pointer++]);
+  return len;
+}
+int TwoWire::available() {
+  return int(this->rx_buffer_.size() - this->rx_pos_);
+}
+int TwoWire::read() {
+  if (this->rx_pos_ >= this->rx_buffer_.size())
+    return -1;
+  return this->rx_buffer_[this->rx_pos_++];
+}
+void TwoWire::add_device(uint8_t address, uint8_t *registers) {
+  this->devices_.push_back(Device{address, registers, 0});
+}
+TwoWire::Device *TwoWire::find_device_(uint8_t address) {
+  for (auto &device : this->devices_) {
+    if (device.address == address)
+      return &device;
+  }
+  return nullptr;
+}
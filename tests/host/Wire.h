@@ -0,0 +1,48 @@
+// Simulated i2c bus for the host tests.
+//
+// Devices are plain register files with an auto-incrementing register pointer: the first byte of a write
+// sets the pointer, the following bytes are written to the registers. Reads start at the pointer.
+#ifndef ESPHOMELIB_TESTS_HOST_WIRE_H
+#define ESPHOMELIB_TESTS_HOST_WIRE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define BUFFER_LENGTH 32
+
+class TwoWire {
+ public:
+  void begin(int sda, int scl);
+  void setClock(uint32_t frequency);
+  void beginTransmission(uint8_t address);
+  uint8_t endTransmission(bool send_stop = true);
+  size_t write(uint8_t data);
+  uint8_t requestFrom(uint8_t address, uint8_t len);
+  int available();
+  int read();
+
+  /// Attach a device with 256 registers at address, registers must outlive the bus.
+  void add_device(uint8_t address, uint8_t *registers);
+  /// The number of requestFrom() calls so far.
+  size_t get_num_requests() const { return this->num_requests_; }
+
+ protected:
+  struct Device {
+    uint8_t address;
+    uint8_t *registers;
+    uint8_t pointer;
+  };
+  Device *find_device_(uint8_t address);
+
+  std::vector<Device> devices_;
+  uint8_t tx_address_{0};
+  std::vector<uint8_t> tx_buffer_;
+  std::vector<uint8_t> rx_buffer_;
+  size_t rx_pos_{0};
+  size_t num_requests_{0};
+};
+
+extern TwoWire Wire;
+
+#endif //ESPHOMELIB_TESTS_HOST_WIRE_H
@@ -0,0 +1,77 @@
+// Host implementations of the Arduino core functions declared in the stub headers.
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+
+#include "Arduino.h"
+#include "Esp.h"
+#include "esphomelib/log.h"
+
+static uint64_t host_time_us = 0;
+
+void host_time_advance_us(uint32_t us) {
+  host_time_us += us;
+}
+uint32_t millis() {
+  return uint32_t(host_time_us / 1000);
+}
+uint32_t micros() {
+  return uint32_t(host_time_us);
+}
+void delay(uint32_t ms) {
+  host_time_us += uint64_t(ms) * 1000;
+}
+void delayMicroseconds(uint32_t us) {
+  host_time_us += us;
+}
+void yield() {}
+
+void pinMode(uint8_t pin, uint8_t mode) {}
+void digitalWrite(uint8_t pin, uint8_t value) {}
+int digitalRead(uint8_t pin) {
+  return LOW;
+}
+int digitalPinToInterrupt(uint8_t pin) {
+  return pin;
+}
+void attachInterrupt(uint8_t interrupt, void (*handler)(), int mode) {}
+void detachInterrupt(uint8_t interrupt) {}
+void interrupts() {}
+void noInterrupts() {}
+long random(long max) { // NOLINT
+  return rand() % max;
+}
+uint32_t os_random() {
+  return uint32_t(rand());
+}
+char *dtostrf(double value, signed char width, unsigned char precision, char *buffer) {
+  sprintf(buffer, "%*.*f", width, precision, value);
+  return buffer;
+}
+
+EspClass ESP;
+
+void EspClass::restart() {
+  abort();
+}
+void EspClass::deepSleep(uint64_t time_us) {
+  abort();
+}
+uint32_t EspClass::getFreeHeap() {
+  return 0;
+}
+
+int esp_log_vprintf_(int level, const char *tag, const char *format, va_list args) {
+  if (level > ESPHOMELIB_LOG_LEVEL_WARN)
+    return 0;
+  int ret = vfprintf(stderr, format, args);
+  fputc('\n', stderr);
+  return ret;
+}
+int esp_log_printf_(int level, const char *tag, const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  int ret = esp_log_vprintf_(level, tag, format, args);
+  va_end(args);
+  return ret;
+}
@@ -0,0 +1,87 @@
+// Checks that DelayAction resumes its list from the shared scheduler and can still be registered as a Component.
+#include <Arduino.h>
+#include <vector>
+
+#include "unit_test.h"
+#include "esphomelib/automation.h"
+
+using namespace esphomelib;
+
+struct Fixture {
+  explicit Fixture(DelayMode mode) {
+    this->delay.set_delay(100);
+    this->delay.set_mode(mode, 2);
+    this->automation.add_action(&this->delay);
+    this->automation.add_action(&this->lambda);
+  }
+
+  void advance(uint32_t ms) {
+    host_time_advance_us(ms * 1000);
+    global_automation_scheduler.loop();
+  }
+
+  Trigger<int> trigger;
+  Automation<int> automation{&this->trigger};
+  DelayAction<int> delay;
+  LambdaAction<int> lambda{[this](int x) { this->played.push_back(x); }};
+  std::vector<int> played;
+};
+
+static void test_component() {
+  // Generated code registers the delay like any other component, setup() and loop() must not do anything.
+  Fixture fixture(DELAY_MODE_PARALLEL);
+  Component *component = &fixture.delay;
+  component->setup_();
+  fixture.trigger.trigger(1);
+  component->loop_();
+  TEST_CHECK(fixture.played.empty());
+  fixture.advance(101);
+  component->loop_();
+  TEST_CHECK(fixture.played == std::vector<int>{1});
+}
+
+static void test_parallel() {
+  Fixture fixture(DELAY_MODE_PARALLEL);
+  fixture.trigger.trigger(1);
+  fixture.advance(50);
+  fixture.trigger.trigger(2);
+  // Dropped, both slots are in use.
+  fixture.trigger.trigger(3);
+  fixture.advance(51);
+  TEST_CHECK(fixture.played == std::vector<int>{1});
+  fixture.advance(50);
+  TEST_CHECK((fixture.played == std::vector<int>{1, 2}));
+}
+
+static void test_restart() {
+  Fixture fixture(DELAY_MODE_RESTART);
+  fixture.trigger.trigger(1);
+  fixture.advance(50);
+  fixture.trigger.trigger(2);
+  fixture.advance(51);
+  TEST_CHECK(fixture.played.empty());
+  fixture.advance(50);
+  TEST_CHECK(fixture.played == std::vector<int>{2});
+}
+
+static void test_queue() {
+  Fixture fixture(DELAY_MODE_QUEUE);
+  fixture.trigger.trigger(1);
+  fixture.trigger.trigger(2);
+  // Dropped, the queue holds 2 values including the running one.
+  fixture.trigger.trigger(3);
+  fixture.advance(101);
+  TEST_CHECK(fixture.played == std::vector<int>{1});
+  fixture.advance(101);
+  TEST_CHECK((fixture.played == std::vector<int>{1, 2}));
+  fixture.advance(101);
+  TEST_CHECK((fixture.played == std::vector<int>{1, 2}));
+}
+
+int main() {
+  test_component();
+  test_parallel();
+  test_restart();
+  test_queue();
+  return unit_test_result();
+}
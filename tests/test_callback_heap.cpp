@@ -0,0 +1,227 @@
+// Compares the heap used by the callbacks of a representative node when they're passed as std::function or
+// InlineFunction, and checks that the public callback APIs don't allocate for small captures.
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+
+#include "unit_test.h"
+#include "esphomelib/automation.h"
+#include "esphomelib/helpers.h"
+#include "esphomelib/rtc_memory.h"
+#include "esphomelib/binary_sensor/binary_sensor.h"
+#include "esphomelib/sensor/sensor.h"
+
+using namespace esphomelib;
+
+static size_t num_allocations = 0;
+static size_t num_allocated_bytes = 0;
+
+void *operator new(size_t size) {
+  num_allocations++;
+  num_allocated_bytes += size;
+  void *ptr = malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr)
+    throw std::bad_alloc();
+  return ptr;
+}
+void operator delete(void *ptr) noexcept {
+  free(ptr);
+}
+
+struct HeapUsage {
+  size_t allocations;
+  size_t bytes;
+};
+
+static HeapUsage heap_since(const HeapUsage &start) {
+  return HeapUsage{num_allocations - start.allocations, num_allocated_bytes - start.bytes};
+}
+static HeapUsage heap_now() {
+  return HeapUsage{num_allocations, num_allocated_bytes};
+}
+
+/// Passes callbacks to the APIs either directly or converted to a std::function first, like the APIs used to.
+class CallbackFactory {
+ public:
+  explicit CallbackFactory(bool use_std_function) : use_std_function_(use_std_function) {}
+
+  template<typename Signature, typename F>
+  InlineFunction<Signature> make(F &&f) {
+    if (!this->use_std_function_)
+      return InlineFunction<Signature>(std::forward<F>(f));
+    // The ESP8266 toolchain's std::function copies every closure to the heap.
+    this->num_closures_++;
+    this->closure_bytes_ += sizeof(typename std::decay<F>::type);
+    return InlineFunction<Signature>(std::function<Signature>(std::forward<F>(f)));
+  }
+
+  size_t get_num_closures() const {
+    return this->num_closures_;
+  }
+  size_t get_closure_bytes() const {
+    return this->closure_bytes_;
+  }
+
+ protected:
+  bool use_std_function_;
+  size_t num_closures_{0};
+  size_t closure_bytes_{0};
+};
+
+/// Stand-ins for the front-ends, registering callbacks with the same captures as the MQTT and web server components.
+struct FrontEnd {
+  void send(float value) {
+    this->last_value = value;
+  }
+  void send(bool state) {
+    this->last_state = state;
+  }
+  float last_value{0};
+  bool last_state{false};
+};
+
+struct Heater {
+  bool on{false};
+};
+
+/// The registries that are global on a node, separate for each build so that their vectors grow the same way.
+struct Globals {
+  RTCMemory rtc_memory;
+  CallbackManager<void(const char *)> shutdown_hooks;
+};
+
+/** A node like the examples: 4 sensors and 2 binary sensors that are reported over MQTT and the web server,
+ * with filters, deep sleep snapshots, shutdown hooks and a few automations.
+ */
+static void build_node(CallbackFactory *factory, Globals *globals, FrontEnd *mqtt, FrontEnd *web_server,
+                       Heater *heater) {
+  const char *sensor_names[] = {"Temperature", "Humidity", "Pressure", "WiFi Signal"};
+  for (const char *name : sensor_names) {
+    auto *sensor = new sensor::Sensor(name);
+    sensor->add_sliding_window_average_filter(15, 15);
+    sensor->add_on_value_callback(factory->make<void(float)>([mqtt](float value) {
+      mqtt->send(value);
+    }));
+    sensor->add_on_value_callback(factory->make<void(float)>([web_server, sensor](float value) {
+      web_server->send(sensor->get_value() + value);
+    }));
+    globals->rtc_memory.add_on_snapshot_callback(factory->make<void()>([sensor]() {
+      (void) sensor->get_value();
+    }));
+  }
+
+  auto *temperature = new sensor::Sensor("Outside Temperature");
+  auto *trigger = new sensor::SensorValueTrigger(temperature);
+  auto *automation = new Automation<float>(trigger);
+  const float target = 21.5f;
+  const float hysteresis = 0.5f;
+  automation->add_action(new LambdaAction<float>(factory->make<void(float)>(
+      [heater, target, hysteresis, temperature](float value) {
+    heater->on = value < target - hysteresis || (heater->on && temperature->get_value() < target);
+  })));
+
+  const char *binary_sensor_names[] = {"Status", "Button"};
+  for (const char *name : binary_sensor_names) {
+    auto *binary_sensor = new binary_sensor::BinarySensor(name);
+    binary_sensor->add_on_state_callback(factory->make<void(bool)>([mqtt](bool state) {
+      mqtt->send(state);
+    }));
+    binary_sensor->add_on_state_callback(factory->make<void(bool)>([web_server, binary_sensor](bool state) {
+      web_server->send(state != binary_sensor->get_value());
+    }));
+    auto *click = new binary_sensor::ClickTrigger(binary_sensor, 50, 350);
+    auto *click_automation = new Automation<NoArg>(click);
+    click_automation->add_action(new LambdaAction<NoArg>(factory->make<void(NoArg)>([heater, mqtt, web_server](NoArg) {
+      heater->on = !heater->on;
+      mqtt->send(heater->on);
+      web_server->send(heater->on);
+    })));
+  }
+
+  // MQTT, WiFi, OTA and the preferences.
+  for (int i = 0; i < 4; i++) {
+    globals->shutdown_hooks.add(factory->make<void(const char *)>([mqtt](const char *cause) {
+      mqtt->send(cause != nullptr);
+    }));
+  }
+}
+
+static void test_representative_node() {
+  FrontEnd mqtt, web_server;
+  Heater heater;
+
+  CallbackFactory std_functions(true);
+  Globals std_function_globals;
+  HeapUsage start = heap_now();
+  build_node(&std_functions, &std_function_globals, &mqtt, &web_server, &heater);
+  const HeapUsage with_std_function = heap_since(start);
+
+  CallbackFactory inline_functions(false);
+  Globals inline_function_globals;
+  start = heap_now();
+  build_node(&inline_functions, &inline_function_globals, &mqtt, &web_server, &heater);
+  const HeapUsage with_inline_function = heap_since(start);
+
+  printf("Representative node, heap used while building it:\n");
+  printf("  std::function:  %zu allocations, %zu bytes\n", with_std_function.allocations, with_std_function.bytes);
+  printf("  InlineFunction: %zu allocations, %zu bytes\n", with_inline_function.allocations,
+         with_inline_function.bytes);
+  printf("  On the ESP8266, std::function additionally allocates all %zu closures (%zu bytes on this host).\n",
+         std_functions.get_num_closures(), std_functions.get_closure_bytes());
+
+  // Everything but the closures is the same, closures with more than two pointers allocate even on this host.
+  TEST_CHECK(with_inline_function.allocations < with_std_function.allocations);
+  TEST_CHECK(with_inline_function.bytes < with_std_function.bytes);
+}
+
+/// Register callbacks until the callback vector has room for one more, then check that the next one doesn't allocate.
+template<typename Register>
+static size_t allocations_of_fourth_callback(Register &&register_callback) {
+  for (int i = 0; i < 3; i++)
+    register_callback();
+  const HeapUsage start = heap_now();
+  register_callback();
+  return heap_since(start).allocations;
+}
+
+static void test_apis_do_not_allocate() {
+  // Three pointers, more than std::function stores inline on any toolchain.
+  FrontEnd a, b, c;
+  FrontEnd *pa = &a, *pb = &b, *pc = &c;
+
+  sensor::Sensor sensor("Sensor");
+  TEST_CHECK(allocations_of_fourth_callback([&]() {
+    sensor.add_on_value_callback([pa, pb, pc](float value) { pa->send(value + pb->last_value + pc->last_value); });
+  }) == 0);
+  TEST_CHECK(allocations_of_fourth_callback([&]() {
+    sensor.add_on_raw_value_callback([pa, pb, pc](float value) { pa->send(value + pb->last_value + pc->last_value); });
+  }) == 0);
+
+  binary_sensor::BinarySensor binary_sensor("Binary Sensor");
+  TEST_CHECK(allocations_of_fourth_callback([&]() {
+    binary_sensor.add_on_state_callback([pa, pb, pc](bool state) { pa->send(state && pb->last_state && pc->last_state); });
+  }) == 0);
+
+  RTCMemory rtc_memory;
+  TEST_CHECK(allocations_of_fourth_callback([&]() {
+    rtc_memory.add_on_snapshot_callback([pa, pb, pc]() { pa->send(pb->last_value + pc->last_value); });
+  }) == 0);
+
+  Trigger<float> trigger;
+  TEST_CHECK(allocations_of_fourth_callback([&]() {
+    trigger.add_on_trigger_callback([pa, pb, pc](float value) { pa->send(value + pb->last_value + pc->last_value); });
+  }) == 0);
+
+  // The callbacks still work after being moved around by the vectors.
+  sensor.push_new_value(1.0f);
+  binary_sensor.publish_state(true);
+  trigger.trigger(2.0f);
+  TEST_CHECK(a.last_value == 2.0f);
+}
+
+int main() {
+  test_apis_do_not_allocate();
+  test_representative_node();
+  return unit_test_result();
+}
@@ -0,0 +1,73 @@
+// Checks the interval, timeout and defer scheduling of Component on the simulated clock.
+#include <Arduino.h>
+
+#include "unit_test.h"
+#include "esphomelib/component.h"
+
+using namespace esphomelib;
+
+/// Cleared when destroyed, so a closure that runs after being moved away sees it.
+struct Canary {
+  Canary() = default;
+  Canary(const Canary &) = default;
+  ~Canary() {
+    this->alive = false;
+  }
+  bool alive{true};
+};
+
+class TestComponent : public Component {
+ public:
+  void setup() override {
+    Canary canary;
+    this->set_interval("grow", 10, [this, canary]() {
+      // Enough new time functions to reallocate the vector this closure is stored in.
+      for (int i = 0; i < 20; i++)
+        this->set_timeout(1000 + i, [this]() { this->num_timeouts++; });
+      this->canary_alive = canary.alive;
+      this->num_intervals++;
+    });
+    this->defer([this]() { this->num_defers++; });
+  }
+
+  void stop() {
+    this->cancel_interval("grow");
+  }
+
+  bool canary_alive{false};
+  int num_intervals{0};
+  int num_timeouts{0};
+  int num_defers{0};
+};
+
+static void test_reallocation_while_running() {
+  TestComponent component;
+  component.setup_();
+
+  // Intervals start at a random offset, so the first run may or may not be in the first loop.
+  component.loop_();
+  TEST_CHECK(component.num_defers == 1);
+  const int first_intervals = component.num_intervals;
+
+  for (int i = 1; i <= 2; i++) {
+    component.canary_alive = false;
+    host_time_advance_us(11000);
+    component.loop_();
+    TEST_CHECK(component.num_intervals == first_intervals + i);
+    // The closure must still be intact after the vector it was in reallocated, and run again after that.
+    TEST_CHECK(component.canary_alive);
+  }
+  component.stop();
+
+  host_time_advance_us(1100000);
+  component.loop_();
+  component.loop_();
+  TEST_CHECK(component.num_defers == 1);
+  TEST_CHECK(component.num_intervals == first_intervals + 2);
+  TEST_CHECK(component.num_timeouts == component.num_intervals * 20);
+}
+
+int main() {
+  test_reallocation_while_running();
+  return unit_test_result();
+}
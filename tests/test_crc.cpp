@@ -0,0 +1,91 @@
+// Checks the nibble-table CRCs against the published check values and a bit-at-a-time reference.
+#include <cstdlib>
+#include <cstring>
+
+#include "unit_test.h"
+#include "esphomelib/crc.h"
+
+using namespace esphomelib;
+
+static const uint8_t CHECK_DATA[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+
+static uint8_t reference_crc8_reflected(const uint8_t *data, size_t len, uint8_t crc) {
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++)
+      crc = (crc & 1) ? (crc >> 1) ^ 0x8C : crc >> 1;
+  }
+  return crc;
+}
+static uint8_t reference_crc8(const uint8_t *data, size_t len, uint8_t crc) {
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++)
+      crc = (crc & 0x80) ? (crc << 1) ^ 0x31 : crc << 1;
+  }
+  return crc;
+}
+static uint16_t reference_crc16(const uint8_t *data, size_t len, uint16_t crc) {
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++)
+      crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+  }
+  return crc;
+}
+static uint32_t reference_crc32(const uint8_t *data, size_t len, uint32_t crc) {
+  crc = ~crc;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++)
+      crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320UL : crc >> 1;
+  }
+  return ~crc;
+}
+
+static void test_check_values() {
+  // The "123456789" check values from the CRC catalogue.
+  TEST_CHECK(crc8_dallas(CHECK_DATA, sizeof(CHECK_DATA)) == 0xA1);     // CRC-8/MAXIM-DOW
+  TEST_CHECK(crc8_sensirion(CHECK_DATA, sizeof(CHECK_DATA)) == 0xF7);  // CRC-8/NRSC-5
+  TEST_CHECK(crc16(CHECK_DATA, sizeof(CHECK_DATA)) == 0x4B37);         // CRC-16/MODBUS
+  TEST_CHECK(crc16(CHECK_DATA, sizeof(CHECK_DATA), 0x0000) == 0xBB3D); // CRC-16/ARC
+  TEST_CHECK(crc32(CHECK_DATA, sizeof(CHECK_DATA)) == 0xCBF43926UL);   // CRC-32/ISO-HDLC
+
+  // Example from the Sensirion datasheets.
+  const uint8_t sensirion[] = {0xBE, 0xEF};
+  TEST_CHECK(crc8_sensirion(sensirion, sizeof(sensirion)) == 0x92);
+
+  // Empty data returns the initial value.
+  TEST_CHECK(crc8_dallas(CHECK_DATA, 0) == 0x00);
+  TEST_CHECK(crc16(CHECK_DATA, 0) == 0xFFFF);
+  TEST_CHECK(crc32(CHECK_DATA, 0) == 0);
+}
+
+static void test_reference() {
+  uint8_t data[257];
+  srand(42);
+  for (int round = 0; round < 200; round++) {
+    const size_t len = size_t(rand()) % sizeof(data);
+    for (size_t i = 0; i < len; i++)
+      data[i] = uint8_t(rand());
+
+    TEST_CHECK(crc8_dallas(data, len) == reference_crc8_reflected(data, len, 0x00));
+    TEST_CHECK(crc8_sensirion(data, len) == reference_crc8(data, len, 0xFF));
+    TEST_CHECK(crc16(data, len) == reference_crc16(data, len, 0xFFFF));
+    TEST_CHECK(crc16(data, len, 0x0000) == reference_crc16(data, len, 0x0000));
+    TEST_CHECK(crc32(data, len) == reference_crc32(data, len, 0));
+
+    // Chunked calculation gives the same result.
+    const size_t split = len == 0 ? 0 : size_t(rand()) % len;
+    TEST_CHECK(crc8_dallas(data + split, len - split, crc8_dallas(data, split)) == crc8_dallas(data, len));
+    TEST_CHECK(crc8_sensirion(data + split, len - split, crc8_sensirion(data, split)) == crc8_sensirion(data, len));
+    TEST_CHECK(crc16(data + split, len - split, crc16(data, split)) == crc16(data, len));
+    TEST_CHECK(crc32(data + split, len - split, crc32(data, split)) == crc32(data, len));
+  }
+}
+
+int main() {
+  test_check_values();
+  test_reference();
+  return unit_test_result();
+}
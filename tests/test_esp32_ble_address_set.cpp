@@ -0,0 +1,124 @@
+// Checks that ESP32BLEAddressSet keeps every address reachable when probe chains collide, wrap and get evicted.
+#include <cstdlib>
+#include <map>
+#include <vector>
+
+#include "unit_test.h"
+#include "esphomelib/esp32_ble_address_set.h"
+
+using namespace esphomelib;
+
+static const uint16_t CAPACITY = ESP32_BLE_ADDRESS_SET_SIZE * 3 / 4;
+
+class TestAddressSet : public ESP32BLEAddressSet {
+ public:
+  using ESP32BLEAddressSet::home_;
+};
+
+/// Return the first count addresses after start whose probe sequence starts in one of the given slots.
+static std::vector<uint64_t> addresses_with_home(const std::vector<uint16_t> &homes, size_t count, uint64_t *start) {
+  std::vector<uint64_t> addresses;
+  while (addresses.size() < count) {
+    const uint64_t address = ++*start;
+    for (uint16_t home : homes) {
+      if (TestAddressSet::home_(address) == home) {
+        addresses.push_back(address);
+        break;
+      }
+    }
+  }
+  return addresses;
+}
+
+static void check_model(const ESP32BLEAddressSet &set, const std::map<uint64_t, uint32_t> &model,
+                        const std::vector<uint64_t> &all) {
+  TEST_CHECK(set.size() == model.size());
+  for (uint64_t address : all) {
+    auto it = model.find(address);
+    TEST_CHECK(set.get_last_seen(address) == (it == model.end() ? 0 : it->second));
+  }
+}
+
+static void test_full_wrapping_chains() {
+  TestAddressSet set;
+  std::map<uint64_t, uint32_t> model;
+  uint64_t next = 0;
+
+  // One long chain that starts just before the end of the table and wraps around to the start,
+  // and a second one in the middle of the table that the first one runs into.
+  std::vector<uint64_t> all = addresses_with_home({125, 126, 127}, CAPACITY / 2, &next);
+  std::vector<uint64_t> middle = addresses_with_home({0, 1, 20}, CAPACITY - all.size(), &next);
+  all.insert(all.end(), middle.begin(), middle.end());
+
+  for (size_t i = 0; i < all.size(); i++) {
+    const uint32_t scan = 1 + i % 4;
+    TEST_CHECK(set.mark_seen(all[i], scan) == 0);
+    model[all[i]] = scan;
+  }
+  check_model(set, model, all);
+
+  // The table is at its cap, new addresses are dropped but known ones are still updated.
+  const uint64_t extra = addresses_with_home({126}, 1, &next)[0];
+  TEST_CHECK(set.mark_seen(extra, 5) == 0);
+  TEST_CHECK(set.get_last_seen(extra) == 0);
+  TEST_CHECK(set.size() == CAPACITY);
+  TEST_CHECK(set.mark_seen(all[0], 1) == 1);
+  all.push_back(extra);
+
+  // Evict every entry seen before scan 3, which punches holes all over both chains.
+  set.evict_older_than(3);
+  for (auto it = model.begin(); it != model.end();) {
+    if (it->second < 3)
+      it = model.erase(it);
+    else
+      ++it;
+  }
+  check_model(set, model, all);
+
+  // The freed slots are usable again.
+  TEST_CHECK(set.mark_seen(extra, 5) == 0);
+  model[extra] = 5;
+  check_model(set, model, all);
+
+  set.evict_older_than(6);
+  model.clear();
+  check_model(set, model, all);
+}
+
+static void test_random_rounds() {
+  srand(1);
+  for (int round = 0; round < 200; round++) {
+    TestAddressSet set;
+    std::map<uint64_t, uint32_t> model;
+    uint64_t next = round * 100000ULL;
+    // Few home slots so that most probe chains collide, the last one wraps.
+    const std::vector<uint16_t> homes = {uint16_t(rand() % 128), uint16_t(rand() % 128), 127};
+    const std::vector<uint64_t> all = addresses_with_home(homes, 2 * CAPACITY, &next);
+
+    for (uint32_t scan = 1; scan <= 20; scan++) {
+      for (int i = 0; i < 40; i++) {
+        const uint64_t address = all[rand() % all.size()];
+        auto it = model.find(address);
+        const uint32_t expected = it == model.end() ? 0 : it->second;
+        TEST_CHECK(set.mark_seen(address, scan) == expected);
+        if (it != model.end() || model.size() < CAPACITY)
+          model[address] = scan;
+      }
+      const uint32_t oldest = scan > 3 ? scan - 3 : 0;
+      set.evict_older_than(oldest);
+      for (auto it = model.begin(); it != model.end();) {
+        if (it->second < oldest)
+          it = model.erase(it);
+        else
+          ++it;
+      }
+      check_model(set, model, all);
+    }
+  }
+}
+
+int main() {
+  test_full_wrapping_chains();
+  test_random_rounds();
+  return unit_test_result();
+}
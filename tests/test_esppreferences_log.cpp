@@ -0,0 +1,208 @@
+// Power-loss and compaction tests for LogPreferenceBackend on a FilePreferenceFlash image.
+#include <cstdio>
+#include <cstring>
+#include <map>
+
+#include "unit_test.h"
+#include "esphomelib/esppreferences_log.h"
+
+using namespace esphomelib;
+
+static const char *IMAGE_PATH = "test_esppreferences_log.bin";
+/// Small sectors (12 records each) so that the tests compact often.
+static const size_t SECTOR_SIZE = 256;
+static const size_t NUM_SECTORS = 2;
+static const size_t NUM_KEYS = 4;
+
+/** Forwards to another flash, but loses power after a number of write/erase operations.
+ *
+ * The operation that hits the limit is torn: a write only stores its first 8 bytes and an erase does nothing.
+ * All later operations fail.
+ */
+class PowerLossFlash : public PreferenceFlash {
+ public:
+  explicit PowerLossFlash(PreferenceFlash *flash) : flash_(flash) {}
+
+  void set_budget(int budget) { this->budget_ = budget; }
+  size_t get_erases(size_t sector) const { return this->erases_[sector]; }
+
+  size_t get_sector_size() const override { return this->flash_->get_sector_size(); }
+  size_t get_num_sectors() const override { return this->flash_->get_num_sectors(); }
+  bool read(size_t sector, size_t offset, uint32_t *data, size_t length) override {
+    return this->flash_->read(sector, offset, data, length);
+  }
+  bool write(size_t sector, size_t offset, const uint32_t *data, size_t length) override {
+    if (this->budget_ == 0) {
+      this->budget_ = -2;
+      this->flash_->write(sector, offset, data, std::min(length, size_t(8)));
+      return false;
+    }
+    if (this->budget_ < 0 && this->budget_ != -1)
+      return false;
+    if (this->budget_ > 0)
+      this->budget_--;
+    return this->flash_->write(sector, offset, data, length);
+  }
+  bool erase(size_t sector) override {
+    if (this->budget_ == 0 || this->budget_ == -2) {
+      this->budget_ = -2;
+      return false;
+    }
+    if (this->budget_ > 0)
+      this->budget_--;
+    this->erases_[sector]++;
+    return this->flash_->erase(sector);
+  }
+
+ protected:
+  PreferenceFlash *flash_;
+  /// Number of operations left before the power is lost, -1 for unlimited and -2 once the power is lost.
+  int budget_{-1};
+  size_t erases_[NUM_SECTORS]{};
+};
+
+static ESPPreferenceEntry make_entry(uint32_t key, uint32_t value) {
+  ESPPreferenceEntry entry{};
+  entry.key = key;
+  entry.check = uint16_t(key * 31);
+  entry.type = PREFERENCE_TYPE_UINT32;
+  entry.length = sizeof(uint32_t);
+  memcpy(entry.data, &value, sizeof(uint32_t));
+  return entry;
+}
+
+/// A commit that sets all keys to value, so a partially applied commit would show up as mixed values.
+static std::vector<ESPPreferenceEntry> make_commit(uint32_t value) {
+  std::vector<ESPPreferenceEntry> entries;
+  for (uint32_t key = 1; key <= NUM_KEYS; key++)
+    entries.push_back(make_entry(key, value));
+  return entries;
+}
+
+/// Load all keys from a freshly opened backend, returns -1 if they don't agree on a single value.
+static int64_t load_value() {
+  FilePreferenceFlash flash(IMAGE_PATH, NUM_SECTORS, SECTOR_SIZE);
+  LogPreferenceBackend backend(&flash);
+  TEST_CHECK(backend.begin("test"));
+  int64_t value = -1;
+  for (uint32_t key = 1; key <= NUM_KEYS; key++) {
+    ESPPreferenceEntry entry{};
+    if (!backend.load(key, &entry))
+      return -1;
+    uint32_t v;
+    memcpy(&v, entry.data, sizeof(uint32_t));
+    if (key != 1 && v != value)
+      return -1;
+    value = v;
+  }
+  return value;
+}
+
+/// Cut the power at every single flash operation of a series of commits that crosses several compactions.
+static void test_power_loss() {
+  const uint32_t num_commits = 8;
+  bool reached_end = false;
+  for (int budget = 0; !reached_end; budget++) {
+    remove(IMAGE_PATH);
+    uint32_t last_ok = 0;
+    {
+      FilePreferenceFlash file(IMAGE_PATH, NUM_SECTORS, SECTOR_SIZE);
+      PowerLossFlash flash(&file);
+      LogPreferenceBackend backend(&flash);
+      TEST_CHECK(backend.begin("test"));
+      TEST_CHECK(backend.commit(make_commit(0)));
+
+      flash.set_budget(budget);
+      reached_end = true;
+      for (uint32_t i = 1; i <= num_commits; i++) {
+        if (!backend.commit(make_commit(i))) {
+          reached_end = false;
+          break;
+        }
+        last_ok = i;
+      }
+    }
+
+    // Either the interrupted commit is lost completely, or it made it to flash completely.
+    const int64_t value = load_value();
+    TEST_CHECK(value == last_ok || value == last_ok + 1);
+    if (value != last_ok && value != last_ok + 1)
+      printf("power loss after %d operations: loaded %lld, last successful commit %u\n", budget,
+             (long long) value, last_ok);
+  }
+}
+
+/// Many small commits, checking everything against a model after reopening the image.
+static void test_compaction() {
+  remove(IMAGE_PATH);
+  std::map<uint32_t, uint32_t> model;
+  FilePreferenceFlash file(IMAGE_PATH, NUM_SECTORS, SECTOR_SIZE);
+  PowerLossFlash flash(&file);
+  LogPreferenceBackend backend(&flash);
+  TEST_CHECK(backend.begin("test"));
+
+  const uint32_t num_commits = 200;
+  for (uint32_t i = 0; i < num_commits; i++) {
+    const uint32_t key = 1 + (i * 7) % 9;
+    TEST_CHECK(backend.commit({make_entry(key, i)}));
+    model[key] = i;
+    TEST_CHECK(backend.size() == model.size());
+
+    if (i % 17 == 0) {
+      FilePreferenceFlash reopened_file(IMAGE_PATH, NUM_SECTORS, SECTOR_SIZE);
+      LogPreferenceBackend reopened(&reopened_file);
+      TEST_CHECK(reopened.begin("test"));
+      TEST_CHECK(reopened.size() == model.size());
+      for (auto &kv : model) {
+        ESPPreferenceEntry entry{};
+        TEST_CHECK(reopened.load(kv.first, &entry));
+        uint32_t v;
+        memcpy(&v, entry.data, sizeof(uint32_t));
+        TEST_CHECK(v == kv.second);
+      }
+    }
+  }
+
+  // Each commit takes two records, so a sector with 9 live entries takes one compaction per commit.
+  // The sectors are used round-robin, so they're worn evenly.
+  const size_t erases_0 = flash.get_erases(0);
+  const size_t erases_1 = flash.get_erases(1);
+  TEST_CHECK(erases_0 + erases_1 > 0);
+  TEST_CHECK(erases_0 <= erases_1 + 1 && erases_1 <= erases_0 + 1);
+
+  // Too many entries to fit into one sector are rejected without touching the stored ones.
+  std::vector<ESPPreferenceEntry> too_many;
+  for (uint32_t key = 100; key < 120; key++)
+    too_many.push_back(make_entry(key, key));
+  TEST_CHECK(!backend.commit(too_many));
+  TEST_CHECK(backend.size() == model.size());
+}
+
+/// With a single sector, a compaction would erase the only copy, so the log doesn't start at all.
+static void test_single_sector() {
+  remove(IMAGE_PATH);
+  FilePreferenceFlash flash(IMAGE_PATH, 1, SECTOR_SIZE);
+  LogPreferenceBackend backend(&flash);
+  TEST_CHECK(!backend.begin("test"));
+
+  // The values are still staged in RAM, but nothing is written to flash.
+  global_preferences.set_backend(&backend);
+  global_preferences.begin("test");
+  TEST_CHECK(global_preferences.put_uint32("Light", "state", 42) == sizeof(uint32_t));
+  TEST_CHECK(global_preferences.get_uint32("Light", "state", 0) == 42);
+  TEST_CHECK(!global_preferences.commit());
+  for (size_t offset = 0; offset < SECTOR_SIZE; offset += 4) {
+    uint32_t word = 0;
+    TEST_CHECK(flash.read(0, offset, &word, 4));
+    TEST_CHECK(word == 0xFFFFFFFFUL);
+  }
+  global_preferences.set_backend(nullptr);
+}
+
+int main() {
+  test_power_loss();
+  test_compaction();
+  test_single_sector();
+  remove(IMAGE_PATH);
+  return unit_test_result();
+}
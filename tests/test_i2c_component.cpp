@@ -0,0 +1,106 @@
+// Checks the i2c read/write helpers against a simulated register-file device.
+#include <Arduino.h>
+#include <Wire.h>
+
+#include "unit_test.h"
+#include "esphomelib/i2c_component.h"
+
+using namespace esphomelib;
+
+static const uint8_t ADDRESS = 0x68;
+static uint8_t registers[256];
+
+static void test_read_bytes_16(I2CComponent *i2c) {
+  // Like the accelerometer, temperature and gyro block of the MPU6050: 7 big-endian words.
+  const uint16_t expected[7] = {0x0102, 0xFEDC, 0x8000, 0x00FF, 0x7FFF, 0x1234, 0xABCD};
+  for (int i = 0; i < 7; i++) {
+    registers[0x3B + i * 2] = expected[i] >> 8;
+    registers[0x3B + i * 2 + 1] = expected[i] & 0xFF;
+  }
+
+  uint16_t words[7] = {0};
+  const size_t requests = Wire.get_num_requests();
+  TEST_CHECK(i2c->read_bytes_16(ADDRESS, 0x3B, words, 7));
+  // All words in a single request.
+  TEST_CHECK(Wire.get_num_requests() == requests + 1);
+  for (int i = 0; i < 7; i++)
+    TEST_CHECK(words[i] == expected[i]);
+
+  uint16_t word = 0;
+  TEST_CHECK(i2c->read_byte_16(ADDRESS, 0x3D, &word));
+  TEST_CHECK(word == expected[1]);
+}
+
+static void test_read_block(I2CComponent *i2c) {
+  for (int i = 0; i < 256; i++)
+    registers[i] = uint8_t(i * 7 + 3);
+
+  // Longer than the Wire buffer, so it's split into multiple requests.
+  uint8_t block[100];
+  const size_t requests = Wire.get_num_requests();
+  TEST_CHECK(i2c->read_block(ADDRESS, 0x10, block, sizeof(block)));
+  TEST_CHECK(Wire.get_num_requests() == requests + (sizeof(block) + BUFFER_LENGTH - 1) / BUFFER_LENGTH);
+  for (size_t i = 0; i < sizeof(block); i++)
+    TEST_CHECK(block[i] == registers[0x10 + i]);
+
+  uint8_t bytes[4];
+  TEST_CHECK(i2c->read_bytes(ADDRESS, 0x80, bytes, 4));
+  for (int i = 0; i < 4; i++)
+    TEST_CHECK(bytes[i] == registers[0x80 + i]);
+}
+
+static void test_write(I2CComponent *i2c) {
+  const uint16_t words[2] = {0xBEEF, 0x0102};
+  TEST_CHECK(i2c->write_bytes_16(ADDRESS, 0x20, words, 2));
+  TEST_CHECK(registers[0x20] == 0xBE && registers[0x21] == 0xEF);
+  TEST_CHECK(registers[0x22] == 0x01 && registers[0x23] == 0x02);
+
+  TEST_CHECK(i2c->write_byte(ADDRESS, 0x30, 0x5A));
+  uint8_t byte = 0;
+  TEST_CHECK(i2c->read_byte(ADDRESS, 0x30, &byte));
+  TEST_CHECK(byte == 0x5A);
+}
+
+static void test_missing_device(I2CComponent *i2c) {
+  uint16_t word;
+  TEST_CHECK(!i2c->read_byte_16(0x42, 0x00, &word));
+  uint8_t block[40];
+  TEST_CHECK(!i2c->read_block(0x42, 0x00, block, sizeof(block)));
+  const I2CDeviceStats *stats = i2c->get_stats(0x42);
+  TEST_CHECK(stats != nullptr && stats->failures == 2);
+}
+
+static void test_transaction(I2CComponent *i2c) {
+  registers[0x50] = 0x11;
+  registers[0x51] = 0x22;
+  bool done = false;
+  bool success = false;
+  std::vector<uint8_t> result;
+  i2c->enqueue(ADDRESS, I2CTransaction().write_byte(0x40, 0x01).wait(5).write(0x50).read(2).then(
+      [&](bool s, const std::vector<uint8_t> &data) {
+    done = true;
+    success = s;
+    result = data;
+  }));
+
+  i2c->loop();
+  TEST_CHECK(!done);
+  TEST_CHECK(registers[0x40] == 0x01);
+  host_time_advance_us(5000);
+  i2c->loop();
+  TEST_CHECK(done && success);
+  TEST_CHECK(result.size() == 2 && result[0] == 0x11 && result[1] == 0x22);
+}
+
+int main() {
+  Wire.add_device(ADDRESS, registers);
+  I2CComponent i2c(21, 22);
+  i2c.setup();
+
+  test_read_bytes_16(&i2c);
+  test_read_block(&i2c);
+  test_write(&i2c);
+  test_missing_device(&i2c);
+  test_transaction(&i2c);
+  return unit_test_result();
+}
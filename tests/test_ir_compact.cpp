@@ -0,0 +1,83 @@
+// Checks the size of compact IR codes and that they decode back to the raw timings.
+#include <cstdlib>
+#include <vector>
+
+#include "unit_test.h"
+#include "esphomelib/ir_protocol.h"
+
+using namespace esphomelib;
+using namespace esphomelib::ir;
+
+/// An AC code as captured from a remote: header, 98 bits, stop mark and gap, with ±20µs of capture jitter.
+static std::vector<int16_t> make_ac_code() {
+  std::vector<int16_t> raw;
+  uint32_t seed = 7;
+  auto jitter = [&seed]() {
+    seed = seed * 1103515245 + 12345;
+    return int16_t((seed >> 16) % 41) - 20;
+  };
+  raw.push_back(3500 + jitter());
+  raw.push_back(-1750 + jitter());
+  for (int i = 0; i < 98; i++) {
+    raw.push_back(430 + jitter());
+    raw.push_back(((i * 37) % 5 < 2 ? -1300 : -430) + jitter());
+  }
+  raw.push_back(430 + jitter());
+  raw.push_back(-10000 + jitter());
+  return raw;
+}
+
+static void test_ac_code_size() {
+  const std::vector<int16_t> raw = make_ac_code();
+  TEST_CHECK(raw.size() == 200);
+
+  std::vector<int16_t> durations;
+  std::vector<uint8_t> indices;
+  TEST_CHECK(encode_compact(raw.data(), raw.size(), &durations, &indices));
+  TEST_CHECK(durations.size() == 6);
+
+  // 3 bits per timing: 12 + 75 bytes instead of 400.
+  const size_t compact_size = durations.size() * sizeof(int16_t) + indices.size();
+  TEST_CHECK(indices.size() == 75);
+  TEST_CHECK(compact_size == 87);
+  TEST_CHECK(compact_size * 4 < raw.size() * sizeof(int16_t));
+  printf("AC code: %u bytes raw, %u bytes compact\n", unsigned(raw.size() * sizeof(int16_t)),
+         unsigned(compact_size));
+
+  const CompactCode code{38000, durations.data(), uint8_t(durations.size()), indices.data(), uint16_t(raw.size())};
+  TEST_CHECK(code.get_bits_per_index() == 3);
+  for (uint16_t i = 0; i < code.length; i++) {
+    // Every timing keeps its sign and is within the capture jitter of the original.
+    const int16_t value = code.get(i);
+    TEST_CHECK((value > 0) == (raw[i] > 0));
+    TEST_CHECK(std::abs(value - raw[i]) <= 40);
+  }
+}
+
+static void test_exact_round_trip() {
+  // Index widths that don't divide a byte, so indices span byte boundaries.
+  for (int num_durations = 2; num_durations <= 40; num_durations += 3) {
+    std::vector<int16_t> raw;
+    for (int i = 0; i < 97; i++) {
+      // Distinct durations 25% apart, alternating between marks and spaces.
+      int16_t duration = 100;
+      for (int j = ((i * 7) % num_durations) / 2; j > 0; j--)
+        duration = int16_t(duration * 5 / 4);
+      raw.push_back(i % 2 == 0 ? duration : int16_t(-duration));
+    }
+
+    std::vector<int16_t> durations;
+    std::vector<uint8_t> indices;
+    TEST_CHECK(encode_compact(raw.data(), raw.size(), &durations, &indices));
+    const CompactCode code{38000, durations.data(), uint8_t(durations.size()), indices.data(), uint16_t(raw.size())};
+    TEST_CHECK(indices.size() == (raw.size() * code.get_bits_per_index() + 7) / 8);
+    for (uint16_t i = 0; i < code.length; i++)
+      TEST_CHECK(code.get(i) == raw[i]);
+  }
+}
+
+int main() {
+  test_ac_code_size();
+  test_exact_round_trip();
+  return unit_test_result();
+}
@@ -0,0 +1,214 @@
+// Decodes timing traces like a demodulating receiver module records them, split into frames by the edge builder.
+#include <cstdlib>
+#include <vector>
+
+#include "unit_test.h"
+#include "esphomelib/ir_protocol.h"
+
+using namespace esphomelib;
+using namespace esphomelib::ir;
+
+/// Records the edge times of a signal, with marks stretched and spaces shortened like by a TSOP38238.
+class Trace {
+ public:
+  void mark(uint32_t duration_us) {
+    this->edge_();
+    this->time_ += duration_us + 80 + this->jitter_();
+  }
+  void space(uint32_t duration_us) {
+    this->edge_();
+    this->time_ += duration_us - 80 + this->jitter_();
+  }
+  void item(uint32_t mark_us, uint32_t space_us) {
+    this->mark(mark_us);
+    this->space(space_us);
+  }
+  /// The stop mark, or the last mark of a frame: there's no edge until the next frame.
+  void last_mark(uint32_t duration_us) {
+    this->mark(duration_us);
+    this->edge_();
+  }
+  void idle(uint32_t duration_us) {
+    this->time_ += duration_us;
+  }
+
+  const std::vector<uint32_t> &get_edges() const {
+    return this->edges_;
+  }
+  uint32_t get_time() const {
+    return this->time_;
+  }
+
+ protected:
+  void edge_() {
+    this->edges_.push_back(this->time_);
+  }
+  uint32_t jitter_() {
+    // Deterministic ±30µs.
+    this->seed_ = this->seed_ * 1103515245 + 12345;
+    return (this->seed_ >> 16) % 61 - 30;
+  }
+
+  /// Start close to the micros() overflow, frames have to be split correctly across it.
+  uint32_t time_{0xFFFF0000};
+  uint32_t seed_{42};
+  std::vector<uint32_t> edges_;
+};
+
+static void add_space_bits(Trace *trace, uint32_t value, uint8_t nbits, uint32_t mark_us, uint32_t one_us,
+                           uint32_t zero_us) {
+  for (uint32_t mask = 1UL << (nbits - 1); mask; mask >>= 1)
+    trace->item(mark_us, value & mask ? one_us : zero_us);
+}
+
+/// Like SendData::from_nec.
+static void add_nec(Trace *trace, uint16_t address, uint16_t command) {
+  trace->item(nec::HEADER_HIGH_US, nec::HEADER_LOW_US);
+  add_space_bits(trace, address, 16, nec::BIT_HIGH_US, nec::BIT_ONE_LOW_US, nec::BIT_ZERO_LOW_US);
+  add_space_bits(trace, command, 16, nec::BIT_HIGH_US, nec::BIT_ONE_LOW_US, nec::BIT_ZERO_LOW_US);
+  trace->last_mark(nec::BIT_HIGH_US);
+}
+/// Like SendData::from_lg, which ends with a stop mark.
+static void add_lg(Trace *trace, uint32_t data, bool stop_mark = true) {
+  trace->item(lg::HEADER_HIGH_US, lg::HEADER_LOW_US);
+  for (uint32_t mask = 1UL << 27; mask; mask >>= 1) {
+    if (mask == 1 && !stop_mark) {
+      trace->last_mark(lg::BIT_HIGH_US);
+      return;
+    }
+    trace->item(lg::BIT_HIGH_US, data & mask ? lg::BIT_ONE_LOW_US : lg::BIT_ZERO_LOW_US);
+  }
+  trace->last_mark(lg::BIT_HIGH_US);
+}
+/// Like SendData::from_sony, the space after the last bit merges with the idle time.
+static void add_sony(Trace *trace, uint32_t data, uint8_t nbits) {
+  trace->item(sony::HEADER_HIGH_US, sony::HEADER_LOW_US);
+  for (uint32_t mask = 1UL << (nbits - 1); mask; mask >>= 1) {
+    const uint32_t mark = data & mask ? sony::BIT_ONE_HIGH_US : sony::BIT_ZERO_HIGH_US;
+    if (mask == 1)
+      trace->last_mark(mark);
+    else
+      trace->item(mark, sony::BIT_LOW_US);
+  }
+}
+/// Like SendData::from_panasonic.
+static void add_panasonic(Trace *trace, uint16_t address, uint32_t data) {
+  trace->item(panasonic::HEADER_HIGH_US, panasonic::HEADER_LOW_US);
+  add_space_bits(trace, address, 16, panasonic::BIT_HIGH_US, panasonic::BIT_ONE_LOW_US, panasonic::BIT_ZERO_LOW_US);
+  add_space_bits(trace, data, 32, panasonic::BIT_HIGH_US, panasonic::BIT_ONE_LOW_US, panasonic::BIT_ZERO_LOW_US);
+  trace->last_mark(panasonic::BIT_HIGH_US);
+}
+
+/// Feed the edges of a trace to a builder in batches of batch_size, like the receiver loop, and decode all frames.
+static std::vector<DecodedData> receive(const Trace &trace, size_t batch_size = 7) {
+  EdgeFrameBuilder builder;
+  builder.set_idle_us(10000);
+  std::vector<DecodedData> decoded;
+  auto process = [&]() {
+    DecodedData data{};
+    const std::vector<int16_t> &frame = builder.get_frame();
+    // Frames end with a mark, the space after it is the idle time.
+    TEST_CHECK(frame.size() % 2 == 1);
+    if (decode(frame.data(), frame.size(), &data))
+      decoded.push_back(data);
+    else
+      decoded.push_back(DecodedData{Protocol(-1), 0, 0, 0});
+  };
+
+  const std::vector<uint32_t> &edges = trace.get_edges();
+  for (size_t i = 0; i < edges.size(); i += batch_size) {
+    for (size_t j = i; j < i + batch_size && j < edges.size(); j++) {
+      if (builder.add_edge(edges[j]))
+        process();
+    }
+    // Edges in the next batch are newer than the time the loop read.
+    const uint32_t now = i + batch_size < edges.size() ? edges[i + batch_size] - 1 : trace.get_time();
+    if (builder.finish(now))
+      process();
+  }
+  return decoded;
+}
+
+static void test_protocols() {
+  Trace trace;
+  add_nec(&trace, 0x20DF, 0x10EF);
+  trace.idle(40000);
+  add_lg(&trace, 0x88C0051);
+  trace.idle(40000);
+  add_sony(&trace, 0xA90, 12);
+  trace.idle(25000);
+  add_sony(&trace, 0x5A5A, 15);
+  trace.idle(25000);
+  add_sony(&trace, 0xF1234, 20);
+  trace.idle(25000);
+  add_panasonic(&trace, 0x4004, 0x0100BCBD);
+  trace.idle(40000);
+
+  const std::vector<DecodedData> decoded = receive(trace);
+  TEST_CHECK(decoded.size() == 6);
+  if (decoded.size() != 6)
+    return;
+  TEST_CHECK(decoded[0].protocol == PROTOCOL_NEC && decoded[0].address == 0x20DF && decoded[0].data == 0x10EF);
+  TEST_CHECK(decoded[1].protocol == PROTOCOL_LG && decoded[1].data == 0x88C0051 && decoded[1].nbits == 28);
+  TEST_CHECK(decoded[2].protocol == PROTOCOL_SONY && decoded[2].data == 0xA90 && decoded[2].nbits == 12);
+  TEST_CHECK(decoded[3].protocol == PROTOCOL_SONY && decoded[3].data == 0x5A5A && decoded[3].nbits == 15);
+  TEST_CHECK(decoded[4].protocol == PROTOCOL_SONY && decoded[4].data == 0xF1234 && decoded[4].nbits == 20);
+  TEST_CHECK(decoded[5].protocol == PROTOCOL_PANASONIC && decoded[5].address == 0x4004 &&
+      decoded[5].data == 0x0100BCBD);
+}
+
+static void test_back_to_back_frames() {
+  // A held button repeats frames with just over the idle time in between, all edges arrive in one batch.
+  Trace trace;
+  add_nec(&trace, 0x00FF, 0x807F);
+  trace.idle(11000);
+  add_nec(&trace, 0x00FF, 0x40BF);
+  trace.idle(11000);
+  add_sony(&trace, 0x123, 12);
+  trace.idle(11000);
+
+  const std::vector<DecodedData> decoded = receive(trace, 1000);
+  TEST_CHECK(decoded.size() == 3);
+  if (decoded.size() != 3)
+    return;
+  TEST_CHECK(decoded[0].protocol == PROTOCOL_NEC && decoded[0].data == 0x807F);
+  TEST_CHECK(decoded[1].protocol == PROTOCOL_NEC && decoded[1].data == 0x40BF);
+  TEST_CHECK(decoded[2].protocol == PROTOCOL_SONY && decoded[2].data == 0x123);
+}
+
+static void test_lg_stop_mark() {
+  // Without the stop mark, the space of the last bit can't be told apart from the idle time.
+  Trace trace;
+  add_lg(&trace, 0x88C0051, false);
+  trace.idle(40000);
+  const std::vector<DecodedData> decoded = receive(trace);
+  TEST_CHECK(decoded.size() == 1 && decoded[0].protocol != PROTOCOL_LG);
+}
+
+static void test_glitches() {
+  EdgeFrameBuilder builder;
+  builder.set_idle_us(10000);
+  // A single edge isn't a frame.
+  TEST_CHECK(!builder.add_edge(1000));
+  TEST_CHECK(!builder.finish(20000));
+  // Nor is one after lost edges.
+  TEST_CHECK(!builder.add_edge(30000));
+  TEST_CHECK(!builder.add_edge(30500));
+  builder.reset();
+  TEST_CHECK(!builder.add_edge(31000));
+  TEST_CHECK(!builder.finish(50000));
+  // A mark followed by the idle time is a frame of its own.
+  TEST_CHECK(!builder.add_edge(60000));
+  TEST_CHECK(!builder.add_edge(60000 + 9000));
+  TEST_CHECK(!builder.finish(60000 + 9000 + 9999));
+  TEST_CHECK(builder.finish(60000 + 9000 + 10000));
+  TEST_CHECK(builder.get_frame().size() == 1 && builder.get_frame()[0] == 9000);
+}
+
+int main() {
+  test_protocols();
+  test_back_to_back_frames();
+  test_lg_stop_mark();
+  test_glitches();
+  return unit_test_result();
+}
@@ -0,0 +1,140 @@
+// Checks the 16-bit fixed-point LightColorValues and transitions against the float implementation they replaced.
+#include <cmath>
+
+#include "Arduino.h"
+#include "unit_test.h"
+#include "esphomelib/light/light_color_values.h"
+#include "esphomelib/light/light_transformer.h"
+
+using namespace esphomelib;
+using namespace esphomelib::light;
+
+/// One step of the 16-bit fixed-point representation.
+static const double LSB = 1.0 / 65535.0;
+
+/// round(a * b / 65535) in exact arithmetic.
+static uint16_t reference_mul(uint32_t a, uint32_t b) {
+  return uint16_t(llround(double(a) * b / 65535.0));
+}
+
+/// round(start + (end - start) * completion / 65535) in exact arithmetic, rounding the step symmetrically.
+static uint16_t reference_lerp(uint16_t start, uint16_t end, uint16_t completion) {
+  if (end < start)
+    return start - reference_mul(start - end, completion);
+  return start + reference_mul(end - start, completion);
+}
+
+static LightColorValues make_raw(uint16_t value) {
+  const float f = LightColorValues::raw_to_float(value);
+  return LightColorValues(f, f, f, f, f, f);
+}
+
+/// The float smootherstep transition of the previous implementation.
+static float float_smootherstep(float x) {
+  return x * x * x * (x * (x * 6.0f - 15.0f) + 10.0f);
+}
+
+class TestTransition : public LightTransitionTransformer {
+ public:
+  using LightTransitionTransformer::LightTransitionTransformer;
+  using LightTransitionTransformer::get_progress_raw;
+};
+
+static void test_conversion() {
+  // Every raw value survives a round trip through float exactly.
+  for (uint32_t raw = 0; raw <= 0xFFFF; raw++)
+    TEST_CHECK(LightColorValues::float_to_raw(LightColorValues::raw_to_float(raw)) == raw);
+
+  // Floats are rounded to the nearest step and clamped. The rounding is done in single precision, which leaves
+  // 8 fractional bits at the top of the range, so values within 2^-8 of a tie may round either way.
+  for (int i = 0; i <= 100000; i++) {
+    const float value = i / 100000.0f;
+    const double exact = double(value) * 65535.0;
+    TEST_CHECK(std::fabs(LightColorValues::float_to_raw(value) - exact) <= 0.5 + 1.0 / 256.0);
+  }
+  TEST_CHECK(LightColorValues::float_to_raw(-0.5f) == 0);
+  TEST_CHECK(LightColorValues::float_to_raw(1.5f) == 0xFFFF);
+  TEST_CHECK(LightColorValues::float_to_raw(NAN) == 0);
+  TEST_CHECK(LightColorValues::raw_to_float(0xFFFF) == 1.0f);
+  TEST_CHECK(LightColorValues::raw_to_float(0) == 0.0f);
+}
+
+static void test_as_raw_is_exact() {
+  // state * brightness (and the products with the color channels) are rounded exactly.
+  for (uint32_t a = 0; a <= 0xFFFF; a += 251) {
+    for (uint32_t b = 0; b <= 0xFFFF; b += 241) {
+      LightColorValues v(LightColorValues::raw_to_float(a), LightColorValues::raw_to_float(b), 1.0f, 1.0f, 1.0f, 1.0f);
+      uint16_t brightness;
+      v.as_brightness_raw(&brightness);
+      TEST_CHECK(brightness == reference_mul(a, b));
+
+      // The float getters see the same value up to float precision.
+      float brightness_f;
+      v.as_brightness(&brightness_f);
+      TEST_CHECK(std::fabs(brightness_f - brightness * LSB) <= LSB);
+    }
+  }
+}
+
+static void test_lerp_raw_is_exact() {
+  for (uint32_t start = 0; start <= 0xFFFF; start += 4093) {
+    for (uint32_t end = 0; end <= 0xFFFF; end += 4099) {
+      for (uint32_t completion = 0; completion <= 0xFFFF; completion += 127) {
+        LightColorValues v = LightColorValues::lerp_raw(make_raw(start), make_raw(end), completion);
+        TEST_CHECK(LightColorValues::float_to_raw(v.get_red()) == reference_lerp(start, end, completion));
+      }
+      // The end points are hit exactly.
+      TEST_CHECK(LightColorValues::lerp_raw(make_raw(start), make_raw(end), 0) == make_raw(start));
+      TEST_CHECK(LightColorValues::lerp_raw(make_raw(start), make_raw(end), 0xFFFF) == make_raw(end));
+    }
+  }
+}
+
+static void test_lerp_matches_float() {
+  // The float lerp of the previous implementation. Rounding the start value, the completion and the result to
+  // 16 bits each contributes at most half a step.
+  for (int i = 0; i <= 20; i++) {
+    for (int j = 0; j <= 20; j++) {
+      const float start = i / 20.0f, end = j / 20.0f;
+      for (int k = 0; k <= 1000; k++) {
+        const float completion = k / 1000.0f;
+        LightColorValues v = LightColorValues::lerp(LightColorValues(start, start, start, start, start, start),
+                                                    LightColorValues(end, end, end, end, end, end), completion);
+        const float expected = start + (end - start) * completion;
+        TEST_CHECK(std::fabs(v.get_brightness() - expected) <= 1.5 * LSB);
+      }
+    }
+  }
+}
+
+static void test_transition_matches_float() {
+  const LightColorValues start(1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+  const LightColorValues end(1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f);
+  const uint32_t lengths[] = {1, 250, 1000, 65535, 300000};
+  for (uint32_t length : lengths) {
+    const uint32_t start_time = millis();
+    TestTransition transition(start_time, length, start, end);
+    const uint32_t step = length / 500 + 1;
+    for (uint32_t elapsed = 0; elapsed <= length; elapsed += step) {
+      const float progress = float(elapsed) / float(length);
+      const float expected = float_smootherstep(progress);
+      const float actual = transition.get_values().get_brightness();
+      // Progress is quantized to 16 bits and the polynomial is evaluated in 16-bit fixed-point, the
+      // result stays well below one 8-bit output step (257 LSB).
+      TEST_CHECK(std::fabs(actual - expected) <= 16 * LSB);
+      host_time_advance_us(step * 1000);
+    }
+    TEST_CHECK(transition.get_progress_raw() == 0xFFFF);
+    TEST_CHECK(transition.get_values() == end);
+    TEST_CHECK(transition.is_finished());
+  }
+}
+
+int main() {
+  test_conversion();
+  test_as_raw_is_exact();
+  test_lerp_raw_is_exact();
+  test_lerp_matches_float();
+  test_transition_matches_float();
+  return unit_test_result();
+}
@@ -0,0 +1,60 @@
+// Checks that temporal dithering reproduces the 8.8 fixed-point values on average.
+#include <cstdlib>
+#include <vector>
+
+#include "unit_test.h"
+#include "esphomelib/light/light_dithering.h"
+
+using namespace esphomelib::light;
+
+static void test_average(size_t len) {
+  std::vector<uint16_t> src(len);
+  std::vector<uint8_t> error(len);
+  std::vector<uint8_t> dst(len);
+  std::vector<uint32_t> sum(len);
+  uint32_t seed = uint32_t(len);
+  for (size_t i = 0; i < len; i++) {
+    seed = seed * 1103515245 + 12345;
+    src[i] = uint16_t((seed >> 8) % 65281);
+    // Seeded like FastLEDLightOutputComponent does it.
+    error[i] = uint8_t(i * 167);
+  }
+  src[0] = 0;
+  src[len - 1] = 65280;
+
+  for (uint32_t frame = 1; frame <= 512; frame++) {
+    dither_range(src.data(), error.data(), dst.data(), len);
+    for (size_t i = 0; i < len; i++) {
+      sum[i] += dst[i];
+      // The accumulated output never drifts more than one 8-bit step from the input.
+      const int32_t diff = int32_t(frame * src[i]) - int32_t(sum[i] * 256);
+      TEST_CHECK(diff > -256 && diff < 256);
+      // And each frame is one of the two neighboring 8-bit values.
+      TEST_CHECK(dst[i] == src[i] >> 8 || dst[i] == (src[i] >> 8) + 1);
+    }
+    // Every 256 frames, the average is exact.
+    if (frame % 256 == 0) {
+      for (size_t i = 0; i < len; i++)
+        TEST_CHECK(sum[i] * 256 == frame * src[i]);
+    }
+  }
+}
+
+static void test_pending() {
+  // Values without a fractional part are done after one frame.
+  uint16_t src[3] = {0, 0x1200, 0xFF00};
+  uint8_t error[3] = {0, 0, 0};
+  uint8_t dst[3];
+  TEST_CHECK(!dither_range(src, error, dst, 3));
+  TEST_CHECK(dst[0] == 0 && dst[1] == 0x12 && dst[2] == 0xFF);
+  src[1] = 0x1280;
+  TEST_CHECK(dither_range(src, error, dst, 3));
+}
+
+int main() {
+  // Lengths around typical vector widths, so that any remainder loop is covered too.
+  for (size_t len : {1, 3, 15, 16, 17, 3000})
+    test_average(len);
+  test_pending();
+  return unit_test_result();
+}
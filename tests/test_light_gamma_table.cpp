@@ -0,0 +1,38 @@
+// Checks the error bound of the gamma correction lookup table against powf.
+#include <cmath>
+
+#include "unit_test.h"
+#include "esphomelib/light/light_color_values.h"
+
+using namespace esphomelib::light;
+
+/// One 8-bit output step in the 16-bit fixed-point representation.
+static const double STEP_8BIT = 65535.0 / 255.0;
+
+static void test_error_bound(float gamma) {
+  LightGammaTable table;
+  table.compute(gamma);
+
+  double max_error = 0.0;
+  uint16_t last = 0;
+  for (uint32_t raw = 0; raw <= 0xFFFF; raw++) {
+    const uint16_t actual = table.correct(raw);
+    const double expected = std::pow(raw / 65535.0, double(gamma)) * 65535.0;
+    max_error = std::max(max_error, std::fabs(actual - expected));
+    // The curve stays monotonic.
+    TEST_CHECK(actual >= last);
+    last = actual;
+  }
+  // The end points are exact.
+  TEST_CHECK(table.correct(0) == 0);
+  TEST_CHECK(table.correct(0xFFFF) == 0xFFFF);
+  // Well below one 8-bit output step for the usual gamma values.
+  TEST_CHECK(max_error <= STEP_8BIT / 40.0);
+  printf("gamma %.1f: max error %.2f LSB (%.4f 8-bit steps)\n", gamma, max_error, max_error / STEP_8BIT);
+}
+
+int main() {
+  for (float gamma = 1.0f; gamma <= 3.51f; gamma += 0.1f)
+    test_error_bound(gamma);
+  return unit_test_result();
+}
@@ -0,0 +1,116 @@
+// Checks when LightState writes its values to the preferences.
+#include <Arduino.h>
+#include <map>
+
+#include "unit_test.h"
+#include "esphomelib/esppreferences.h"
+#include "esphomelib/light/light_state.h"
+
+using namespace esphomelib;
+using namespace esphomelib::light;
+
+/// Keeps the preferences in RAM and counts the commits, each of which would be a flash write on a node.
+class CountingBackend : public ESPPreferenceBackend {
+ public:
+  bool begin(const std::string &name) override {
+    return true;
+  }
+  bool load(uint32_t key, ESPPreferenceEntry *entry) override {
+    auto it = this->entries_.find(key);
+    if (it == this->entries_.end())
+      return false;
+    *entry = it->second;
+    return true;
+  }
+  bool commit(const std::vector<ESPPreferenceEntry> &entries) override {
+    for (const ESPPreferenceEntry &entry : entries)
+      this->entries_[entry.key] = entry;
+    this->commits_++;
+    return true;
+  }
+
+  int get_commits() const {
+    return this->commits_;
+  }
+
+ protected:
+  std::map<uint32_t, ESPPreferenceEntry> entries_;
+  int commits_{0};
+};
+
+class RGBOutput : public LightOutput {
+ public:
+  LightTraits get_traits() override {
+    return {true, true, false};
+  }
+  void write_state(LightState *state) override {
+    state->current_values_as_rgb(&this->red, &this->green, &this->blue);
+    this->writes++;
+  }
+
+  float red{0}, green{0}, blue{0};
+  int writes{0};
+};
+
+/// Run the light and the preferences like Application::loop() for the given time.
+static void run_for(LightState *state, uint32_t ms) {
+  for (uint32_t t = 0; t < ms; t += 16) {
+    host_time_advance_us(16000);
+    state->loop_();
+    global_preferences.loop();
+  }
+}
+
+static void test_effect_is_not_saved() {
+  CountingBackend backend;
+  global_preferences.set_backend(&backend);
+  global_preferences.begin("test");
+
+  RGBOutput output;
+  LightState state("Light", &output);
+  state.setup_();
+  run_for(&state, 10000);
+  const int initial_commits = backend.get_commits();
+
+  // A user command is saved once, after the save delay.
+  LightColorValues red = state.get_remote_values();
+  red.set_state(1.0f);
+  red.set_brightness(1.0f);
+  red.set_red(1.0f);
+  red.set_green(0.0f);
+  red.set_blue(0.0f);
+  state.start_transition(red, 1000);
+  run_for(&state, 10000);
+  TEST_CHECK(backend.get_commits() == initial_commits + 1);
+
+  // The random effect changes the color every 10 seconds, none of which is written to flash.
+  state.start_effect("Random");
+  TEST_CHECK(state.get_effect_name() == "Random");
+  int color_changes = 0;
+  for (int i = 0; i < 30; i++) {
+    const float last_red = output.red, last_green = output.green, last_blue = output.blue;
+    run_for(&state, 10000);
+    if (output.red != last_red || output.green != last_green || output.blue != last_blue)
+      color_changes++;
+  }
+  TEST_CHECK(color_changes >= 25);
+  TEST_CHECK(backend.get_commits() == initial_commits + 1);
+
+  // Turning the light off stops the effect and is saved again.
+  LightColorValues off = state.get_remote_values();
+  off.set_state(0.0f);
+  state.start_transition(off, 1000);
+  TEST_CHECK(state.get_effect_name() == "None");
+  run_for(&state, 10000);
+  TEST_CHECK(backend.get_commits() == initial_commits + 2);
+
+  LightColorValues loaded;
+  loaded.load_from_preferences("Light");
+  TEST_CHECK(loaded.get_state() == 0.0f);
+  global_preferences.set_backend(nullptr);
+}
+
+int main() {
+  test_effect_is_not_saved();
+  return unit_test_result();
+}
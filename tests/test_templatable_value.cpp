@@ -0,0 +1,121 @@
+// Checks copying, moving and destroying TemplatableValue in each of its states, and that it stays small.
+#include <memory>
+#include <string>
+
+#include "unit_test.h"
+#include "esphomelib/automation.h"
+#include "esphomelib/helpers.h"
+
+using namespace esphomelib;
+
+using StringValue = TemplatableValue<std::string, int>;
+
+// A constant only costs the value and the tag (padded to the alignment of the lambda pointer).
+static_assert(sizeof(TemplatableValue<float, float>) == 2 * sizeof(void *), "float constant isn't stored inline");
+static_assert(sizeof(TemplatableValue<std::string, NoArg>) == sizeof(std::string) + sizeof(void *),
+              "string constant isn't stored inline");
+static_assert(sizeof(TemplatableValue<float, float>) < sizeof(std::function<float(float)>),
+              "TemplatableValue is larger than the std::function it replaced");
+static_assert(sizeof(RangeCondition) == sizeof(void *) + 2 * sizeof(TemplatableValue<float, float>),
+              "RangeCondition has grown");
+
+enum State { EMPTY, VALUE, LAMBDA };
+
+/// Each live copy of a lambda holds a reference to this, so its use count tells leaks and double frees apart.
+static std::shared_ptr<int> token = std::make_shared<int>(0);
+
+static StringValue make(State state) {
+  switch (state) {
+    case VALUE:
+      // Long enough to be stored on the heap, so that a missing destructor call leaks.
+      return StringValue(std::string("a constant that doesn't fit into the small string buffer"));
+    case LAMBDA: {
+      std::shared_ptr<int> captured = token;
+      return StringValue(std::function<std::string(int)>([captured](int x) { return "lambda " + std::to_string(x); }));
+    }
+    default:
+      return StringValue();
+  }
+}
+
+static bool is(const StringValue &value, State state) {
+  switch (state) {
+    case VALUE:
+      return value.has_value() && value.value(1) == "a constant that doesn't fit into the small string buffer";
+    case LAMBDA:
+      return value.has_value() && value.value(2) == "lambda 2";
+    default:
+      return !value.has_value() && value.value(3).empty();
+  }
+}
+
+static void test_empty() {
+  StringValue empty;
+  TEST_CHECK(!empty.has_value());
+  TEST_CHECK(empty.value(0) == std::string());
+  TemplatableValue<float, float> empty_float;
+  TEST_CHECK(empty_float.value(1.0f) == 0.0f);
+  // An empty std::function gives an empty value instead of throwing once it's evaluated.
+  StringValue empty_lambda(std::function<std::string(int)>{});
+  TEST_CHECK(!empty_lambda.has_value());
+  TEST_CHECK(empty_lambda.value(0).empty());
+}
+
+static void test_construct() {
+  for (State from : {EMPTY, VALUE, LAMBDA}) {
+    StringValue source = make(from);
+    StringValue copy(source);
+    TEST_CHECK(is(copy, from));
+    TEST_CHECK(is(source, from));
+
+    StringValue moved(std::move(copy));
+    TEST_CHECK(is(moved, from));
+    // The moved-from value gave away its lambda, a constant is only moved from.
+    if (from != VALUE)
+      TEST_CHECK(!copy.has_value());
+  }
+  TEST_CHECK(token.use_count() == 1);
+}
+
+static void test_assign() {
+  for (State to : {EMPTY, VALUE, LAMBDA}) {
+    for (State from : {EMPTY, VALUE, LAMBDA}) {
+      StringValue source = make(from);
+      StringValue copy = make(to);
+      copy = source;
+      TEST_CHECK(is(copy, from));
+      TEST_CHECK(is(source, from));
+
+      StringValue moved = make(to);
+      moved = std::move(copy);
+      TEST_CHECK(is(moved, from));
+      if (from != VALUE)
+        TEST_CHECK(!copy.has_value());
+
+      // The moved-from value can be assigned again.
+      copy = make(to);
+      TEST_CHECK(is(copy, to));
+    }
+  }
+  TEST_CHECK(token.use_count() == 1);
+}
+
+static void test_self_assign() {
+  for (State state : {EMPTY, VALUE, LAMBDA}) {
+    StringValue value = make(state);
+    StringValue &alias = value;
+    value = alias;
+    TEST_CHECK(is(value, state));
+    value = std::move(alias);
+    TEST_CHECK(is(value, state));
+  }
+  TEST_CHECK(token.use_count() == 1);
+}
+
+int main() {
+  test_empty();
+  test_construct();
+  test_assign();
+  test_self_assign();
+  return unit_test_result();
+}
@@ -0,0 +1,28 @@
+// A minimal assertion helper for the host tests, each test is a plain executable run by ctest.
+#ifndef ESPHOMELIB_TESTS_UNIT_TEST_H
+#define ESPHOMELIB_TESTS_UNIT_TEST_H
+
+#include <cstdio>
+
+inline int &unit_test_failures() {
+  static int failures = 0;
+  return failures;
+}
+
+/// Check a condition, print the location and continue with the test if it's false.
+#define TEST_CHECK(cond) \
+  do { \
+    if (!(cond)) { \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      unit_test_failures()++; \
+    } \
+  } while (0)
+
+/// Return the exit code of the test executable.
+inline int unit_test_result() {
+  if (unit_test_failures() != 0)
+    fprintf(stderr, "%d check(s) failed\n", unit_test_failures());
+  return unit_test_failures() == 0 ? 0 : 1;
+}
+
+#endif //ESPHOMELIB_TESTS_UNIT_TEST_H